@@ -15,8 +15,13 @@ layout (location = 2) in vec2 inTexCoord;
 
 layout (location = 0) out vec2 texcoord;
 
+layout(push_constant) uniform PushConstantVert{
+	vec2 textureScale;	//How much of the screen textures were rendered into
+};
+
 void main() {
    texcoord 	= inTexCoord;
    texcoord.y = 1.0f - inTexCoord.y;
+   texcoord   *= textureScale;
    gl_Position 	= vec4(inPosition,1);
 }
@@ -23,7 +23,8 @@ layout (set = 2, binding  = 0) uniform LightStageUBO
 	mat4	inverseProjView;	
 	vec3	cameraPosition;
 	float	scrap; //Maintains Alignment
-	vec2	resolution;
+	vec2	resolution;		//1 / the size of the viewport
+	vec2	textureScale;	//How much of the G-Buffer the viewport covers
 };
 
 layout (location = 0) in flat int lightIndex;
@@ -35,7 +36,7 @@ layout (location = 0) out vec4 diffuseColour;
 layout (location = 1) out vec4 specularColour;
 
 void main() {
-	vec2 texCoord	= gl_FragCoord.xy * resolution.xy;
+	vec2 texCoord	= gl_FragCoord.xy * resolution.xy * textureScale;
 
 	vec3 worldBump		= normalize(texture(bumpTex , texCoord).xyz * 2 - 1); 
 	float depthSample	= texture(depthTex, texCoord).r;
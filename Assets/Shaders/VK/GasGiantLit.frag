@@ -0,0 +1,26 @@
+#version 450
+#extension GL_ARB_separate_shader_objects  : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+//Displays a planet lit by a single directional light, using the normal map written by GasGiantTexSurface.comp
+
+layout (set = 0, binding = 1) uniform sampler2D image;
+
+layout (set = 1, binding = 0) uniform sampler2D normalMap;
+
+layout(push_constant) uniform pConsts
+{
+    vec3 lightDirection;    //towards the light, in texture space with z out of the surface
+};
+
+layout (location = 0) in vec2 texCoord;
+
+layout (location = 0) out vec4 fragColor;
+
+void main() {
+    vec3 albedo     = texture(image, texCoord).rgb;
+    vec3 normal     = normalize(texture(normalMap, texCoord).xyz * 2.0 - 1.0);
+    float diffuse   = max(dot(normal, normalize(lightDirection)), 0.0);
+
+    fragColor = vec4(albedo * (0.25 + 0.75 * diffuse), 1.0);
+}
@@ -0,0 +1,64 @@
+#version 450
+#extension GL_ARB_separate_shader_objects  : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+//Samples a zoomed view of a planet through the tile indirection table.
+//Tiles missing at the requested level fall back to the closest coarser resident level
+
+layout (set = 0, binding = 0) uniform sampler2D atlas;
+
+layout (set = 0, binding = 1) buffer readonly indirection
+{
+    int tileSlots[];
+};
+
+layout(push_constant) uniform pConsts
+{
+    vec2  viewMin;      //planet uv at the top left of the screen
+    vec2  viewSize;     //planet uv covered by the screen
+    ivec2 baseSize;     //planet texture size at zoom level 0
+    int   level;
+    int   tileSize;
+    int   atlasTiles;   //atlas slots along one side
+};
+
+layout (location = 0) in vec2 texCoord;
+
+layout (location = 0) out vec4 fragColor;
+
+void main() {
+    vec2 planetUV = viewMin + texCoord * viewSize;
+
+    if(any(lessThan(planetUV, vec2(0.0))) || any(greaterThanEqual(planetUV, vec2(1.0)))) {
+        fragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    //the table stores every level's tile grid back to back, so accumulate the offset of the levels below
+    int levelOffsets[16];
+    int offset = 0;
+    for(int l = 0; l <= level; ++l) {
+        ivec2 tiles = ((baseSize << l) + tileSize - 1) / tileSize;
+        levelOffsets[l] = offset;
+        offset += tiles.x * tiles.y;
+    }
+
+    for(int l = level; l >= 0; --l) {
+        ivec2 virtualSize   = baseSize << l;
+        ivec2 tiles         = (virtualSize + tileSize - 1) / tileSize;
+        vec2  virtualTexel  = planetUV * vec2(virtualSize);
+        ivec2 tile          = min(ivec2(virtualTexel) / tileSize, tiles - 1);
+
+        int slot = tileSlots[levelOffsets[l] + tile.y * tiles.x + tile.x];
+        if(slot < 0) {
+            continue;
+        }
+        //Stay half a texel inside the slot so bilinear filtering never picks up a neighbouring tile
+        vec2 inTile     = clamp(virtualTexel - vec2(tile * tileSize), vec2(0.5), vec2(tileSize - 0.5));
+        vec2 slotOrigin = vec2(slot % atlasTiles, slot / atlasTiles) * tileSize;
+
+        fragColor = texture(atlas, (slotOrigin + inTile) / vec2(textureSize(atlas, 0)));
+        return;
+    }
+    fragColor = vec4(0.0, 0.0, 0.0, 1.0);
+}
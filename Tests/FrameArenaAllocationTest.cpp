@@ -0,0 +1,150 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanFrameArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+/*
+Checks that once a FrameArena has grown to fit a frame, frames that use it
+never touch the heap. Every operator new in the program is replaced with
+one that counts, and the count has to stay at 0 once the warm up frames
+are done.
+*/
+namespace {
+	std::atomic<bool>		counting	= false;
+	std::atomic<uint64_t>	heapAllocations = 0;
+
+	void* CountedAlloc(size_t bytes, size_t alignment) {
+		if (counting) {
+			heapAllocations++;
+		}
+		bytes = std::max<size_t>(bytes, 1);
+		if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			return std::malloc(bytes);
+		}
+		bytes = (bytes + alignment - 1) / alignment * alignment;
+#ifdef _MSC_VER
+		return _aligned_malloc(bytes, alignment);
+#else
+		return std::aligned_alloc(alignment, bytes);
+#endif
+	}
+
+	void CountedFree(void* p, [[maybe_unused]] size_t alignment) {
+#ifdef _MSC_VER
+		if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			_aligned_free(p);
+			return;
+		}
+#endif
+		std::free(p);
+	}
+
+	struct alignas(64) Joint {
+		float matrix[16];
+	};
+
+	//Roughly what a frame builds up while recording - a few arrays that change size a little each frame
+	size_t RecordFrame(FrameArena& arena, uint32_t frame) {
+		std::pmr::vector<Joint>		joints(100 + frame % 7, &arena);
+		std::pmr::vector<uint32_t>	drawIndices(&arena);
+		for (uint32_t i = 0; i < 5000 + frame % 13; ++i) {
+			drawIndices.push_back(i);	//Grows a few times, leaving the smaller copies behind in the arena
+		}
+		std::pmr::string name("Frame scratch data that's too long for the small string buffer", &arena);
+
+		return joints.size() + drawIndices.size() + name.size();
+	}
+}
+
+void* operator new(size_t bytes) {
+	void* p = CountedAlloc(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void* operator new(size_t bytes, std::align_val_t alignment) {
+	void* p = CountedAlloc(bytes, (size_t)alignment);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+	return CountedAlloc(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return CountedAlloc(bytes, (size_t)alignment);
+}
+void* operator new[](size_t bytes) {
+	return operator new(bytes);
+}
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+	return operator new(bytes, alignment);
+}
+
+void operator delete(void* p) noexcept {
+	CountedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void operator delete(void* p, size_t) noexcept {
+	CountedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void operator delete(void* p, std::align_val_t alignment) noexcept {
+	CountedFree(p, (size_t)alignment);
+}
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept {
+	CountedFree(p, (size_t)alignment);
+}
+void operator delete[](void* p) noexcept {
+	CountedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void operator delete[](void* p, size_t) noexcept {
+	CountedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void operator delete[](void* p, std::align_val_t alignment) noexcept {
+	CountedFree(p, (size_t)alignment);
+}
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept {
+	CountedFree(p, (size_t)alignment);
+}
+
+int main() {
+	const uint32_t warmUpFrames = 4;
+	const uint32_t testFrames	= 1000;
+
+	//Far too small to start with, so the warm up frames have to overflow and grow it
+	FrameArena arena(1024);
+	size_t checksum = 0;
+
+	for (uint32_t frame = 0; frame < warmUpFrames + testFrames; ++frame) {
+		arena.Reset();
+		counting = frame >= warmUpFrames;
+		checksum += RecordFrame(arena, frame);
+	}
+	counting = false;
+
+	if (arena.GetOverflowBytes() > 0 || heapAllocations > 0) {
+		std::cout << "FAILED: " << heapAllocations << " heap allocations, " << arena.GetOverflowBytes()
+			<< " bytes overflowed in the last frame, over " << testFrames << " frames after warm up\n";
+		return 1;
+	}
+	std::cout << "Passed: no heap allocations in " << testFrames << " frames, arena grew to "
+		<< arena.GetCapacity() << " bytes (checksum " << checksum << ")\n";
+	return 0;
+}
@@ -47,7 +47,7 @@ TestGLTFRayTrace::TestGLTFRayTrace(Window& window) : VulkanTutorial(window) {
 
 	FrameState const& state = renderer->GetFrameState();
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	GLTFLoader::Load("Sponza/Sponza.gltf",scene);
 
@@ -85,15 +85,14 @@ TestGLTFRayTrace::TestGLTFRayTrace(Window& window) : VulkanTutorial(window) {
 	}
 	 
 	tlas = bvhBuilder
-		.WithCommandQueue(renderer->GetQueue(CommandBuffer::AsyncCompute))
-		.WithCommandPool(renderer->GetCommandPool(CommandBuffer::AsyncCompute)) 
+		.UsingContext(renderer->GetImmediateContext(CommandBuffer::AsyncCompute))
 		.WithDevice(device)
 		.WithAllocator(renderer->GetMemoryAllocator())
 		.Build(vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace, "GLTF BLAS");
 
-	rayTraceDescriptor		= CreateDescriptorSet(device, pool, *rayTraceLayout);
-	imageDescriptor			= CreateDescriptorSet(device, pool, *imageLayout);
-	inverseCamDescriptor	= CreateDescriptorSet(device, pool, *inverseCamLayout);
+	rayTraceDescriptor		= descriptorAllocator.Allocate(*rayTraceLayout);
+	imageDescriptor			= descriptorAllocator.Allocate(*imageLayout);
+	inverseCamDescriptor	= descriptorAllocator.Allocate(*inverseCamLayout);
 
 	inverseMatrices = BufferBuilder(device, renderer->GetMemoryAllocator())
 		.WithBufferUsage(vk::BufferUsageFlagBits::eUniformBuffer)
@@ -146,7 +145,7 @@ TestGLTFRayTrace::TestGLTFRayTrace(Window& window) : VulkanTutorial(window) {
 		.WithImageSamplers(0, 1, vk::ShaderStageFlagBits::eFragment)
 		.Build("Raster Image Layout");
 
-	displayImageDescriptor = CreateDescriptorSet(device , pool, *displayImageLayout);
+	displayImageDescriptor = descriptorAllocator.Allocate(*displayImageLayout);
 	WriteImageDescriptor(device, *displayImageDescriptor, 0, *rayTexture, *defaultSampler, vk::ImageLayout::eShaderReadOnlyOptimal);
 
 	quadMesh = GenerateQuad();
@@ -184,7 +183,7 @@ void TestGLTFRayTrace::RenderFrame(float dt) {
 
 	vk::DescriptorSet sets[4] = {
 		*rayTraceDescriptor,		//Set 0
-		*cameraDescriptor,			//Set 1
+		cameraDescriptor,			//Set 1
 		*inverseCamDescriptor,		//Set 2
 		*imageDescriptor			//Set 3
 	};
@@ -73,8 +73,7 @@ using namespace Vulkan;
 //
 //	tlas = bvhBuilder
 //		.WithObject(&*triangle, Matrix::Translation(Vector3{ 0,0,-100.0f }) * Matrix::Scale(Vector3{2,4,2}))
-//		.WithCommandQueue(renderer->GetQueue(CommandBuffer::AsyncCompute))
-//		.WithCommandPool(renderer->GetCommandPool(CommandBuffer::AsyncCompute))
+//		.UsingContext(renderer->GetImmediateContext(CommandBuffer::AsyncCompute))
 //		.WithDevice(device)
 //		.WithAllocator(renderer->GetMemoryAllocator())
 //		.Build(vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace, "Test TLAS");
@@ -93,8 +93,7 @@ using namespace Vulkan;
 //	}
 //
 //	tlas = bvhBuilder
-//		.WithCommandQueue(renderer->GetQueue(CommandBuffer::AsyncCompute))
-//		.WithCommandPool(renderer->GetCommandPool(CommandBuffer::AsyncCompute)) 
+//		.UsingContext(renderer->GetImmediateContext(CommandBuffer::AsyncCompute))
 //		.WithDevice(device)
 //		.WithAllocator(renderer->GetMemoryAllocator())
 //		.Build(vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace, "GLTF BLAS");
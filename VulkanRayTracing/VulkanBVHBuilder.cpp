@@ -45,13 +45,13 @@ VulkanBVHBuilder& VulkanBVHBuilder::WithObject(VulkanMesh* m, const Matrix4& tra
 	return *this;
 }
 
-VulkanBVHBuilder& VulkanBVHBuilder::WithCommandQueue(vk::Queue inQueue) {
-	queue = inQueue;
+VulkanBVHBuilder& VulkanBVHBuilder::UsingContext(ImmediateContext& inContext) {
+	context = &inContext;
 	return *this;
 }
 
-VulkanBVHBuilder& VulkanBVHBuilder::WithCommandPool(vk::CommandPool inPool) {
-	pool = inPool;
+VulkanBVHBuilder& VulkanBVHBuilder::WithScratchMemory(std::pmr::memory_resource* inScratch) {
+	scratchMemory = inScratch;
 	return *this;
 }
 
@@ -66,6 +66,7 @@ VulkanBVHBuilder& VulkanBVHBuilder::WithAllocator(VmaAllocator inAllocator) {
 }
 
 vk::UniqueAccelerationStructureKHR VulkanBVHBuilder::Build(vk::BuildAccelerationStructureFlagsKHR inFlags, const std::string& debugName) {
+	assert(MessageAssert(context != nullptr, "BVH builder needs a context to submit the builds through!"));
 	BuildBLAS(sourceDevice, sourceAllocator, inFlags);
 	BuildTLAS(sourceDevice, sourceAllocator, inFlags);
 
@@ -158,11 +159,12 @@ void VulkanBVHBuilder::BuildBLAS(vk::Device device, VmaAllocator allocator, vk::
 	VulkanBuffer scratchBuff = BufferBuilder(device, allocator)
 		.WithBufferUsage(	vk::BufferUsageFlagBits::eShaderDeviceAddress | 
 							vk::BufferUsageFlagBits::eStorageBuffer)
+		.WithMemoryCategory(MemoryCategory::AccelerationStructures)
 		.Build(scratchSize, "Scratch Buffer");
 
 	vk::DeviceAddress scratchAddr = device.getBufferAddress({ .buffer = scratchBuff.buffer });
 
-	vk::UniqueCommandBuffer buffer = CmdBufferBegin(device, pool, "Making BLAS");
+	vk::CommandBuffer buffer = context->Begin("Making BLAS");
 
 	for (auto& i : blasBuildInfo) {		//Make the buffer for each blas entry...
 		vk::AccelerationStructureCreateInfoKHR createInfo;
@@ -184,9 +186,9 @@ void VulkanBVHBuilder::BuildBLAS(vk::Device device, VmaAllocator allocator, vk::
 
 		const vk::AccelerationStructureBuildRangeInfoKHR* rangeInfo = i.ranges.data();
 
-		buffer->buildAccelerationStructuresKHR(1, &i.buildInfo, &rangeInfo);
+		buffer.buildAccelerationStructuresKHR(1, &i.buildInfo, &rangeInfo);
 					
-		buffer->pipelineBarrier(
+		buffer.pipelineBarrier(
 			vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, //Source
 			vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, //Dest
 			{}, //Dependency Flags
@@ -200,11 +202,12 @@ void VulkanBVHBuilder::BuildBLAS(vk::Device device, VmaAllocator allocator, vk::
 			{} //imageMemoryBarriers
 		);
 	}
-	CmdBufferEndSubmitWait(*buffer, device, queue);
+	//The scratch buffer is freed on return
+	context->SubmitWait();
 }
 
 void VulkanBVHBuilder::BuildTLAS(vk::Device device, VmaAllocator allocator, vk::BuildAccelerationStructureFlagsKHR flags) {
-	std::vector<vk::AccelerationStructureInstanceKHR> tlasEntries;
+	std::pmr::vector<vk::AccelerationStructureInstanceKHR> tlasEntries(scratchMemory);
 
 	const uint32_t instanceCount = entries.size();
 
@@ -283,6 +286,7 @@ void VulkanBVHBuilder::BuildTLAS(vk::Device device, VmaAllocator allocator, vk::
 							vk::BufferUsageFlagBits::eStorageBuffer)
 		.WithHostVisibility()
 		.WithDeviceAddress()
+		.WithMemoryCategory(MemoryCategory::AccelerationStructures)
 		.Build(sizesInfo.buildScratchSize, "Scratch Buffer");
 
 	vk::DeviceAddress scratchAddr = device.getBufferAddress({ .buffer = scratchBuffer.buffer });
@@ -296,7 +300,7 @@ void VulkanBVHBuilder::BuildTLAS(vk::Device device, VmaAllocator allocator, vk::
 
 	vk::AccelerationStructureBuildRangeInfoKHR* rangeInfoPtr = &rangeInfo;
 
-	vk::UniqueCommandBuffer cmdBuffer = CmdBufferBegin(device, pool, "Making TLAS");
-	cmdBuffer->buildAccelerationStructuresKHR(1, &geomInfo, &rangeInfoPtr);
-	CmdBufferEndSubmitWait(*cmdBuffer, device, queue);
+	vk::CommandBuffer cmdBuffer = context->Begin("Making TLAS");
+	cmdBuffer.buildAccelerationStructuresKHR(1, &geomInfo, &rangeInfoPtr);
+	context->SubmitWait();
 }
\ No newline at end of file
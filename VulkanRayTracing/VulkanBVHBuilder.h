@@ -38,8 +38,11 @@ namespace NCL::Rendering::Vulkan {
 
 		VulkanBVHBuilder& WithDevice(vk::Device inDevice);
 		VulkanBVHBuilder& WithAllocator(VmaAllocator inAllocator);
-		VulkanBVHBuilder& WithCommandQueue(vk::Queue inQueue);
-		VulkanBVHBuilder& WithCommandPool(vk::CommandPool inPool);
+		//The builds are submitted through this, and waited on before Build returns
+		VulkanBVHBuilder& UsingContext(ImmediateContext& inContext);
+		//Where the build's temporary CPU arrays come from, the default heap unless set. A TLAS rebuilt every
+		//frame can use the renderer's FrameArena, as nothing is kept past the end of Build
+		VulkanBVHBuilder& WithScratchMemory(std::pmr::memory_resource* inScratch);
 
 		vk::UniqueAccelerationStructureKHR Build(vk::BuildAccelerationStructureFlagsKHR flags, const std::string& debugName = "");
 	protected:
@@ -56,11 +59,12 @@ namespace NCL::Rendering::Vulkan {
 		std::vector<Matrix4>		transforms;
 		std::vector< BLASEntry>		blasBuildInfo;
 
-		vk::Queue		queue;
-		vk::CommandPool pool;
+		ImmediateContext*	context = nullptr;
 		vk::Device		sourceDevice;
 		VmaAllocator	sourceAllocator;
 
+		std::pmr::memory_resource* scratchMemory = std::pmr::get_default_resource();
+
 		vk::UniqueAccelerationStructureKHR	tlas;
 		VulkanBuffer						tlasBuffer;
 	};
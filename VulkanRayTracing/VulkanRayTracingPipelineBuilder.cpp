@@ -115,7 +115,7 @@ VulkanPipeline VulkanRayTracingPipelineBuilder::Build(const std::string& debugNa
 	pipelineCreate.layout = *output.layout;
 	pipelineCreate.setPDynamicState(&dynamicCreate);
 
-	output.pipeline = sourceDevice.createRayTracingPipelineKHRUnique({}, cache, pipelineCreate).value;
+	output.pipeline = sourceDevice.createRayTracingPipelineKHRUnique({}, ResolvePipelineCache(cache), pipelineCreate).value;
 
 	if (!debugName.empty()) {
 		SetDebugName(sourceDevice, vk::ObjectType::ePipeline, GetVulkanHandle(*output.pipeline), debugName);
@@ -18,6 +18,7 @@ BufferBuilder::BufferBuilder(vk::Device device, VmaAllocator allocator) {
 	sourceAllocator = allocator;
 	vmaInfo = {};
 	vmaInfo.usage		= VMA_MEMORY_USAGE_AUTO;
+	category			= MemoryCategory::MAX_CATEGORIES;
 }
 
 BufferBuilder::BufferBuilder(VkDevice device, VmaAllocator allocator) {
@@ -25,6 +26,7 @@ BufferBuilder::BufferBuilder(VkDevice device, VmaAllocator allocator) {
 	sourceAllocator = allocator;
 	vmaInfo = {};
 	vmaInfo.usage = VMA_MEMORY_USAGE_AUTO;
+	category = MemoryCategory::MAX_CATEGORIES;
 }
 
 BufferBuilder& BufferBuilder::WithBufferUsage(vk::BufferUsageFlags flags) {
@@ -71,6 +73,11 @@ BufferBuilder& BufferBuilder::WithUniqueAllocation() {
 	return *this;
 }
 
+BufferBuilder& BufferBuilder::WithMemoryCategory(MemoryCategory c) {
+	category = c;
+	return *this;
+}
+
 VulkanBuffer BufferBuilder::Build(size_t byteSize, const std::string& debugName) {
 	VulkanBuffer	outputBuffer;
 
@@ -92,7 +99,25 @@ VulkanBuffer BufferBuilder::Build(size_t byteSize, const std::string& debugName)
 
 	if (!debugName.empty()) {
 		SetDebugName(sourceDevice, vk::ObjectType::eBuffer, GetVulkanHandle(outputBuffer.buffer), debugName);
+		vmaSetAllocationName(sourceAllocator, outputBuffer.allocationHandle, debugName.c_str());
+	}
+
+	MemoryCategory trackAs = category;
+	if (trackAs == MemoryCategory::MAX_CATEGORIES) {
+		if (vkInfo.usage & (vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderBindingTableKHR)) {
+			trackAs = MemoryCategory::AccelerationStructures;
+		}
+		else if (vkInfo.usage & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer)) {
+			trackAs = MemoryCategory::Meshes;
+		}
+		else if (vkInfo.usage == vk::BufferUsageFlagBits::eTransferSrc) {
+			trackAs = MemoryCategory::Staging;
+		}
+		else {
+			trackAs = MemoryCategory::Other;
+		}
 	}
+	TrackAllocation(sourceAllocator, outputBuffer.allocationHandle, trackAs);
 
 	return outputBuffer;
 }
\ No newline at end of file
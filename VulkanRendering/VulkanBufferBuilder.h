@@ -33,6 +33,9 @@ namespace NCL::Rendering::Vulkan {
 		//Indicates to VMA that a new physical memory allocation must be made
 		BufferBuilder& WithUniqueAllocation();
 
+		//What the memory stats count the buffer as. If not set, it's worked out from the usage flags
+		BufferBuilder& WithMemoryCategory(MemoryCategory category);
+
 		~BufferBuilder() {};
 
 		VulkanBuffer Build(size_t byteSize, const std::string& name = "");
@@ -42,5 +45,6 @@ namespace NCL::Rendering::Vulkan {
 		VmaAllocator sourceAllocator;
 		VmaAllocationCreateInfo vmaInfo;
 		vk::BufferCreateInfo	vkInfo;
+		MemoryCategory			category;
 	};
 }
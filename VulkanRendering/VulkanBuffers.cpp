@@ -6,6 +6,7 @@ Contact:richgdavison@gmail.com
 License: MIT (see LICENSE file at the top of the source tree)
 *//////////////////////////////////////////////////////////////////////////////
 #include "VulkanBuffers.h"
+#include "VulkanFrameCounters.h"
 
 using namespace NCL;
 using namespace Rendering;
@@ -23,6 +24,7 @@ void VulkanBuffer::CopyData(void* data, size_t size) {
 		memcpy(mappedData, data, size);
 		vmaUnmapMemory(allocator, allocationHandle);
 	}
+	AddToFrameCounter(FrameCounter::BytesUploaded, size);
 }
 
 void* VulkanBuffer::Map() {
@@ -7,6 +7,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "vma/vk_mem_alloc.h"
+#include "VulkanMemoryStats.h"
 
 namespace NCL::Rendering::Vulkan {
 	//A buffer, backed by memory we have allocated elsewhere
@@ -53,6 +54,7 @@ namespace NCL::Rendering::Vulkan {
 
 		~VulkanBuffer() {
 			if (buffer) {
+				UntrackAllocation(allocationHandle);
 				vmaDestroyBuffer(allocator, buffer, allocationHandle);
 			}
 		}
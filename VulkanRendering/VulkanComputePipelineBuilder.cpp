@@ -8,6 +8,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "VulkanComputePipelineBuilder.h"
 #include "VulkanCompute.h"
 #include "VulkanUtils.h"
+#include "VulkanProfiler.h"
 
 using namespace NCL;
 using namespace Rendering;
@@ -32,6 +33,7 @@ ComputePipelineBuilder& ComputePipelineBuilder::WithShader(const VulkanCompute&
 }
 
 VulkanPipeline	ComputePipelineBuilder::Build(const std::string& debugName, vk::PipelineCache cache) {
+	PROFILE_SCOPE("ComputePipelineBuilder::Build", debugName);
 	VulkanPipeline output;
 
 	FinaliseDescriptorLayouts();
@@ -46,7 +48,7 @@ VulkanPipeline	ComputePipelineBuilder::Build(const std::string& debugName, vk::P
 
 	pipelineCreate.setLayout(*output.layout);
 
-	output.pipeline = sourceDevice.createComputePipelineUnique(cache, pipelineCreate).value;
+	output.pipeline = sourceDevice.createComputePipelineUnique(ResolvePipelineCache(cache), pipelineCreate).value;
 
 	if (!debugName.empty()) {
 		SetDebugName(sourceDevice, vk::ObjectType::ePipeline, GetVulkanHandle(*output.pipeline), debugName);
@@ -0,0 +1,206 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanUtils.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+static const vk::DescriptorType defaultTypes[] = {
+	vk::DescriptorType::eUniformBuffer,
+	vk::DescriptorType::eStorageBuffer,
+	vk::DescriptorType::eUniformBufferDynamic,
+	vk::DescriptorType::eStorageBufferDynamic,
+
+	vk::DescriptorType::eCombinedImageSampler,
+	vk::DescriptorType::eSampledImage,
+	vk::DescriptorType::eStorageImage,
+#ifdef USE_RAY_TRACING
+	vk::DescriptorType::eAccelerationStructureKHR,
+#endif
+};
+
+static vk::DescriptorPool CreatePool(vk::Device device, uint32_t maxSets, const std::map<vk::DescriptorType, uint32_t>& counts, vk::DescriptorPoolCreateFlags flags) {
+	std::vector<vk::DescriptorPoolSize> poolSizes;
+	for (const auto& [type, count] : counts) {
+		poolSizes.push_back({ type, count });
+	}
+	vk::DescriptorPoolCreateInfo poolCreate;
+	poolCreate.setPoolSizes(poolSizes);
+	poolCreate.setMaxSets(maxSets);
+	poolCreate.setFlags(flags);
+
+	return device.createDescriptorPool(poolCreate);
+}
+
+//Each new pool doubles in size, up to this many times the first
+const uint32_t MAX_POOL_GROWTH = 16;
+
+DescriptorAllocator::DescriptorAllocator(vk::Device device, uint32_t setsPerPool) {
+	this->device		= device;
+	this->setsPerPool	= setsPerPool;
+	setsAllocated		= 0;
+
+	//Nothing's been allocated yet, so the first pool has room for setsPerPool of every type
+	std::map<vk::DescriptorType, uint32_t> counts;
+	for (vk::DescriptorType t : defaultTypes) {
+		counts[t] = setsPerPool;
+	}
+	pools.push_back(CreatePool(device, setsPerPool * (uint32_t)std::size(defaultTypes), counts, vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet));
+}
+
+DescriptorAllocator::~DescriptorAllocator() {
+	for (vk::DescriptorPool p : pools) {
+		device.destroyDescriptorPool(p);
+	}
+}
+
+vk::UniqueDescriptorSet DescriptorAllocator::Allocate(vk::DescriptorSetLayout layout, uint32_t variableDescriptorCount, const std::string& debugName) {
+	if (const std::vector<vk::DescriptorPoolSize>* sizes = GetDescriptorSetLayoutSizes(layout)) {
+		for (const auto& s : *sizes) {
+			typeUsage[s.type] += s.descriptorCount;
+		}
+	}
+	setsAllocated++;
+
+	vk::DescriptorSetAllocateInfo allocateInfo = {
+		.descriptorSetCount = 1,
+		.pSetLayouts		= &layout
+	};
+	vk::DescriptorSetVariableDescriptorCountAllocateInfoEXT variableDescriptorInfo;
+	if (variableDescriptorCount > 0) {
+		variableDescriptorInfo.setDescriptorSetCount(1).setPDescriptorCounts(&variableDescriptorCount);
+		allocateInfo.setPNext((const void*)&variableDescriptorInfo);
+	}
+
+	vk::DescriptorSet	set;
+	vk::DescriptorPool	fromPool;
+	//Newest pool first, it's the one most likely to have room, then any older ones that have had sets freed back to them
+	for (auto p = pools.rbegin(); p != pools.rend() && !fromPool; ++p) {
+		allocateInfo.descriptorPool = *p;
+		vk::Result result = device.allocateDescriptorSets(&allocateInfo, &set);
+		if (result == vk::Result::eSuccess) {
+			fromPool = *p;
+		}
+		else if (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool) {
+			std::cout << __FUNCTION__ << " Failed to allocate descriptor set: " << vk::to_string(result) << "\n";
+			return {};
+		}
+	}
+	if (!fromPool) {
+		pools.push_back(CreateGrownPool(layout));
+		allocateInfo.descriptorPool = pools.back();
+		vk::Result result = device.allocateDescriptorSets(&allocateInfo, &set);
+		if (result != vk::Result::eSuccess) {
+			std::cout << __FUNCTION__ << " Failed to allocate descriptor set from a new pool: " << vk::to_string(result) << "\n";
+			return {};
+		}
+		fromPool = pools.back();
+	}
+	if (!debugName.empty()) {
+		SetDebugName(device, vk::ObjectType::eDescriptorSet, GetVulkanHandle(set), debugName);
+	}
+	return vk::UniqueDescriptorSet(set, vk::PoolFree<vk::Device, vk::DescriptorPool, VULKAN_HPP_DEFAULT_DISPATCHER_TYPE>(device, fromPool));
+}
+
+vk::DescriptorPool DescriptorAllocator::CreateGrownPool(vk::DescriptorSetLayout forLayout) {
+	uint32_t maxSets = setsPerPool * std::min(1u << std::min((uint32_t)pools.size(), 31u), MAX_POOL_GROWTH);
+
+	//A few of every type, in case something new turns up, then whatever the sets so far have averaged
+	std::map<vk::DescriptorType, uint32_t> counts;
+	for (vk::DescriptorType t : defaultTypes) {
+		counts[t] = std::max(maxSets / 8, 1u);
+	}
+	for (const auto& [type, total] : typeUsage) {
+		uint32_t expected = (uint32_t)((total * maxSets + setsAllocated - 1) / setsAllocated);
+		counts[type] = std::max(counts[type], expected);
+	}
+	//However it's sized, the set that didn't fit last time has to fit now
+	if (const std::vector<vk::DescriptorPoolSize>* sizes = GetDescriptorSetLayoutSizes(forLayout)) {
+		for (const auto& s : *sizes) {
+			counts[s.type] = std::max(counts[s.type], s.descriptorCount);
+		}
+	}
+	std::cout << __FUNCTION__ << " Descriptor pool " << pools.size() << " full, adding a pool of " << maxSets << " sets\n";
+	return CreatePool(device, maxSets, counts, vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
+}
+
+FrameDescriptorAllocator::FrameDescriptorAllocator(vk::Device device, uint32_t framesInFlight, uint32_t setsPerPool) {
+	this->device		= device;
+	this->setsPerPool	= setsPerPool;
+	currentFrame		= 0;
+	frames.resize(framesInFlight);
+}
+
+FrameDescriptorAllocator::~FrameDescriptorAllocator() {
+	for (FramePools& f : frames) {
+		for (vk::DescriptorPool p : f.pools) {
+			device.destroyDescriptorPool(p);
+		}
+	}
+}
+
+void FrameDescriptorAllocator::BeginFrame(uint32_t frameIndex) {
+	currentFrame = frameIndex;
+	FramePools& f = frames[currentFrame];
+	//The pools are kept, so after the first few frames nothing new is ever created
+	for (vk::DescriptorPool p : f.pools) {
+		device.resetDescriptorPool(p);
+	}
+	f.current = 0;
+}
+
+vk::DescriptorSet FrameDescriptorAllocator::Allocate(vk::DescriptorSetLayout layout, uint32_t variableDescriptorCount) {
+	FramePools& f = frames[currentFrame];
+
+	vk::DescriptorSetAllocateInfo allocateInfo = {
+		.descriptorSetCount = 1,
+		.pSetLayouts		= &layout
+	};
+	vk::DescriptorSetVariableDescriptorCountAllocateInfoEXT variableDescriptorInfo;
+	if (variableDescriptorCount > 0) {
+		variableDescriptorInfo.setDescriptorSetCount(1).setPDescriptorCounts(&variableDescriptorCount);
+		allocateInfo.setPNext((const void*)&variableDescriptorInfo);
+	}
+
+	vk::DescriptorSet set;
+	//Earlier pools are full, so only the current one, and then the ones after it, are worth trying
+	while (true) {
+		bool newPool = f.current == f.pools.size();
+		if (newPool) {
+			f.pools.push_back(CreatePool(layout));
+		}
+		allocateInfo.descriptorPool = f.pools[f.current];
+		vk::Result result = device.allocateDescriptorSets(&allocateInfo, &set);
+		if (result == vk::Result::eSuccess) {
+			return set;
+		}
+		if (newPool || (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool)) {
+			std::cout << __FUNCTION__ << " Failed to allocate descriptor set: " << vk::to_string(result) << "\n";
+			return {};
+		}
+		f.current++;
+	}
+}
+
+vk::DescriptorPool FrameDescriptorAllocator::CreatePool(vk::DescriptorSetLayout forLayout) {
+	std::map<vk::DescriptorType, uint32_t> counts;
+	for (vk::DescriptorType t : defaultTypes) {
+		counts[t] = setsPerPool;
+	}
+	if (const std::vector<vk::DescriptorPoolSize>* sizes = GetDescriptorSetLayoutSizes(forLayout)) {
+		for (const auto& s : *sizes) {
+			counts[s.type] = std::max(counts[s.type], s.descriptorCount);
+		}
+	}
+	//No flags, sets from these pools are never freed individually
+	return ::CreatePool(device, setsPerPool * (uint32_t)std::size(defaultTypes), counts, {});
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace NCL::Rendering::Vulkan {
+	/*
+	DescriptorAllocator: Hands out descriptor sets from a list of pools,
+	instead of a single fixed size one. When every pool is full, a new one
+	is made, sized from the mix of descriptor types allocated so far, and
+	bigger than the last. Sets are returned to their pool when the unique
+	handle goes out of scope, and the space is reused by later allocations.
+	*/
+	class DescriptorAllocator	{
+	public:
+		DescriptorAllocator(vk::Device device, uint32_t setsPerPool = 128);
+		~DescriptorAllocator();
+
+		vk::UniqueDescriptorSet Allocate(vk::DescriptorSetLayout layout, uint32_t variableDescriptorCount = 0, const std::string& debugName = "");
+
+		uint32_t GetPoolCount() const {
+			return (uint32_t)pools.size();
+		}
+
+	protected:
+		vk::DescriptorPool CreateGrownPool(vk::DescriptorSetLayout forLayout);
+
+		vk::Device		device;
+		uint32_t		setsPerPool;
+
+		std::vector<vk::DescriptorPool>				pools;
+		//Totals of everything allocated so far, new pools get the same proportions
+		std::map<vk::DescriptorType, uint64_t>		typeUsage;
+		uint64_t									setsAllocated;
+	};
+
+	/*
+	FrameDescriptorAllocator: For sets that are only needed for the frame
+	they're made in. Each frame in flight has its own pools, which sets are
+	taken from in order, and which are reset all at once when that frame
+	comes round again, so there's nothing to free and a set is never
+	rewritten while the GPU might still be reading it.
+	BeginFrame must only be called once the frame's fence has signalled -
+	VulkanRenderer does this in BeginFrame.
+	*/
+	class FrameDescriptorAllocator	{
+	public:
+		FrameDescriptorAllocator(vk::Device device, uint32_t framesInFlight, uint32_t setsPerPool = 64);
+		~FrameDescriptorAllocator();
+
+		void BeginFrame(uint32_t frameIndex);
+
+		//Only valid until this frame index comes round again
+		vk::DescriptorSet Allocate(vk::DescriptorSetLayout layout, uint32_t variableDescriptorCount = 0);
+
+	protected:
+		struct FramePools {
+			std::vector<vk::DescriptorPool>	pools;
+			size_t							current = 0;
+		};
+		vk::DescriptorPool CreatePool(vk::DescriptorSetLayout forLayout);
+
+		vk::Device		device;
+		uint32_t		setsPerPool;
+
+		std::vector<FramePools>	frames;
+		uint32_t				currentFrame;
+	};
+}
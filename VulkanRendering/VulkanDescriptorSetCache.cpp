@@ -0,0 +1,65 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanDescriptorSetCache.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanUtils.h"
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+DescriptorSetCache::DescriptorSetCache(DescriptorAllocator& allocator) : allocator(allocator) {
+	hitCount = 0;
+}
+
+DescriptorSetCache::~DescriptorSetCache() {
+}
+
+vk::DescriptorSet DescriptorSetCache::Get(vk::DescriptorSetLayout layout, const std::vector<DescriptorWrite>& bindings, DescriptorSetWriter& writer, const std::string& debugName) {
+	Key key = { layout, bindings };
+
+	auto i = sets.find(key);
+	if (i != sets.end()) {
+		hitCount++;
+		return *i->second;
+	}
+	vk::UniqueDescriptorSet set = allocator.Allocate(layout, 0, debugName);
+	if (!set) {
+		return {};
+	}
+	for (const DescriptorWrite& w : bindings) {
+		writer.Write(*set, w);
+	}
+	vk::DescriptorSet result = *set;
+	sets.emplace(std::move(key), std::move(set));
+	return result;
+}
+
+void DescriptorSetCache::Clear() {
+	sets.clear();
+	hitCount = 0;
+}
+
+size_t DescriptorSetCache::KeyHash::operator()(const Key& k) const {
+	size_t hash = 0;
+	auto combine = [&](uint64_t v) {
+		hash ^= std::hash<uint64_t>()(v) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	};
+	combine(GetVulkanHandle(k.layout));
+	for (const DescriptorWrite& w : k.bindings) {
+		combine(((uint64_t)w.binding << 32) | w.arrayElement);
+		combine((uint64_t)w.type);
+		combine(GetVulkanHandle(w.view));
+		combine(GetVulkanHandle(w.sampler));
+		combine((uint64_t)w.layout);
+		combine(GetVulkanHandle(w.buffer));
+		combine(w.offset);
+		combine(w.range);
+	}
+	return hash;
+}
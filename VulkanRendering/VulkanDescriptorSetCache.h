@@ -0,0 +1,59 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "VulkanDescriptorSetWriter.h"
+#include <unordered_map>
+
+namespace NCL::Rendering::Vulkan {
+	class DescriptorAllocator;
+
+	/*
+	Hands back the same descriptor set whenever it's asked for the same
+	layout with the same bindings, so materials that share textures share
+	one set, rather than each taking another from the pool. A set is only
+	written the first time it's asked for, with the writes going into the
+	given DescriptorSetWriter - which must be flushed before the set is
+	bound.
+
+	Sets are matched on the handles they were written with, so anything
+	cached must be cleared out before the views or buffers it refers to
+	are destroyed.
+	*/
+	class DescriptorSetCache	{
+	public:
+		DescriptorSetCache(DescriptorAllocator& allocator);
+		~DescriptorSetCache();
+
+		vk::DescriptorSet Get(vk::DescriptorSetLayout layout, const std::vector<DescriptorWrite>& bindings, DescriptorSetWriter& writer, const std::string& debugName = "");
+
+		void Clear();
+
+		uint32_t GetSetCount() const {
+			return (uint32_t)sets.size();
+		}
+		//How many requests were given an existing set
+		uint32_t GetHitCount() const {
+			return hitCount;
+		}
+
+	protected:
+		struct Key {
+			vk::DescriptorSetLayout			layout;
+			std::vector<DescriptorWrite>	bindings;
+
+			bool operator==(const Key& other) const = default;
+		};
+		struct KeyHash {
+			size_t operator()(const Key& k) const;
+		};
+
+		DescriptorAllocator& allocator;
+		std::unordered_map<Key, vk::UniqueDescriptorSet, KeyHash> sets;
+		uint32_t hitCount;
+	};
+}
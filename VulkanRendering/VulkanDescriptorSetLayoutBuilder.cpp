@@ -99,6 +99,7 @@ vk::UniqueDescriptorSetLayout DescriptorSetLayoutBuilder::Build(const std::strin
 
 	createInfo.pNext = &bindingFlagsInfo;
 	vk::UniqueDescriptorSetLayout layout = std::move(sourceDevice.createDescriptorSetLayoutUnique(createInfo));
+	SetDescriptorSetLayoutSizes(*layout, addedBindings);
 	if (!debugName.empty()) {
 		SetDebugName(sourceDevice, vk::ObjectType::eDescriptorSetLayout, GetVulkanHandle(*layout), debugName);
 	}
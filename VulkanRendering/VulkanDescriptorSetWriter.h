@@ -7,32 +7,120 @@ License: MIT (see LICENSE file at the top of the source tree)
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
 namespace NCL::Rendering::Vulkan {
+	//Everything needed to fill in one descriptor of a set
+	struct DescriptorWrite {
+		uint32_t			binding			= 0;
+		uint32_t			arrayElement	= 0;
+		vk::DescriptorType	type			= vk::DescriptorType::eCombinedImageSampler;
+
+		vk::ImageView		view;
+		vk::Sampler			sampler;
+		vk::ImageLayout		layout			= vk::ImageLayout::eShaderReadOnlyOptimal;
+
+		vk::Buffer			buffer;
+		vk::DeviceSize		offset			= 0;
+		vk::DeviceSize		range			= VK_WHOLE_SIZE;
+
+		bool operator==(const DescriptorWrite& other) const = default;
+
+		bool IsBuffer() const {
+			return	type == vk::DescriptorType::eUniformBuffer || type == vk::DescriptorType::eUniformBufferDynamic ||
+					type == vk::DescriptorType::eStorageBuffer || type == vk::DescriptorType::eStorageBufferDynamic;
+		}
+
+		static DescriptorWrite Image(uint32_t binding, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal) {
+			return { .binding = binding, .type = vk::DescriptorType::eCombinedImageSampler, .view = view, .sampler = sampler, .layout = layout };
+		}
+		static DescriptorWrite StorageImage(uint32_t binding, vk::ImageView view, vk::ImageLayout layout = vk::ImageLayout::eGeneral) {
+			return { .binding = binding, .type = vk::DescriptorType::eStorageImage, .view = view, .layout = layout };
+		}
+		static DescriptorWrite Buffer(uint32_t binding, vk::Buffer buffer, vk::DescriptorType type, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) {
+			return { .binding = binding, .type = type, .buffer = buffer, .offset = offset, .range = (range > 0 ? range : VK_WHOLE_SIZE) };
+		}
+	};
+
+	/*
+	Collects descriptor writes, for any number of sets, and hands them all
+	to the driver in a single updateDescriptorSets call when flushed, or
+	when the writer goes out of scope. Writing hundreds of material sets at
+	load time is then one call rather than hundreds.
+	*/
 	class DescriptorSetWriter {
 	public:
-		DescriptorSetWriter(vk::Device device, vk::DescriptorSet set) {
+		DescriptorSetWriter(vk::Device device, vk::DescriptorSet set = {}) {
 			this->device = device;
 			this->set = set;
 		}
 		~DescriptorSetWriter() {
+			Flush();
 		}
 
-		DescriptorSetWriter& WriteImage(uint32_t binding, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal) {
-			Vulkan::WriteImageDescriptor(device, set, binding, view, sampler, layout);
+		//Writes after this go to a different set
+		DescriptorSetWriter& ForSet(vk::DescriptorSet set) {
+			this->set = set;
 			return *this;
 		}
 
+		DescriptorSetWriter& WriteImage(uint32_t binding, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal) {
+			return Write(set, DescriptorWrite::Image(binding, view, sampler, layout));
+		}
+
 		DescriptorSetWriter& WriteStorageImage(uint32_t binding, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal) {
-			Vulkan::WriteStorageImageDescriptor(device, set, binding, view, sampler, layout);
-			return *this;
+			DescriptorWrite w = DescriptorWrite::StorageImage(binding, view, layout);
+			w.sampler = sampler;
+			return Write(set, w);
 		}
 
 		DescriptorSetWriter& WriteBuffer(uint32_t binding, vk::Buffer buffer, vk::DescriptorType type, size_t offset = 0, size_t range = VK_WHOLE_SIZE) {
-			Vulkan::WriteBufferDescriptor(device, set, binding, type, buffer, offset, range);
+			return Write(set, DescriptorWrite::Buffer(binding, buffer, type, offset, range));
+		}
+
+		DescriptorSetWriter& Write(vk::DescriptorSet toSet, const DescriptorWrite& write) {
+			pending.push_back({ toSet, write });
 			return *this;
 		}
 
+		void Flush() {
+			if (pending.empty()) {
+				return;
+			}
+			//Reserved up front, the writes point into these
+			std::vector<vk::DescriptorImageInfo>	imageInfos;
+			std::vector<vk::DescriptorBufferInfo>	bufferInfos;
+			std::vector<vk::WriteDescriptorSet>		writes;
+			imageInfos.reserve(pending.size());
+			bufferInfos.reserve(pending.size());
+			writes.reserve(pending.size());
+
+			for (const auto& [toSet, w] : pending) {
+				vk::WriteDescriptorSet descriptorWrite = {
+					.dstSet				= toSet,
+					.dstBinding			= w.binding,
+					.dstArrayElement	= w.arrayElement,
+					.descriptorCount	= 1,
+					.descriptorType		= w.type
+				};
+				if (w.IsBuffer()) {
+					bufferInfos.push_back({ .buffer = w.buffer, .offset = w.offset, .range = w.range });
+					descriptorWrite.pBufferInfo = &bufferInfos.back();
+				}
+				else {
+					imageInfos.push_back({ .sampler = w.sampler, .imageView = w.view, .imageLayout = w.layout });
+					descriptorWrite.pImageInfo = &imageInfos.back();
+				}
+				writes.push_back(descriptorWrite);
+			}
+			device.updateDescriptorSets(writes, {});
+			pending.clear();
+		}
+
+		size_t GetPendingCount() const {
+			return pending.size();
+		}
+
 	protected:
 		vk::Device device;
 		vk::DescriptorSet set;
+		std::vector<std::pair<vk::DescriptorSet, DescriptorWrite>> pending;
 	};
-}
\ No newline at end of file
+}
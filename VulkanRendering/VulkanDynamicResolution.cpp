@@ -0,0 +1,151 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanDynamicResolution.h"
+#include "VulkanTextureBuilder.h"
+#include "VulkanUtils.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+//Render extents are kept to multiples of this, so small changes in scale don't resize every frame
+const uint32_t EXTENT_GRANULARITY = 8;
+
+DynamicResolution::DynamicResolution(vk::Device device, VmaAllocator allocator, vk::Format colourFormat, uint32_t framesInFlight, float timestampPeriod, bool timestampsSupported) {
+	this->device			= device;
+	this->allocator			= allocator;
+	this->colourFormat		= colourFormat;
+	this->timestampPeriod	= timestampPeriod;
+
+	//Without timestamps there's nothing to steer by, so the scale just stays where it is
+	if (timestampsSupported) {
+		timestampPool = device.createQueryPoolUnique({
+			.queryType	= vk::QueryType::eTimestamp,
+			.queryCount = framesInFlight * 2
+		});
+	}
+	queriesWritten.assign(framesInFlight, false);
+}
+
+void DynamicResolution::Resize(uint32_t width, uint32_t height, ImmediateContext& context) {
+	fullExtent = { width, height };
+
+	colourTarget = TextureBuilder(device, allocator)
+		.UsingContext(context)
+		.WithDimension(width, height)
+		.WithAspects(vk::ImageAspectFlagBits::eColor)
+		.WithFormat(colourFormat)
+		.WithLayout(vk::ImageLayout::eColorAttachmentOptimal)
+		.WithUsages(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc)
+		.WithPipeFlags(vk::PipelineStageFlagBits2::eColorAttachmentOutput)
+		.WithMemoryCategory(MemoryCategory::RenderTargets)
+		.WithMips(false)
+		.Build("Dynamic Resolution Target");
+
+	//Resizing waits for the device to go idle, so any timings still pending are of the old size and can be dropped
+	std::fill(queriesWritten.begin(), queriesWritten.end(), false);
+	scale = maxScale;
+	UpdateRenderExtent();
+}
+
+void DynamicResolution::SetScaleRange(float inMin, float inMax) {
+	maxScale	= std::clamp(inMax, 0.1f, 1.0f);	//The target is only window sized
+	minScale	= std::clamp(inMin, 0.1f, maxScale);
+	scale		= std::clamp(scale, minScale, maxScale);
+	UpdateRenderExtent();
+}
+
+void DynamicResolution::BeginFrame(vk::CommandBuffer cmds, uint32_t frameIndex) {
+	if (timestampPool) {
+		uint32_t firstQuery = frameIndex * 2;
+		if (queriesWritten[frameIndex]) {
+			uint64_t stamps[2];
+			vk::Result result = device.getQueryPoolResults(*timestampPool, firstQuery, 2, sizeof(stamps), stamps, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+			if (result == vk::Result::eSuccess) {
+				UpdateScale(float(stamps[1] - stamps[0]) * timestampPeriod / 1000000.0f);
+			}
+		}
+		cmds.resetQueryPool(*timestampPool, firstQuery, 2);
+		cmds.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *timestampPool, firstQuery);
+		queriesWritten[frameIndex] = true;
+	}
+	//The previous frame's blit might still be reading from the target
+	ImageTransitionBarrier(cmds, colourTarget->GetImage(),
+		vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal, vk::ImageAspectFlagBits::eColor,
+		vk::PipelineStageFlagBits2::eBlit, vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+}
+
+void DynamicResolution::EndFrame(vk::CommandBuffer cmds, uint32_t frameIndex, vk::Image swapImage) {
+	ImageTransitionBarrier(cmds, colourTarget->GetImage(), {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+		.srcAccessMask	= vk::AccessFlagBits2::eColorAttachmentWrite,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eBlit,
+		.dstAccessMask	= vk::AccessFlagBits2::eTransferRead,
+		.oldLayout		= vk::ImageLayout::eColorAttachmentOptimal,
+		.newLayout		= vk::ImageLayout::eTransferSrcOptimal,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+	});
+	//Whatever was in the swap image is about to be overwritten. The frame waits on its acquire at the blit stage
+	ImageTransitionBarrier(cmds, swapImage,
+		vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, vk::ImageAspectFlagBits::eColor,
+		vk::PipelineStageFlagBits2::eBlit, vk::PipelineStageFlagBits2::eBlit);
+
+	CopyImageToImage(cmds, colourTarget->GetImage(), swapImage, renderExtent, fullExtent);
+
+	//Leave it how the renderer would have, so presenting or reading back works the same either way
+	ImageTransitionBarrier(cmds, swapImage, {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eBlit,
+		.srcAccessMask	= vk::AccessFlagBits2::eTransferWrite,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+		.dstAccessMask	= vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite,
+		.oldLayout		= vk::ImageLayout::eTransferDstOptimal,
+		.newLayout		= vk::ImageLayout::eColorAttachmentOptimal,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+	});
+
+	if (timestampPool) {
+		cmds.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *timestampPool, frameIndex * 2 + 1);
+	}
+}
+
+void DynamicResolution::UpdateScale(float frameMs) {
+	//A single slow frame (a pipeline compile, say) shouldn't drag the resolution down with it
+	gpuFrameTime = (gpuFrameTime == 0.0f) ? frameMs : gpuFrameTime + (frameMs - gpuFrameTime) * 0.1f;
+
+	if (gpuFrameTime <= 0.0f) {
+		return;
+	}
+	//Aim a little under the target, to leave room for the frame to frame noise
+	float aimFor = targetFrameTime * 0.9f;
+	//GPU time goes roughly with pixel count, which goes with the square of the scale
+	float idealScale = std::clamp(scale * std::sqrt(aimFor / gpuFrameTime), minScale, maxScale);
+
+	if (idealScale < scale) {	//Over budget, so no easing - the frame time is already smoothed
+		scale = idealScale;
+	}
+	else if (idealScale > scale * 1.02f) {	//Close enough is left alone, so it settles
+		scale += (idealScale - scale) * 0.05f;
+	}
+	UpdateRenderExtent();
+}
+
+void DynamicResolution::UpdateRenderExtent() {
+	auto scaleAxis = [&](uint32_t full) {
+		uint32_t scaled = (uint32_t)(full * scale);
+		scaled = (scaled + EXTENT_GRANULARITY / 2) / EXTENT_GRANULARITY * EXTENT_GRANULARITY;
+		return std::clamp(scaled, std::min(full, EXTENT_GRANULARITY), full);
+	};
+	renderExtent = { scaleAxis(fullExtent.width), scaleAxis(fullExtent.height) };
+}
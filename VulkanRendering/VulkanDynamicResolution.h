@@ -0,0 +1,101 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "VulkanTexture.h"
+
+namespace NCL::Rendering::Vulkan {
+	class ImmediateContext;
+
+	/*
+	DynamicResolution: Lets the scene render at less than window size when
+	the GPU can't keep up, so heavy scenes hold their frame rate rather
+	than their resolution.
+
+	The frame is drawn into the top left of a window sized colour target,
+	with FrameState's viewport, scissor and screen rect shrunk to match,
+	and then blitted up to fill the swapchain image at the end of the frame.
+	Anything rendering to its own targets can use the FrameState rects to
+	only touch the same region, and so share in the savings.
+
+	Each frame is timed with a pair of GPU timestamps. Once a frame's fence
+	has been waited on its time is read back and smoothed, and the scale
+	is moved towards whatever should bring the frame in just under the
+	target time. Drops are made straight away, but increases are eased in
+	so the resolution doesn't visibly bounce around the target.
+
+	VulkanRenderer makes one of these when VulkanInitialisation asks for
+	it, and calls BeginFrame / EndFrame itself. The default render pass
+	draws straight into the swap image, so only dynamic rendering works
+	alongside it.
+	*/
+	class DynamicResolution {
+	public:
+		DynamicResolution(vk::Device device, VmaAllocator allocator, vk::Format colourFormat, uint32_t framesInFlight, float timestampPeriod, bool timestampsSupported);
+		~DynamicResolution() = default;
+
+		//Remakes the colour target, and starts the scale again from the top
+		void Resize(uint32_t width, uint32_t height, ImmediateContext& context);
+
+		//Reads back a previous frame's time to pick this frame's scale, and gets the colour target ready to draw into.
+		//The fence of frameIndex must have already been waited on
+		void BeginFrame(vk::CommandBuffer cmds, uint32_t frameIndex);
+
+		//Scales what has been drawn up to fill swapImage, which is left in eColorAttachmentOptimal
+		void EndFrame(vk::CommandBuffer cmds, uint32_t frameIndex, vk::Image swapImage);
+
+		//Anything over this many milliseconds of GPU time and the resolution starts to drop
+		void SetTargetFrameTime(float ms) {
+			targetFrameTime = ms;
+		}
+		void SetScaleRange(float minScale, float maxScale);
+
+		float GetScale() const {
+			return scale;
+		}
+		//The smoothed GPU time of recent frames, in milliseconds
+		float GetGPUFrameTime() const {
+			return gpuFrameTime;
+		}
+
+		vk::Extent2D GetRenderExtent() const {
+			return renderExtent;
+		}
+		vk::Extent2D GetFullExtent() const {
+			return fullExtent;
+		}
+
+		vk::Image GetColourImage() const {
+			return colourTarget->GetImage();
+		}
+		vk::ImageView GetColourView() const {
+			return colourTarget->GetDefaultView();
+		}
+
+	protected:
+		void UpdateScale(float frameMs);
+		void UpdateRenderExtent();
+
+		vk::Device		device;
+		VmaAllocator	allocator;
+		vk::Format		colourFormat;
+
+		UniqueVulkanTexture		colourTarget;
+		vk::Extent2D			fullExtent;
+		vk::Extent2D			renderExtent;
+
+		vk::UniqueQueryPool		timestampPool;	//A begin and end query for each frame in flight
+		std::vector<bool>		queriesWritten;
+		float					timestampPeriod;
+
+		float	targetFrameTime	= 16.6f;
+		float	minScale		= 0.5f;
+		float	maxScale		= 1.0f;
+		float	scale			= 1.0f;
+		float	gpuFrameTime	= 0.0f;
+	};
+}
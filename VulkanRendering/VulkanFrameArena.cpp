@@ -0,0 +1,59 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanFrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+FrameArena::FrameArena(size_t initialSize) : overflow(std::pmr::new_delete_resource()) {
+	capacity		= std::max(initialSize, (size_t)1024);
+	block			= std::make_unique<std::byte[]>(capacity);
+	used			= 0;
+	overflowBytes	= 0;
+}
+
+FrameArena::~FrameArena() {
+}
+
+void FrameArena::Reset() {
+	if (overflowBytes > 0) {
+		//Grown with some room to spare, so a frame that needs a little more each time doesn't overflow every time
+		size_t newCapacity = std::max(capacity * 2, (used + overflowBytes) * 3 / 2);
+		std::cout << __FUNCTION__ << " Frame arena overflowed by " << overflowBytes << " bytes, growing from " << capacity << " to " << newCapacity << " bytes\n";
+		capacity	= newCapacity;
+		block		= std::make_unique<std::byte[]>(capacity);
+		overflow.release();
+	}
+	used			= 0;
+	overflowBytes	= 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+	//Aligned by address, as the block itself is only aligned for the default new
+	uintptr_t base	= (uintptr_t)block.get();
+	size_t start	= (base + used + alignment - 1) / alignment * alignment - base;
+	if (start + bytes <= capacity) {
+		used = start + bytes;
+		return block.get() + start;
+	}
+	overflowBytes += bytes;
+	return overflow.allocate(bytes, alignment);
+}
+
+void FrameArena::do_deallocate(void*, size_t, size_t) {
+	//Nothing is given back until Reset
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <memory_resource>
+#include <memory>
+#include <vector>
+
+namespace NCL::Rendering::Vulkan {
+	/*
+	FrameArena: A block of CPU memory that transient, per-frame data is bump
+	allocated out of, and that is all freed at once when Reset. It's the CPU
+	side counterpart to the FrameUploadRing - scratch arrays built up while
+	recording a frame come from here rather than the heap.
+
+	It's a std::pmr::memory_resource, so any pmr container can use it:
+
+		std::pmr::vector<Matrix4> joints(count, &renderer->GetFrameArena());
+
+	Deallocating does nothing, space only comes back on Reset, which the
+	renderer calls at the start of every frame - so nothing allocated from
+	it may be kept past the end of the frame.
+
+	If a frame asks for more than the arena holds, the rest comes from the
+	heap, and the next Reset grows the arena to fit, so only the first frame
+	to need the extra space ever touches the heap.
+
+	Not thread safe - it's for the thread recording the frame.
+	*/
+	class FrameArena : public std::pmr::memory_resource {
+	public:
+		FrameArena(size_t initialSize = 1024 * 1024);
+		~FrameArena();
+
+		//Frees everything allocated since the last Reset
+		void Reset();
+
+		size_t GetBytesUsed() const {
+			return used + overflowBytes;
+		}
+		size_t GetCapacity() const {
+			return capacity;
+		}
+		//Bytes that didn't fit, and came from the heap instead, since the last Reset
+		size_t GetOverflowBytes() const {
+			return overflowBytes;
+		}
+
+	protected:
+		void*	do_allocate(size_t bytes, size_t alignment) override;
+		void	do_deallocate(void* p, size_t bytes, size_t alignment) override;
+		bool	do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+		std::unique_ptr<std::byte[]>	block;
+		size_t							capacity;
+		size_t							used;
+
+		std::pmr::monotonic_buffer_resource overflow;	//Heap backed, for whatever doesn't fit in the block
+		size_t								overflowBytes;
+	};
+}
@@ -0,0 +1,153 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanFrameCounters.h"
+
+#include <atomic>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+namespace {
+	//Each on its own cache line, so threads counting different things don't fight over them
+	struct alignas(64) Counter {
+		std::atomic<uint64_t> value = 0;
+	};
+	Counter counters[(size_t)FrameCounter::MAX_COUNTERS];
+
+	void Count(FrameCounter c, uint64_t amount = 1) {
+		counters[(size_t)c].value.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	//The dispatcher's real function pointers, which the counting versions pass everything on to
+	PFN_vkCmdDraw					realCmdDraw;
+	PFN_vkCmdDrawIndexed			realCmdDrawIndexed;
+	PFN_vkCmdDrawIndirect			realCmdDrawIndirect;
+	PFN_vkCmdDrawIndexedIndirect	realCmdDrawIndexedIndirect;
+	PFN_vkCmdDispatch				realCmdDispatch;
+	PFN_vkCmdDispatchIndirect		realCmdDispatchIndirect;
+	PFN_vkCmdBindPipeline			realCmdBindPipeline;
+	PFN_vkCmdBindDescriptorSets		realCmdBindDescriptorSets;
+	PFN_vkCmdPushDescriptorSetKHR	realCmdPushDescriptorSetKHR;
+	PFN_vkCmdPipelineBarrier		realCmdPipelineBarrier;
+	PFN_vkCmdPipelineBarrier2		realCmdPipelineBarrier2;
+	PFN_vkCmdPipelineBarrier2KHR	realCmdPipelineBarrier2KHR;
+
+	VKAPI_ATTR void VKAPI_CALL CountCmdDraw(VkCommandBuffer cmds, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+		Count(FrameCounter::Draws);
+		realCmdDraw(cmds, vertexCount, instanceCount, firstVertex, firstInstance);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdDrawIndexed(VkCommandBuffer cmds, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+		Count(FrameCounter::Draws);
+		realCmdDrawIndexed(cmds, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdDrawIndirect(VkCommandBuffer cmds, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride) {
+		Count(FrameCounter::Draws, drawCount);
+		realCmdDrawIndirect(cmds, buffer, offset, drawCount, stride);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdDrawIndexedIndirect(VkCommandBuffer cmds, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride) {
+		Count(FrameCounter::Draws, drawCount);
+		realCmdDrawIndexedIndirect(cmds, buffer, offset, drawCount, stride);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdDispatch(VkCommandBuffer cmds, uint32_t x, uint32_t y, uint32_t z) {
+		Count(FrameCounter::Dispatches);
+		realCmdDispatch(cmds, x, y, z);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdDispatchIndirect(VkCommandBuffer cmds, VkBuffer buffer, VkDeviceSize offset) {
+		Count(FrameCounter::Dispatches);
+		realCmdDispatchIndirect(cmds, buffer, offset);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdBindPipeline(VkCommandBuffer cmds, VkPipelineBindPoint bindPoint, VkPipeline pipeline) {
+		Count(FrameCounter::PipelineBinds);
+		realCmdBindPipeline(cmds, bindPoint, pipeline);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdBindDescriptorSets(VkCommandBuffer cmds, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet,
+		uint32_t setCount, const VkDescriptorSet* sets, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets) {
+		Count(FrameCounter::DescriptorBinds);
+		realCmdBindDescriptorSets(cmds, bindPoint, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdPushDescriptorSetKHR(VkCommandBuffer cmds, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t set,
+		uint32_t writeCount, const VkWriteDescriptorSet* writes) {
+		Count(FrameCounter::DescriptorBinds);
+		realCmdPushDescriptorSetKHR(cmds, bindPoint, layout, set, writeCount, writes);
+	}
+	//Barriers are counted one by one, rather than by call
+	VKAPI_ATTR void VKAPI_CALL CountCmdPipelineBarrier(VkCommandBuffer cmds, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages, VkDependencyFlags flags,
+		uint32_t memoryCount, const VkMemoryBarrier* memoryBarriers,
+		uint32_t bufferCount, const VkBufferMemoryBarrier* bufferBarriers,
+		uint32_t imageCount, const VkImageMemoryBarrier* imageBarriers) {
+		Count(FrameCounter::Barriers, memoryCount + bufferCount + imageCount);
+		realCmdPipelineBarrier(cmds, srcStages, dstStages, flags, memoryCount, memoryBarriers, bufferCount, bufferBarriers, imageCount, imageBarriers);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdPipelineBarrier2(VkCommandBuffer cmds, const VkDependencyInfo* info) {
+		Count(FrameCounter::Barriers, info->memoryBarrierCount + info->bufferMemoryBarrierCount + info->imageMemoryBarrierCount);
+		realCmdPipelineBarrier2(cmds, info);
+	}
+	VKAPI_ATTR void VKAPI_CALL CountCmdPipelineBarrier2KHR(VkCommandBuffer cmds, const VkDependencyInfo* info) {
+		Count(FrameCounter::Barriers, info->memoryBarrierCount + info->bufferMemoryBarrierCount + info->imageMemoryBarrierCount);
+		realCmdPipelineBarrier2KHR(cmds, info);
+	}
+
+	//Swaps in the counting version, unless the function isn't loaded or has already been swapped
+	template <typename T>
+	void Hook(T& dispatcherEntry, T& real, T counting) {
+		if (dispatcherEntry && dispatcherEntry != counting) {
+			real			= dispatcherEntry;
+			dispatcherEntry = counting;
+		}
+	}
+}
+
+const char* Vulkan::GetFrameCounterName(FrameCounter counter) {
+	switch (counter) {
+		case FrameCounter::Draws:			return "Draws";
+		case FrameCounter::Dispatches:		return "Dispatches";
+		case FrameCounter::PipelineBinds:	return "Pipeline Binds";
+		case FrameCounter::DescriptorBinds:	return "Descriptor Binds";
+		case FrameCounter::Barriers:		return "Barriers";
+		case FrameCounter::BytesUploaded:	return "Bytes Uploaded";
+		default:							return "Unknown";
+	}
+}
+
+//Has to be called again whenever the dispatcher is re-initialised, as that puts the real functions back
+void Vulkan::InstallFrameCounterHooks() {
+	auto& d = VULKAN_HPP_DEFAULT_DISPATCHER;
+	Hook(d.vkCmdDraw,					realCmdDraw,					&CountCmdDraw);
+	Hook(d.vkCmdDrawIndexed,			realCmdDrawIndexed,				&CountCmdDrawIndexed);
+	Hook(d.vkCmdDrawIndirect,			realCmdDrawIndirect,			&CountCmdDrawIndirect);
+	Hook(d.vkCmdDrawIndexedIndirect,	realCmdDrawIndexedIndirect,		&CountCmdDrawIndexedIndirect);
+	Hook(d.vkCmdDispatch,				realCmdDispatch,				&CountCmdDispatch);
+	Hook(d.vkCmdDispatchIndirect,		realCmdDispatchIndirect,		&CountCmdDispatchIndirect);
+	Hook(d.vkCmdBindPipeline,			realCmdBindPipeline,			&CountCmdBindPipeline);
+	Hook(d.vkCmdBindDescriptorSets,		realCmdBindDescriptorSets,		&CountCmdBindDescriptorSets);
+	Hook(d.vkCmdPushDescriptorSetKHR,	realCmdPushDescriptorSetKHR,	&CountCmdPushDescriptorSetKHR);
+	Hook(d.vkCmdPipelineBarrier,		realCmdPipelineBarrier,			&CountCmdPipelineBarrier);
+	Hook(d.vkCmdPipelineBarrier2,		realCmdPipelineBarrier2,		&CountCmdPipelineBarrier2);
+	Hook(d.vkCmdPipelineBarrier2KHR,	realCmdPipelineBarrier2KHR,		&CountCmdPipelineBarrier2KHR);
+}
+
+void Vulkan::AddToFrameCounter(FrameCounter counter, uint64_t amount) {
+	Count(counter, amount);
+}
+
+FrameCounters Vulkan::TakeFrameCounters() {
+	FrameCounters taken;
+	for (size_t i = 0; i < (size_t)FrameCounter::MAX_COUNTERS; ++i) {
+		taken.values[i] = counters[i].value.exchange(0, std::memory_order_relaxed);
+	}
+	return taken;
+}
+
+void Vulkan::PrintFrameCounters(const FrameCounters& frameCounters) {
+	std::cout << "Last frame recorded:";
+	for (size_t i = 0; i < (size_t)FrameCounter::MAX_COUNTERS; ++i) {
+		std::cout << (i == 0 ? " " : ", ") << frameCounters.values[i] << " " << GetFrameCounterName((FrameCounter)i);
+	}
+	std::cout << "\n";
+}
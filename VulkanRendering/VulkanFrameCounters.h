@@ -0,0 +1,48 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+namespace NCL::Rendering::Vulkan {
+	//Things that cost CPU time to record, counted per frame so a change that adds more of them shows up straight away
+	enum class FrameCounter {
+		Draws,
+		Dispatches,
+		PipelineBinds,
+		DescriptorBinds,
+		Barriers,
+		BytesUploaded,
+		MAX_COUNTERS
+	};
+	const char* GetFrameCounterName(FrameCounter counter);
+
+	struct FrameCounters {
+		uint64_t values[(size_t)FrameCounter::MAX_COUNTERS] = {};
+
+		uint64_t Get(FrameCounter c) const {
+			return values[(size_t)c];
+		}
+	};
+
+	/*
+	Draws, dispatches, binds and barriers are counted by swapping the
+	command functions in the default dispatcher for ones that count the
+	call and then pass it on, so everything recorded through vulkan.hpp
+	is counted, whether it comes from the renderer or the app. Any code
+	that writes into mapped memory calls AddToFrameCounter itself.
+
+	Counting is a relaxed atomic add, so is safe from any thread.
+	*/
+	void InstallFrameCounterHooks();
+
+	void AddToFrameCounter(FrameCounter counter, uint64_t amount = 1);
+
+	//Everything counted since the last call, which resets the counts
+	FrameCounters TakeFrameCounters();
+
+	void PrintFrameCounters(const FrameCounters& counters);
+}
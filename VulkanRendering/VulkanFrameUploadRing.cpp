@@ -0,0 +1,69 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanFrameUploadRing.h"
+#include "VulkanBufferBuilder.h"
+#include "VulkanFrameCounters.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+FrameUploadRing::FrameUploadRing(vk::Device device, VmaAllocator allocator, uint32_t framesInFlight, vk::DeviceSize bytesPerFrame, vk::DeviceSize minAlignment) {
+	this->minAlignment	= std::max<vk::DeviceSize>(minAlignment, 16);
+	//Every slice starts aligned, so the first allocation of a frame never wastes any space
+	this->bytesPerFrame = (bytesPerFrame + this->minAlignment - 1) / this->minAlignment * this->minAlignment;
+
+	buffer = BufferBuilder(device, allocator)
+		.WithBufferUsage(vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer |
+						 vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer |
+						 vk::BufferUsageFlagBits::eTransferSrc)
+		.WithHostVisibility()
+		.WithPersistentMapping()
+		.WithMemoryCategory(MemoryCategory::Staging)
+		.Build(this->bytesPerFrame * framesInFlight, "Frame Upload Ring");
+
+	mappedData	= (char*)buffer.Data();
+	frameStart	= 0;
+	head		= 0;
+	peakUsage	= 0;
+	overflowed	= false;
+}
+
+FrameUploadRing::~FrameUploadRing() {
+}
+
+void FrameUploadRing::BeginFrame(uint32_t frameIndex) {
+	peakUsage	= std::max(peakUsage, head - frameStart);
+	frameStart	= bytesPerFrame * frameIndex;
+	head		= frameStart;
+	overflowed	= false;
+}
+
+FrameUploadRing::Allocation FrameUploadRing::Allocate(vk::DeviceSize size, vk::DeviceSize alignment) {
+	alignment = std::max(alignment, minAlignment);
+	vk::DeviceSize offset = (head + alignment - 1) / alignment * alignment;
+
+	if (offset + size > frameStart + bytesPerFrame) {
+		if (!overflowed) {	//Once a frame is enough
+			std::cout << __FUNCTION__ << " Frame upload ring is full! " << bytesPerFrame << " bytes per frame isn't enough, increase VulkanInitialisation::frameUploadSize\n";
+			overflowed = true;
+		}
+		return {};
+	}
+	head = offset + size;
+	AddToFrameCounter(FrameCounter::BytesUploaded, size);	//Whatever it's for, it's about to be written to
+
+	return Allocation{
+		.data	= mappedData + offset,
+		.buffer = buffer.buffer,
+		.offset = offset,
+		.size	= size
+	};
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "VulkanBuffers.h"
+#include <cstring>
+
+namespace NCL::Rendering::Vulkan {
+	/*
+	FrameUploadRing: One big persistently mapped buffer, split into a slice
+	for each frame in flight. Anything that changes every frame (camera
+	matrices, lights, joints etc) is bump allocated out of the current
+	slice and written through the returned pointer, then bound using the
+	buffer and offset - either directly, or as a dynamic offset.
+
+	A slice is only handed out again once the frame that last used it has
+	finished on the GPU, so data is never overwritten while still being read,
+	and nothing has to be mapped or created per frame. BeginFrame must only
+	be called once the frame's fence has signalled - VulkanRenderer does
+	this in BeginFrame.
+	*/
+	class FrameUploadRing	{
+	public:
+		struct Allocation {
+			void*			data	= nullptr;
+			vk::Buffer		buffer;
+			vk::DeviceSize	offset	= 0;
+			vk::DeviceSize	size	= 0;
+
+			template<typename T>
+			T* As() const {
+				return static_cast<T*>(data);
+			}
+			explicit operator bool() const {
+				return data != nullptr;
+			}
+		};
+
+		FrameUploadRing(vk::Device device, VmaAllocator allocator, uint32_t framesInFlight, vk::DeviceSize bytesPerFrame, vk::DeviceSize minAlignment);
+		~FrameUploadRing();
+
+		void BeginFrame(uint32_t frameIndex);
+
+		//Space for this frame only. Offsets are always at least minAlignment aligned, so can be used for dynamic UBOs / SSBOs
+		Allocation Allocate(vk::DeviceSize size, vk::DeviceSize alignment = 0);
+
+		Allocation Upload(const void* data, vk::DeviceSize size) {
+			Allocation a = Allocate(size);
+			if (a) {
+				memcpy(a.data, data, size);
+			}
+			return a;
+		}
+
+		template<typename T>
+		Allocation Upload(const T& data) {
+			return Upload(&data, sizeof(T));
+		}
+
+		vk::Buffer GetBuffer() const {
+			return buffer.buffer;
+		}
+		vk::DeviceSize GetFrameUsage() const {
+			return head - frameStart;
+		}
+		vk::DeviceSize GetPeakFrameUsage() const {
+			return peakUsage;
+		}
+
+	protected:
+		VulkanBuffer	buffer;
+		char*			mappedData;
+
+		vk::DeviceSize	bytesPerFrame;
+		vk::DeviceSize	minAlignment;
+		vk::DeviceSize	frameStart;
+		vk::DeviceSize	head;
+		vk::DeviceSize	peakUsage;
+		bool			overflowed;
+	};
+}
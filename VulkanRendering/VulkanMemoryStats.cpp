@@ -0,0 +1,131 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanMemoryStats.h"
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+namespace {
+	struct TrackedAllocation {
+		MemoryCategory	category;
+		vk::DeviceSize	size;
+	};
+	//Allocations can be made from loading threads, so everything in here is behind the lock
+	std::mutex											trackingLock;
+	std::unordered_map<VmaAllocation, TrackedAllocation> trackedAllocations;
+	MemorySnapshot::Category							categoryTotals[(size_t)MemoryCategory::MAX_CATEGORIES];
+}
+
+const char* Vulkan::GetMemoryCategoryName(MemoryCategory category) {
+	switch (category) {
+		case MemoryCategory::Textures:					return "Textures";
+		case MemoryCategory::RenderTargets:				return "Render Targets";
+		case MemoryCategory::Meshes:					return "Meshes";
+		case MemoryCategory::AccelerationStructures:	return "Acceleration Structures";
+		case MemoryCategory::Staging:					return "Staging";
+		case MemoryCategory::Planets:					return "Planets";
+		default:										return "Other";
+	}
+}
+
+void Vulkan::TrackAllocation(VmaAllocator allocator, VmaAllocation allocation, MemoryCategory category) {
+	if (!allocation) {
+		return;
+	}
+	VmaAllocationInfo info;
+	vmaGetAllocationInfo(allocator, allocation, &info);
+
+	std::lock_guard guard(trackingLock);
+	trackedAllocations[allocation] = { category, info.size };
+	categoryTotals[(size_t)category].bytes += info.size;
+	categoryTotals[(size_t)category].count++;
+}
+
+void Vulkan::UntrackAllocation(VmaAllocation allocation) {
+	std::lock_guard guard(trackingLock);
+	auto i = trackedAllocations.find(allocation);
+	if (i == trackedAllocations.end()) {
+		return;
+	}
+	categoryTotals[(size_t)i->second.category].bytes -= i->second.size;
+	categoryTotals[(size_t)i->second.category].count--;
+	trackedAllocations.erase(i);
+}
+
+vk::DeviceSize MemorySnapshot::GetDeviceLocalUsage() const {
+	vk::DeviceSize total = 0;
+	for (const Heap& h : heaps) {
+		total += h.deviceLocal ? h.usage : 0;
+	}
+	return total;
+}
+
+vk::DeviceSize MemorySnapshot::GetDeviceLocalBudget() const {
+	vk::DeviceSize total = 0;
+	for (const Heap& h : heaps) {
+		total += h.deviceLocal ? h.budget : 0;
+	}
+	return total;
+}
+
+void Vulkan::FillMemorySnapshot(VmaAllocator allocator, MemorySnapshot& snapshot) {
+	const VkPhysicalDeviceMemoryProperties* memProps = nullptr;
+	vmaGetMemoryProperties(allocator, &memProps);
+
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetHeapBudgets(allocator, budgets);
+
+	snapshot.heaps.resize(memProps->memoryHeapCount);
+	for (uint32_t i = 0; i < memProps->memoryHeapCount; ++i) {
+		MemorySnapshot::Heap& h = snapshot.heaps[i];
+		h.budget			= budgets[i].budget;
+		h.usage				= budgets[i].usage;
+		h.blockBytes		= budgets[i].statistics.blockBytes;
+		h.allocationBytes	= budgets[i].statistics.allocationBytes;
+		h.deviceLocal		= (memProps->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+	}
+
+	std::lock_guard guard(trackingLock);
+	for (size_t i = 0; i < (size_t)MemoryCategory::MAX_CATEGORIES; ++i) {
+		snapshot.categories[i] = categoryTotals[i];
+	}
+}
+
+void Vulkan::PrintMemorySnapshot(const MemorySnapshot& snapshot) {
+	const vk::DeviceSize MB = 1024 * 1024;
+
+	std::cout << "GPU memory at frame " << snapshot.frame << (snapshot.budgetQueries ? "" : " (estimated budget)") << "\n";
+	for (size_t i = 0; i < snapshot.heaps.size(); ++i) {
+		const MemorySnapshot::Heap& h = snapshot.heaps[i];
+		std::cout << "\tHeap " << i << (h.deviceLocal ? " (device local): " : ": ")
+			<< h.usage / MB << "MB of " << h.budget / MB << "MB budget, "
+			<< h.allocationBytes / MB << "MB used of " << h.blockBytes / MB << "MB allocated\n";
+	}
+	for (size_t i = 0; i < (size_t)MemoryCategory::MAX_CATEGORIES; ++i) {
+		std::cout << "\t" << GetMemoryCategoryName((MemoryCategory)i) << ": "
+			<< snapshot.categories[i].bytes / MB << "MB in " << snapshot.categories[i].count << " allocations\n";
+	}
+}
+
+bool Vulkan::WriteMemoryStatsJSON(VmaAllocator allocator, const std::string& filename) {
+	std::ofstream file(filename);
+	if (!file) {
+		std::cout << __FUNCTION__ << " Can't open " << filename << " for writing!\n";
+		return false;
+	}
+	char* stats = nullptr;
+	vmaBuildStatsString(allocator, &stats, VK_TRUE);
+	file << stats;
+	vmaFreeStatsString(allocator, stats);
+	return true;
+}
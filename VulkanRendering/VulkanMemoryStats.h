@@ -0,0 +1,65 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "vma/vk_mem_alloc.h"
+#include <string>
+
+namespace NCL::Rendering::Vulkan {
+	//What an allocation is for, so usage can be broken down by more than just heap
+	enum class MemoryCategory {
+		Textures,
+		RenderTargets,
+		Meshes,
+		AccelerationStructures,
+		Staging,
+		Planets,
+		Other,
+		MAX_CATEGORIES
+	};
+	const char* GetMemoryCategoryName(MemoryCategory category);
+
+	/*
+	Every buffer and image made through the builders is tracked here, by
+	category, and untracked again when it's destroyed. Anything allocated
+	from VMA directly has to call these itself.
+	*/
+	void TrackAllocation(VmaAllocator allocator, VmaAllocation allocation, MemoryCategory category);
+	void UntrackAllocation(VmaAllocation allocation);
+
+	struct MemorySnapshot {
+		struct Heap {
+			vk::DeviceSize	budget			= 0;	//How much the driver thinks we can use before things start going wrong
+			vk::DeviceSize	usage			= 0;	//Everything using the heap, including other processes if budget queries are enabled
+			vk::DeviceSize	blockBytes		= 0;	//Device memory VMA has allocated
+			vk::DeviceSize	allocationBytes = 0;	//How much of that is actually in use
+			bool			deviceLocal		= false;
+		};
+		struct Category {
+			vk::DeviceSize	bytes	= 0;
+			uint32_t		count	= 0;
+		};
+		uint64_t			frame = 0;
+		bool				budgetQueries = false;	//If false, budget and usage are VMA's estimates
+		std::vector<Heap>	heaps;
+		Category			categories[(size_t)MemoryCategory::MAX_CATEGORIES];
+
+		vk::DeviceSize GetDeviceLocalUsage() const;
+		vk::DeviceSize GetDeviceLocalBudget() const;
+
+		const Category& GetCategory(MemoryCategory c) const {
+			return categories[(size_t)c];
+		}
+	};
+
+	//Heap figures come from VMA, category totals from the tracking above
+	void FillMemorySnapshot(VmaAllocator allocator, MemorySnapshot& snapshot);
+	void PrintMemorySnapshot(const MemorySnapshot& snapshot);
+
+	//Writes VMA's detailed JSON dump, with every block and named allocation, to the file
+	bool WriteMemoryStatsJSON(VmaAllocator allocator, const std::string& filename);
+}
@@ -9,6 +9,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "Vulkanrenderer.h"
 #include "VulkanUtils.h"
 #include "VulkanBufferBuilder.h"
+#include "VulkanFrameCounters.h"
 
 using namespace NCL;
 using namespace Rendering;
@@ -52,10 +53,9 @@ void VulkanMesh::UploadToGPU(RendererBase* r, vk::BufferUsageFlags extraUses) {
 	VulkanRenderer* renderer = (VulkanRenderer*)r;
 
 	vk::Queue gfxQueue		= renderer->GetQueue(CommandBuffer::Graphics);
-	vk::CommandPool pool	= renderer->GetCommandPool(CommandBuffer::Graphics);
-	vk::Device device		= renderer->GetDevice();
+	ImmediateContext& context = renderer->GetImmediateContext(CommandBuffer::Graphics);
 
-	vk::UniqueCommandBuffer cmdBuffer = CmdBufferBegin(device, pool, "VulkanMesh upload");
+	vk::CommandBuffer cmdBuffer = context.Begin("VulkanMesh upload");
 
 	size_t allocationSize = CalculateGPUAllocationSize();
 
@@ -64,12 +64,13 @@ void VulkanMesh::UploadToGPU(RendererBase* r, vk::BufferUsageFlags extraUses) {
 		.WithHostVisibility()
 		.Build(allocationSize, "Staging Buffer");
 
-	UploadToGPU(renderer, gfxQueue, *cmdBuffer, stagingBuffer, extraUses);
+	UploadToGPU(renderer, gfxQueue, cmdBuffer, stagingBuffer, extraUses);
 
-	CmdBufferEndSubmitWait(*cmdBuffer, device, gfxQueue);
-	//The staging buffer is auto destroyed, but that's fine!
-	//We made the GPU wait for the commands to complete, so 
-	//the staging buffer has been read from at this point
+	//If this upload is part of a batch, the copy might not happen for a while,
+	//so the staging buffer is kept alive until the context knows it's been read
+	auto staging = std::make_shared<VulkanBuffer>(std::move(stagingBuffer));
+	context.OnComplete([staging]() {});
+	context.Submit();
 }
 
 void VulkanMesh::UploadToGPU(RendererBase* r)  {
@@ -77,13 +78,60 @@ void VulkanMesh::UploadToGPU(RendererBase* r)  {
 }
 
 void VulkanMesh::UploadToGPU(VulkanRenderer* renderer, VkQueue queue, vk::CommandBuffer cmdBuffer, VulkanBuffer& stagingBuffer, vk::BufferUsageFlags extraUses) {
+	std::vector<const char*> attributeDataSources;
+	size_t totalAllocationSize = InitGPUBuffer(renderer, extraUses, attributeDataSources);
+
+	assert(stagingBuffer.size >= (totalAllocationSize));
+
+	//need to now copy vertex data to device memory
+	char* dataPtr = (char*)stagingBuffer.Map();
+	for (size_t i = 0; i < usedAttributes.size(); ++i) {
+		//Copy the data from CPU to GPU-visible memory
+		memcpy(dataPtr + usedOffsets[i], attributeDataSources[i], GetVertexCount() * attributeSizes[usedAttributes[i]]);
+	}
+	if (GetIndexCount() > 0) {
+		memcpy(dataPtr + indexOffset, GetIndexData().data(), sizeof(int) * GetIndexCount());
+	}
+	stagingBuffer.Unmap();
+	AddToFrameCounter(FrameCounter::BytesUploaded, totalAllocationSize);
+
+	{//Now to transfer the mesh data from the staging buffer to the gpu-only buffer
+		vk::BufferCopy copyRegion;
+		copyRegion.size = totalAllocationSize;
+		cmdBuffer.copyBuffer(stagingBuffer.buffer, gpuBuffer.buffer, copyRegion);
+	}
+}
+
+StreamingUploader::Ticket VulkanMesh::StreamToGPU(VulkanRenderer* renderer, vk::BufferUsageFlags extraUses) {
+	assert(ValidateMeshData());
+
+	std::vector<const char*> attributeDataSources;
+	InitGPUBuffer(renderer, extraUses, attributeDataSources);
+
+	StreamingUploader& uploader = renderer->GetStreamingUploader();
+
+	const vk::PipelineStageFlags2	dstStages = vk::PipelineStageFlagBits2::eVertexInput | vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eComputeShader;
+	const vk::AccessFlags2			dstAccess = vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead | vk::AccessFlagBits2::eShaderStorageRead;
+
+	//Tickets only ever go up, so the last one covers every part of the buffer
+	StreamingUploader::Ticket ticket;
+	for (size_t i = 0; i < usedAttributes.size(); ++i) {
+		ticket = uploader.UploadBuffer(gpuBuffer.buffer, usedOffsets[i], attributeDataSources[i], GetVertexCount() * attributeSizes[usedAttributes[i]], dstStages, dstAccess);
+	}
+	if (GetIndexCount() > 0) {
+		ticket = uploader.UploadBuffer(gpuBuffer.buffer, indexOffset, GetIndexData().data(), sizeof(int) * GetIndexCount(), dstStages, dstAccess);
+	}
+	return ticket;
+}
+
+size_t VulkanMesh::InitGPUBuffer(VulkanRenderer* renderer, vk::BufferUsageFlags extraUses, std::vector<const char*>& attributeDataSources) {
 	usedAttributes.clear();
 	attributeBindings.clear();
 	attributeDescriptions.clear();
 
 	vk::Device sourceDevice = renderer->GetDevice();
 
-	std::vector<const char*> attributeDataSources;//Pointer for each attribute in CPU memory
+	attributeDataSources.clear();//Pointer for each attribute in CPU memory
 
 	size_t vSize = 0;
 
@@ -129,8 +177,6 @@ void VulkanMesh::UploadToGPU(VulkanRenderer* renderer, VkQueue queue, vk::Comman
 	size_t indexDataSize	= sizeof(int) * GetIndexCount();
 	size_t totalAllocationSize = vertexDataSize + indexDataSize;
 
-	assert(stagingBuffer.size >= (totalAllocationSize));
-
 	gpuBuffer = BufferBuilder(sourceDevice, renderer->GetMemoryAllocator())
 		.WithBufferUsage(	vk::BufferUsageFlagBits::eVertexBuffer	| 
 							vk::BufferUsageFlagBits::eIndexBuffer	| 
@@ -139,33 +185,20 @@ void VulkanMesh::UploadToGPU(VulkanRenderer* renderer, VkQueue queue, vk::Comman
 							extraUses)
 		.Build(totalAllocationSize, debugName + " mesh Data");
 
-	//need to now copy vertex data to device memory
-	char* dataPtr = (char*)stagingBuffer.Map();
 	size_t offset = 0;
 	for (size_t i = 0; i < usedAttributes.size(); ++i) {
 		//We're going to use the same buffer for every attribute
 		usedBuffers.push_back(gpuBuffer.buffer);
 		//But each attribute starts at a different offset
 		usedOffsets.push_back(offset);
-		//Copy the data from CPU to GPU-visible memory
-		size_t copySize = GetVertexCount() * attributeSizes[usedAttributes[i]];
-		memcpy(dataPtr + offset, attributeDataSources[i], copySize);
-		offset += copySize;
+		offset += GetVertexCount() * attributeSizes[usedAttributes[i]];
 	}
 	
 	if (GetIndexCount() > 0) {
-		memcpy(dataPtr + offset, GetIndexData().data(), indexDataSize);
 		indexType		= vk::IndexType::eUint32;	
 		indexOffset		= offset;
 	}
-	stagingBuffer.Unmap();
-
-	{//Now to transfer the mesh data from the staging buffer to the gpu-only buffer
-		vk::BufferCopy copyRegion;
-		copyRegion.size = vertexDataSize + indexDataSize;
-		cmdBuffer.copyBuffer(stagingBuffer.buffer, gpuBuffer.buffer, copyRegion);
-	}
-
+	return totalAllocationSize;
 }
 
 void VulkanMesh::BindToCommandBuffer(vk::CommandBuffer  buffer) const {
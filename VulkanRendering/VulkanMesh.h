@@ -8,6 +8,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 #pragma once
 #include "../NCLCoreClasses/Mesh.h"
 #include "VulkanBuffers.h"
+#include "VulkanStreamingUploader.h"
 
 namespace NCL::Rendering::Vulkan {
 	class VulkanMesh : public Mesh {
@@ -30,6 +31,9 @@ namespace NCL::Rendering::Vulkan {
 		void UploadToGPU(RendererBase* renderer, vk::BufferUsageFlags extraUses);
 		void UploadToGPU(VulkanRenderer* renderer, VkQueue queue, vk::CommandBuffer buffer, VulkanBuffer& stagingBuffer, vk::BufferUsageFlags extraUses = {});
 
+		//Uploads on the copy queue instead, without waiting. Don't draw the mesh until the ticket IsReady
+		StreamingUploader::Ticket StreamToGPU(VulkanRenderer* renderer, vk::BufferUsageFlags extraUses = {});
+
 		uint32_t	GetAttributeMask() const;
 		size_t		CalculateGPUAllocationSize() const;
 		vk::PrimitiveTopology GetVulkanTopology() const;
@@ -46,6 +50,9 @@ namespace NCL::Rendering::Vulkan {
 		bool GetAttributeInformation(VertexAttribute::Type v, vk::Buffer& outBuffer, uint32_t& outOffset, uint32_t& outRange, vk::Format& outFormat) const;
 
 	protected:
+		//Sets up the vertex layout and creates the buffer, returning its size
+		size_t InitGPUBuffer(VulkanRenderer* renderer, vk::BufferUsageFlags extraUses, std::vector<const char*>& attributeDataSources);
+
 		vk::PipelineVertexInputStateCreateInfo				vertexInputState;
 		std::vector<vk::VertexInputAttributeDescription>	attributeDescriptions;
 		std::vector<vk::VertexInputBindingDescription>		attributeBindings;		
@@ -0,0 +1,112 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanParallelRecorder.h"
+#include "VulkanThreadPool.h"
+#include "VulkanUtils.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+ParallelRecorder::ParallelRecorder(vk::Device device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t slotCount) {
+	this->device	= device;
+	this->slotCount = slotCount > 0 ? slotCount : std::max(ThreadPool::Shared().GetThreadCount(), 1u);
+	currentFrame	= 0;
+
+	frames.resize(framesInFlight);
+	for (uint32_t f = 0; f < framesInFlight; ++f) {
+		frames[f].resize(this->slotCount);
+		for (uint32_t s = 0; s < this->slotCount; ++s) {
+			//Transient, as everything recorded from here is thrown away once the frame is done
+			frames[f][s].pool = device.createCommandPoolUnique({
+				.flags				= vk::CommandPoolCreateFlagBits::eTransient,
+				.queueFamilyIndex	= queueFamily
+			});
+			SetDebugName(device, vk::ObjectType::eCommandPool, GetVulkanHandle(*frames[f][s].pool), "Parallel recording frame " + std::to_string(f) + " slot " + std::to_string(s));
+		}
+	}
+}
+
+ParallelRecorder::~ParallelRecorder() {
+}
+
+void ParallelRecorder::BeginFrame(uint32_t frameIndex) {
+	currentFrame = frameIndex;
+	//Resetting the pool resets every buffer from it in one go, they're then reused in the same order
+	for (Slot& s : frames[currentFrame]) {
+		if (s.used > 0) {
+			device.resetCommandPool(*s.pool);
+		}
+		s.used = 0;
+	}
+}
+
+vk::CommandBuffer ParallelRecorder::BeginSecondary(uint32_t slot, const SecondaryRenderingInfo& info) {
+	Slot& s = frames[currentFrame][slot];
+	if (s.used == s.buffers.size()) {
+		s.buffers.push_back(device.allocateCommandBuffers({
+			.commandPool		= *s.pool,
+			.level				= vk::CommandBufferLevel::eSecondary,
+			.commandBufferCount = 1
+		})[0]);
+	}
+	vk::CommandBuffer cmds = s.buffers[s.used++];
+
+	vk::CommandBufferInheritanceRenderingInfo renderingInheritance = {
+		.colorAttachmentCount		= (uint32_t)info.colourFormats.size(),
+		.pColorAttachmentFormats	= info.colourFormats.data(),
+		.depthAttachmentFormat		= info.depthFormat,
+		.stencilAttachmentFormat	= info.stencilFormat,
+		.rasterizationSamples		= vk::SampleCountFlagBits::e1
+	};
+	vk::CommandBufferInheritanceInfo inheritance = {
+		.pNext = &renderingInheritance
+	};
+	cmds.begin({
+		.flags				= vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+		.pInheritanceInfo	= &inheritance
+	});
+	cmds.setViewport(0, 1, &info.viewport);
+	cmds.setScissor(0, 1, &info.scissor);
+	return cmds;
+}
+
+void ParallelRecorder::Record(vk::CommandBuffer primary, const SecondaryRenderingInfo& info, uint32_t itemCount, const RecordFunc& func, uint32_t minItemsPerRange) {
+	if (itemCount == 0) {
+		return;
+	}
+	minItemsPerRange		= std::max(minItemsPerRange, 1u);
+	uint32_t rangeCount		= std::clamp((itemCount + minItemsPerRange - 1) / minItemsPerRange, 1u, slotCount);
+	uint32_t itemsPerRange	= (itemCount + rangeCount - 1) / rangeCount;
+	rangeCount				= (itemCount + itemsPerRange - 1) / itemsPerRange;
+
+	//Range i always records with slot i, so no two threads ever share a pool
+	std::vector<vk::CommandBuffer>			secondaries(rangeCount);
+	std::vector<ThreadPool::TaskHandle>		recordings;
+	for (uint32_t i = 0; i < rangeCount; ++i) {
+		uint32_t first = i * itemsPerRange;
+		uint32_t count = std::min(itemsPerRange, itemCount - first);
+		recordings.push_back(ThreadPool::Shared().Schedule([&, i, first, count]() {
+			secondaries[i] = BeginSecondary(i, info);
+			try {
+				func(secondaries[i], first, count);
+			}
+			catch (...) {
+				secondaries[i].end();	//Never executed, but not left recording either
+				throw;
+			}
+			secondaries[i].end();
+		}));
+	}
+	//The render thread records ranges too, rather than just waiting for the workers. If a range threw,
+	//this rethrows it once they've all finished, so nothing half recorded is executed on the primary
+	ThreadPool::Shared().WaitAll(recordings);
+	primary.executeCommands(secondaries);
+}
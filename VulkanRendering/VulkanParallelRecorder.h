@@ -0,0 +1,70 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <functional>
+
+namespace NCL::Rendering::Vulkan {
+	//What a secondary command buffer needs to know about the dynamic rendering it'll be executed inside of
+	struct SecondaryRenderingInfo {
+		std::vector<vk::Format>	colourFormats;
+		vk::Format				depthFormat		= vk::Format::eUndefined;
+		vk::Format				stencilFormat	= vk::Format::eUndefined;
+
+		//Viewport and scissor aren't inherited, so each secondary buffer sets them itself
+		vk::Viewport			viewport;
+		vk::Rect2D				scissor;
+	};
+
+	/*
+	ParallelRecorder: Splits up recording a long list of draws across the
+	shared ThreadPool. Command pools can only be used by one thread at a
+	time, so there's a pool for every worker 'slot' in each frame in flight,
+	and each worker records its range of the list into a secondary command
+	buffer from its own slot. The secondaries are then executed in order on
+	the primary, so the result is just as if it was all recorded in one go.
+
+	The primary must be inside a beginRendering using the
+	eContentsSecondaryCommandBuffers flag, and can't draw anything itself
+	until that rendering ends. Nothing bound on the primary is inherited,
+	so each range has to bind its own pipeline and descriptor sets.
+	*/
+	class ParallelRecorder	{
+	public:
+		using RecordFunc = std::function<void(vk::CommandBuffer cmds, uint32_t first, uint32_t count)>;
+
+		//0 slots means one per thread in the shared ThreadPool
+		ParallelRecorder(vk::Device device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t slotCount = 0);
+		~ParallelRecorder();
+
+		//Only once the frame's fence has signalled - VulkanRenderer does this in BeginFrame
+		void BeginFrame(uint32_t frameIndex);
+
+		//Records items [0, itemCount) in ranges of at least minItemsPerRange, then executes them all on the primary
+		void Record(vk::CommandBuffer primary, const SecondaryRenderingInfo& info, uint32_t itemCount, const RecordFunc& func, uint32_t minItemsPerRange = 16);
+
+		//A secondary buffer from this slot's pool, begun and ready to record. A slot may only be used by one thread at a time
+		vk::CommandBuffer BeginSecondary(uint32_t slot, const SecondaryRenderingInfo& info);
+
+		uint32_t GetSlotCount() const {
+			return slotCount;
+		}
+
+	protected:
+		struct Slot {
+			vk::UniqueCommandPool				pool;
+			std::vector<vk::CommandBuffer>		buffers;
+			size_t								used = 0;
+		};
+
+		vk::Device		device;
+		uint32_t		slotCount;
+		uint32_t		currentFrame;
+
+		std::vector<std::vector<Slot>>	frames;
+	};
+}
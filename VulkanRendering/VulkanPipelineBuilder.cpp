@@ -9,6 +9,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "VulkanMesh.h"
 #include "VulkanShader.h"
 #include "VulkanUtils.h"
+#include "VulkanProfiler.h"
 
 using namespace NCL;
 using namespace Rendering;
@@ -164,17 +165,26 @@ PipelineBuilder& PipelineBuilder::WithTessellationPatchVertexCount(uint32_t cont
 }
 
 VulkanPipeline	PipelineBuilder::Build(const std::string& debugName, vk::PipelineCache cache) {
+	PROFILE_SCOPE("PipelineBuilder::Build", debugName);
 	blendCreate.setAttachments(blendAttachStates);
 	blendCreate.setBlendConstants({ 1.0f, 1.0f, 1.0f, 1.0f });
 
-	vk::Format stencilRenderingFormat = vk::Format::eUndefined; //TODO
+	//A combined depth/stencil format is bound as both attachments, so the pipeline has to match
+	vk::Format stencilRenderingFormat = FormatHasStencil(depthRenderingFormat) ? depthRenderingFormat : vk::Format::eUndefined;
 
 	VulkanPipeline output;
 
 	FinaliseDescriptorLayouts();
 
+	//Point at our own members again, in case this builder is a copy made for BuildAsync
+	dynamicCreate.setPDynamicStates(dynamicStateEnables);
+	if (tessellationCreate.patchControlPoints > 0) {
+		pipelineCreate.setPTessellationState(&tessellationCreate);
+	}
+
 	pipelineCreate.setPColorBlendState(&blendCreate)
 		.setPDepthStencilState(&depthStencilCreate)
+		.setPViewportState(&viewportCreate)
 		.setPDynamicState(&dynamicCreate)
 		.setPInputAssemblyState(&inputAsmCreate)
 		.setPMultisampleState(&sampleCreate)
@@ -208,7 +218,7 @@ VulkanPipeline	PipelineBuilder::Build(const std::string& debugName, vk::Pipeline
 		pipelineCreate.pNext = &renderingCreate;
 	}
 
-	output.pipeline			= sourceDevice.createGraphicsPipelineUnique(cache, pipelineCreate).value;
+	output.pipeline			= sourceDevice.createGraphicsPipelineUnique(ResolvePipelineCache(cache), pipelineCreate).value;
 
 	if (!debugName.empty()) {
 		SetDebugName(sourceDevice, vk::ObjectType::ePipeline	  , GetVulkanHandle(*output.pipeline), debugName);
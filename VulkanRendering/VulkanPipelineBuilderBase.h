@@ -8,7 +8,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 #pragma once
 #include "VulkanPipeline.h"
 #include "VulkanUtils.h"
-
+#include "VulkanThreadPool.h"
 
 namespace NCL::Rendering::Vulkan {
 	class VulkanRenderer;
@@ -47,6 +47,23 @@ namespace NCL::Rendering::Vulkan {
 			return (T&)*this;
 		}
 
+		//Compiles the pipeline on the shared thread pool. The builder's state is copied into the task,
+		//but any shaders and vertex specifications it refers to must stay alive until the result is ready
+		std::future<VulkanPipeline> BuildAsync(const std::string& debugName = "", vk::PipelineCache cache = {}) {
+			auto builder = std::make_shared<T>((T&)*this);
+			return ThreadPool::Shared().Submit([builder, debugName, cache]() {
+				return builder->Build(debugName, cache);
+			});
+		}
+
+		//As above, but the pipeline is moved straight into output. Wait on the returned future before output is used
+		std::future<void> BuildAsync(VulkanPipeline& output, const std::string& debugName = "", vk::PipelineCache cache = {}) {
+			auto builder = std::make_shared<T>((T&)*this);
+			return ThreadPool::Shared().Submit([builder, &output, debugName, cache]() {
+				output = builder->Build(debugName, cache);
+			});
+		}
+
 		P& GetCreateInfo() {
 			return pipelineCreate;
 		}
@@ -56,6 +73,10 @@ namespace NCL::Rendering::Vulkan {
 		}
 		~PipelineBuilderBase() {}
 
+		vk::PipelineCache ResolvePipelineCache(vk::PipelineCache cache) const {
+			return cache ? cache : Vulkan::GetDefaultPipelineCache(sourceDevice);
+		}
+
 		void FinaliseDescriptorLayouts() {
 			allLayouts.clear();
 			for (int i = 0; i < reflectionLayouts.size(); ++i) {
@@ -0,0 +1,329 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+namespace {
+	//Per thread, so about 2.5MB for each thread that records anything
+	const uint32_t EVENTS_PER_THREAD = 32 * 1024;
+	const uint32_t GPU_THREAD_ID = 1000;
+
+	struct Event {
+		const char* name;
+		uint64_t	start;
+		uint64_t	end;
+		char		detail[Profiler::MAX_DETAIL];
+	};
+
+	//Only the owning thread writes to this. The count is published with release, so the exporter
+	//can read everything below it once it has loaded it with acquire
+	struct ThreadEvents {
+		uint32_t				threadID = 0;
+		std::string				threadName;
+		std::atomic<uint64_t>	generation	= 0;
+		std::atomic<uint32_t>	count		= 0;
+		std::atomic<uint32_t>	dropped		= 0;
+		std::unique_ptr<Event[]> events;
+	};
+
+	struct GPUEvent {
+		const char* name;
+		uint64_t	gpuStart;
+		uint64_t	gpuEnd;
+		uint64_t	submitTime;
+	};
+
+	struct CounterEvent {
+		const char* name;
+		uint64_t	value;
+		uint64_t	time;
+	};
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	std::atomic<uint64_t>	captureGeneration	= 0;
+	uint64_t				captureStart		= 0;
+
+	//Locked when a thread records for the first time, and when exporting - never per zone
+	std::mutex									threadListLock;
+	std::vector<std::unique_ptr<ThreadEvents>>	threadList;
+
+	std::mutex				gpuEventLock;
+	std::vector<GPUEvent>	gpuEvents;
+
+	std::mutex					counterEventLock;
+	std::vector<CounterEvent>	counterEvents;
+
+	//The list keeps them alive after their thread has gone, so its zones can still be exported
+	thread_local ThreadEvents* localEvents = nullptr;
+
+	ThreadEvents& GetLocalEvents() {
+		if (!localEvents) {
+			std::lock_guard guard(threadListLock);
+			threadList.push_back(std::make_unique<ThreadEvents>());
+			localEvents = threadList.back().get();
+			localEvents->threadID = (uint32_t)threadList.size();
+		}
+		return *localEvents;
+	}
+
+	void WriteEscaped(std::ostream& out, const char* text) {
+		for (const char* c = text; *c; ++c) {
+			switch (*c) {
+				case '"':	out << "\\\""; break;
+				case '\\':	out << "\\\\"; break;
+				case '\n':	out << "\\n"; break;
+				default:	out << *c;
+			}
+		}
+	}
+
+	//Chrome traces are in microseconds, relative to the start of the capture
+	double ToTraceTime(uint64_t ns) {
+		return ns > captureStart ? (ns - captureStart) / 1000.0 : 0.0;
+	}
+}
+
+std::atomic<bool> Profiler::capturing = false;
+
+uint64_t Profiler::Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Profiler::BeginCapture() {
+	if (IsCapturing()) {
+		return;
+	}
+	{
+		std::lock_guard guard(gpuEventLock);
+		gpuEvents.clear();
+	}
+	{
+		std::lock_guard guard(counterEventLock);
+		counterEvents.clear();
+	}
+	captureStart = Now();
+	captureGeneration++;	//Each thread empties its buffer the next time it records
+	capturing = true;
+	std::cout << __FUNCTION__ << " Profiler capture started\n";
+}
+
+void Profiler::SetThreadName(const std::string& name) {
+	ThreadEvents& events = GetLocalEvents();
+	std::lock_guard guard(threadListLock);
+	events.threadName = name;
+}
+
+void Profiler::RecordZone(const char* name, const char* detail, uint64_t start, uint64_t end) {
+	ThreadEvents& t = GetLocalEvents();
+
+	uint64_t generation = captureGeneration.load(std::memory_order_acquire);
+	if (t.generation.load(std::memory_order_relaxed) != generation) {
+		if (!t.events) {
+			t.events = std::make_unique<Event[]>(EVENTS_PER_THREAD);
+		}
+		t.count.store(0, std::memory_order_relaxed);
+		t.dropped.store(0, std::memory_order_relaxed);
+		t.generation.store(generation, std::memory_order_release);
+	}
+	uint32_t index = t.count.load(std::memory_order_relaxed);
+	if (index >= EVENTS_PER_THREAD) {
+		t.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	Event& e = t.events[index];
+	e.name	= name;
+	e.start = start;
+	e.end	= end;
+	memcpy(e.detail, detail, Profiler::MAX_DETAIL);
+	t.count.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::RecordGPUZone(const char* name, uint64_t gpuStart, uint64_t gpuEnd, uint64_t submitTime) {
+	std::lock_guard guard(gpuEventLock);
+	gpuEvents.push_back({ name, gpuStart, gpuEnd, submitTime });
+}
+
+void Profiler::RecordCounter(const char* name, uint64_t value, uint64_t time) {
+	std::lock_guard guard(counterEventLock);
+	counterEvents.push_back({ name, value, time });
+}
+
+bool Profiler::EndCapture(const std::string& filename) {
+	if (!IsCapturing()) {
+		return false;
+	}
+	capturing = false;
+
+	std::ofstream file(filename);
+	if (!file) {
+		std::cout << __FUNCTION__ << " Can't open " << filename << " for writing!\n";
+		return false;
+	}
+	file << std::fixed << std::setprecision(3);	//Down to the nanosecond, without going exponential on long captures
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"NCL Vulkan\"}}";
+
+	uint64_t	generation	= captureGeneration.load();
+	uint32_t	zoneCount	= 0;
+	uint32_t	dropCount	= 0;
+	{
+		std::lock_guard guard(threadListLock);
+		for (const auto& t : threadList) {
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t->threadID << ",\"args\":{\"name\":\"";
+			WriteEscaped(file, t->threadName.empty() ? ("Thread " + std::to_string(t->threadID)).c_str() : t->threadName.c_str());
+			file << "\"}}";
+
+			if (t->generation.load(std::memory_order_acquire) != generation) {
+				continue;	//Hasn't recorded anything this capture
+			}
+			uint32_t count = t->count.load(std::memory_order_acquire);
+			for (uint32_t i = 0; i < count; ++i) {
+				const Event& e = t->events[i];
+				file << ",\n{\"name\":\"";
+				WriteEscaped(file, e.name);
+				file << "\",\"cat\":\"CPU\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t->threadID
+					<< ",\"ts\":" << ToTraceTime(e.start) << ",\"dur\":" << (e.end - e.start) / 1000.0;
+				if (e.detail[0]) {
+					file << ",\"args\":{\"detail\":\"";
+					WriteEscaped(file, e.detail);
+					file << "\"}";
+				}
+				file << "}";
+			}
+			zoneCount += count;
+			dropCount += t->dropped.load(std::memory_order_relaxed);
+		}
+	}
+	{
+		std::lock_guard guard(gpuEventLock);
+		if (!gpuEvents.empty()) {
+			//The GPU can't start on a frame before it has been submitted, so the smallest gap between the two
+			//is about as close as we can get to where the GPU's clock sits on ours
+			int64_t gpuOffset = INT64_MAX;
+			for (const GPUEvent& e : gpuEvents) {
+				gpuOffset = std::min(gpuOffset, (int64_t)e.gpuStart - (int64_t)e.submitTime);
+			}
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID << ",\"args\":{\"name\":\"GPU\"}}";
+			for (const GPUEvent& e : gpuEvents) {
+				file << ",\n{\"name\":\"";
+				WriteEscaped(file, e.name);
+				file << "\",\"cat\":\"GPU\",\"ph\":\"X\",\"pid\":1,\"tid\":" << GPU_THREAD_ID
+					<< ",\"ts\":" << ToTraceTime(e.gpuStart - gpuOffset) << ",\"dur\":" << (e.gpuEnd - e.gpuStart) / 1000.0 << "}";
+			}
+			zoneCount += (uint32_t)gpuEvents.size();
+		}
+	}
+	{
+		std::lock_guard guard(counterEventLock);
+		for (const CounterEvent& e : counterEvents) {
+			file << ",\n{\"name\":\"";
+			WriteEscaped(file, e.name);
+			file << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << ToTraceTime(e.time) << ",\"args\":{\"value\":" << e.value << "}}";
+		}
+	}
+	file << "\n]}\n";
+
+	std::cout << __FUNCTION__ << " Wrote " << zoneCount << " zones to " << filename << "\n";
+	if (dropCount > 0) {
+		std::cout << __FUNCTION__ << " " << dropCount << " zones were dropped, as their thread ran out of space\n";
+	}
+	return true;
+}
+
+GPUProfiler::GPUProfiler(vk::Device device, uint32_t framesInFlight, float timestampPeriod, bool timestampsSupported, uint32_t maxZonesPerFrame) {
+	this->device			= device;
+	this->timestampPeriod	= timestampPeriod;
+	queriesPerFrame			= maxZonesPerFrame * 2;
+
+	if (timestampsSupported) {
+		queryPool = device.createQueryPoolUnique({
+			.queryType	= vk::QueryType::eTimestamp,
+			.queryCount = queriesPerFrame * framesInFlight
+		});
+	}
+	frames.resize(framesInFlight);
+}
+
+void GPUProfiler::BeginFrame(vk::CommandBuffer cmds, uint32_t frameIndex) {
+	currentFrame = frameIndex;
+	FrameZones& frame = frames[frameIndex];
+	uint32_t firstQuery = frameIndex * queriesPerFrame;
+
+	if (frame.active && frame.queriesUsed > 0 && Profiler::IsCapturing()) {
+		std::vector<uint64_t> stamps(frame.queriesUsed);
+		vk::Result result = device.getQueryPoolResults(*queryPool, firstQuery, frame.queriesUsed,
+			stamps.size() * sizeof(uint64_t), stamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+		if (result == vk::Result::eSuccess) {
+			for (const Zone& z : frame.zones) {
+				if (z.endQuery == 0) {
+					continue;	//Never ended, so there's nothing to measure
+				}
+				Profiler::RecordGPUZone(z.name,
+					(uint64_t)(stamps[z.startQuery] * (double)timestampPeriod),
+					(uint64_t)(stamps[z.endQuery] * (double)timestampPeriod), frame.submitTime);
+			}
+		}
+	}
+	frame.zones.clear();
+	frame.openZones.clear();
+	frame.queriesUsed = 0;
+	frame.pendingEnds = 0;
+	frame.active = queryPool && Profiler::IsCapturing();
+
+	if (frame.active) {
+		cmds.resetQueryPool(*queryPool, firstQuery, queriesPerFrame);
+	}
+}
+
+void GPUProfiler::OnSubmit(uint32_t frameIndex) {
+	frames[frameIndex].submitTime = Profiler::Now();
+}
+
+void GPUProfiler::BeginZone(vk::CommandBuffer cmds, const char* name) {
+	FrameZones& frame = frames[currentFrame];
+	if (!frame.active) {
+		return;
+	}
+	frame.openZones.push_back((uint32_t)frame.zones.size());
+	frame.zones.push_back({ name, frame.queriesUsed, 0 });
+	//Every zone still open needs a query left for its end
+	if (frame.queriesUsed + frame.pendingEnds + 2 > queriesPerFrame) {
+		frame.zones.back().startQuery = UINT32_MAX;	//Still tracked, so the matching EndZone has something to pop
+		return;
+	}
+	frame.pendingEnds++;
+	cmds.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queryPool, currentFrame * queriesPerFrame + frame.queriesUsed);
+	frame.queriesUsed++;
+}
+
+void GPUProfiler::EndZone(vk::CommandBuffer cmds) {
+	FrameZones& frame = frames[currentFrame];
+	if (!frame.active || frame.openZones.empty()) {
+		return;
+	}
+	Zone& z = frame.zones[frame.openZones.back()];
+	frame.openZones.pop_back();
+	if (z.startQuery == UINT32_MAX) {
+		return;
+	}
+	frame.pendingEnds--;
+	z.endQuery = frame.queriesUsed;
+	cmds.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, currentFrame * queriesPerFrame + frame.queriesUsed);
+	frame.queriesUsed++;
+}
@@ -0,0 +1,160 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <atomic>
+#include <cstring>
+#include <string>
+
+namespace NCL::Rendering::Vulkan {
+	/*
+	Profiler: Records how long scoped zones of CPU work take, on every
+	thread, and writes them out as a Chrome trace - open the file in
+	chrome://tracing or ui.perfetto.dev to see it as a timeline.
+
+	Nothing is recorded until BeginCapture is called. Until then a zone
+	costs a single relaxed atomic load, so the macros can be left in hot
+	code. While capturing, each thread writes into its own fixed size
+	buffer without taking any locks; a thread that fills its buffer drops
+	whatever comes after, and the count dropped is reported on export.
+
+	Zone names must outlive the capture, so are expected to be string
+	literals. Anything that changes per call, like a filename, can go in
+	the detail string, which is copied (and cut short if need be).
+
+	GPU zones come from GPUProfiler, and are moved onto the CPU timeline
+	when the trace is written, so both show up together.
+	*/
+	namespace Profiler {
+		const size_t MAX_DETAIL = 48;
+
+		extern std::atomic<bool> capturing;
+
+		inline bool IsCapturing() {
+			return capturing.load(std::memory_order_relaxed);
+		}
+
+		//Nanoseconds since the profiler was first used
+		uint64_t Now();
+
+		void BeginCapture();
+		//Stops capturing, and writes everything recorded since BeginCapture to the file
+		bool EndCapture(const std::string& filename);
+
+		//Shown against the thread's track in the trace, rather than just its number
+		void SetThreadName(const std::string& name);
+
+		void RecordZone(const char* name, const char* detail, uint64_t start, uint64_t end);
+		//GPU times are in nanoseconds on the GPU's clock. submitTime is when the work was handed to the queue, on ours
+		void RecordGPUZone(const char* name, uint64_t gpuStart, uint64_t gpuEnd, uint64_t submitTime);
+		//Drawn as a graph above the thread tracks, with the value stepping to each new one as it's recorded
+		void RecordCounter(const char* name, uint64_t value, uint64_t time);
+	}
+
+	class ProfileZone {
+	public:
+		ProfileZone(const char* name, const char* inDetail = nullptr) {
+			if (Profiler::IsCapturing()) {
+				this->name	= name;
+				size_t length = 0;
+				if (inDetail) {
+					length = strnlen(inDetail, Profiler::MAX_DETAIL - 1);
+					memcpy(detail, inDetail, length);
+				}
+				detail[length] = '\0';
+				start = Profiler::Now();
+			}
+		}
+		ProfileZone(const char* name, const std::string& inDetail) : ProfileZone(name, inDetail.c_str()) {
+		}
+		~ProfileZone() {
+			if (name) {
+				Profiler::RecordZone(name, detail, start, Profiler::Now());
+			}
+		}
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	protected:
+		const char* name	= nullptr;
+		uint64_t	start	= 0;
+		char		detail[Profiler::MAX_DETAIL];	//Copied, as it's often a temporary string
+	};
+
+	/*
+	Times regions of a frame's command buffer with timestamp queries. The
+	renderer owns one, and wraps each frame in a zone of its own - others
+	can be nested inside it with PROFILE_GPU_SCOPE.
+
+	Queries are only written for frames begun while a capture is running,
+	and are read back once the frame's fence has been waited on, the next
+	time its frame in flight comes round.
+	*/
+	class GPUProfiler {
+	public:
+		GPUProfiler(vk::Device device, uint32_t framesInFlight, float timestampPeriod, bool timestampsSupported, uint32_t maxZonesPerFrame = 64);
+		~GPUProfiler() = default;
+
+		//Passes on the zones recorded last time this frame in flight was used, and starts recording new ones
+		void BeginFrame(vk::CommandBuffer cmds, uint32_t frameIndex);
+		//Called just before the frame is submitted, to line its zones up with the CPU's
+		void OnSubmit(uint32_t frameIndex);
+
+		void BeginZone(vk::CommandBuffer cmds, const char* name);
+		void EndZone(vk::CommandBuffer cmds);
+
+	protected:
+		struct Zone {
+			const char* name;
+			uint32_t	startQuery;
+			uint32_t	endQuery;
+		};
+		struct FrameZones {
+			std::vector<Zone>		zones;
+			std::vector<uint32_t>	openZones;
+			uint32_t				queriesUsed = 0;
+			uint32_t				pendingEnds = 0;
+			uint64_t				submitTime	= 0;
+			bool					active		= false;
+		};
+
+		vk::Device				device;
+		vk::UniqueQueryPool		queryPool;
+		uint32_t				queriesPerFrame;
+		float					timestampPeriod;
+
+		std::vector<FrameZones>	frames;
+		uint32_t				currentFrame = 0;
+	};
+
+	class GPUProfileZone {
+	public:
+		GPUProfileZone(GPUProfiler& profiler, vk::CommandBuffer cmds, const char* name) : profiler(profiler), cmds(cmds) {
+			profiler.BeginZone(cmds, name);
+		}
+		~GPUProfileZone() {
+			profiler.EndZone(cmds);
+		}
+	protected:
+		GPUProfiler&		profiler;
+		vk::CommandBuffer	cmds;
+	};
+}
+
+#define NCL_PROFILE_JOIN_INNER(a, b) a##b
+#define NCL_PROFILE_JOIN(a, b) NCL_PROFILE_JOIN_INNER(a, b)
+
+#ifdef NCL_DISABLE_PROFILING
+#define PROFILE_SCOPE(...)
+#define PROFILE_FUNCTION()
+#define PROFILE_GPU_SCOPE(profiler, cmds, name)
+#else
+//PROFILE_SCOPE("Name") or PROFILE_SCOPE("Name", detailString)
+#define PROFILE_SCOPE(...)	::NCL::Rendering::Vulkan::ProfileZone NCL_PROFILE_JOIN(profileZone, __LINE__)(__VA_ARGS__)
+#define PROFILE_FUNCTION()	PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_GPU_SCOPE(profiler, cmds, name) ::NCL::Rendering::Vulkan::GPUProfileZone NCL_PROFILE_JOIN(gpuProfileZone, __LINE__)(profiler, cmds, name)
+#endif
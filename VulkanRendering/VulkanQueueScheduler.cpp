@@ -0,0 +1,168 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanQueueScheduler.h"
+#include "VulkanUtils.h"
+#include "VulkanProfiler.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+QueueScheduler::QueueScheduler(vk::Device device, std::span<const vk::Queue> queues) {
+	this->device = device;
+
+	assert(MessageAssert(queues.size() <= MaxQueues, "QueueScheduler given more queues than it has room for!"));
+	timelines.resize(queues.size());
+	for (size_t i = 0; i < queues.size(); ++i) {
+		vk::SemaphoreTypeCreateInfo typeInfo = {
+			.semaphoreType	= vk::SemaphoreType::eTimeline,
+			.initialValue	= 0
+		};
+		timelines[i].queue		= queues[i];
+		timelines[i].semaphore	= device.createSemaphoreUnique({ .pNext = &typeInfo });
+		SetDebugName(device, vk::ObjectType::eSemaphore, GetVulkanHandle(*timelines[i].semaphore), "Queue Timeline " + std::to_string(i));
+	}
+}
+
+QueueScheduler::~QueueScheduler() {
+	//Semaphores can't go while a submission might still signal them
+	std::vector<Point> lastPoints;
+	for (uint32_t i = 0; i < timelines.size(); ++i) {
+		lastPoints.push_back({ i, timelines[i].lastSubmitted });
+	}
+	if (!WaitForAll(lastPoints)) {
+		std::cout << __FUNCTION__ << " Queue submissions taking too long?\n";
+	}
+}
+
+QueueScheduler::Point QueueScheduler::Submit(uint32_t queue, std::span<const vk::CommandBuffer> cmds, std::span<const Wait> waits, vk::Fence fence) {
+	std::lock_guard guard(lock);
+
+	submitWaits.clear();
+	BuildWaits(queue, waits, submitWaits);
+
+	submitCmds.clear();
+	for (vk::CommandBuffer c : cmds) {
+		submitCmds.push_back({ .commandBuffer = c });
+	}
+
+	Timeline& t = timelines[queue];
+	Point point = { queue, t.lastSubmitted + 1 };
+
+	vk::SemaphoreSubmitInfo signalInfo = {
+		.semaphore	= *t.semaphore,
+		.value		= point.value,
+		.stageMask	= vk::PipelineStageFlagBits2::eAllCommands
+	};
+	vk::SubmitInfo2 submitInfo = {
+		.waitSemaphoreInfoCount		= (uint32_t)submitWaits.size(),
+		.pWaitSemaphoreInfos		= submitWaits.data(),
+		.commandBufferInfoCount		= (uint32_t)submitCmds.size(),
+		.pCommandBufferInfos		= submitCmds.data(),
+		.signalSemaphoreInfoCount	= 1,
+		.pSignalSemaphoreInfos		= &signalInfo
+	};
+	t.queue.submit2(submitInfo, fence);
+	t.lastSubmitted = point.value;
+	return point;
+}
+
+void QueueScheduler::WaitOnNextSubmit(uint32_t queue, const Wait& wait) {
+	std::lock_guard guard(lock);
+	timelines[queue].nextWaits.push_back(wait);
+}
+
+QueueScheduler::Point QueueScheduler::PrepareSubmit(uint32_t queue, std::vector<vk::SemaphoreSubmitInfo>& waitInfos, vk::SemaphoreSubmitInfo& signalInfo) {
+	std::lock_guard guard(lock);
+	BuildWaits(queue, {}, waitInfos);
+
+	Timeline& t = timelines[queue];
+	t.lastSubmitted++;
+
+	signalInfo = {
+		.semaphore	= *t.semaphore,
+		.value		= t.lastSubmitted,
+		.stageMask	= vk::PipelineStageFlagBits2::eAllCommands
+	};
+	return { queue, t.lastSubmitted };
+}
+
+void QueueScheduler::BuildWaits(uint32_t queue, std::span<const Wait> waits, std::vector<vk::SemaphoreSubmitInfo>& waitInfos) {
+	auto addWait = [&](const Wait& w) {
+		if (w.point.value == 0) {
+			return;
+		}
+		const Timeline& from = timelines[w.point.queue];
+		if (w.point.value > from.lastSubmitted) {
+			//Vulkan allows it, but if nothing ever signals the value the queue hangs, so it's almost certainly a mistake
+			std::cout << __FUNCTION__ << " Waiting on value " << w.point.value << " of queue " << w.point.queue << ", which hasn't been submitted yet!\n";
+		}
+		auto existing = std::ranges::find_if(waitInfos, [&](const vk::SemaphoreSubmitInfo& i) { return i.semaphore == *from.semaphore; });
+		if (existing != waitInfos.end()) {
+			existing->value		= std::max(existing->value, w.point.value);
+			existing->stageMask |= w.stages;
+			return;
+		}
+		waitInfos.push_back({
+			.semaphore	= *from.semaphore,
+			.value		= w.point.value,
+			.stageMask	= w.stages
+		});
+	};
+	for (const Wait& w : waits) {
+		addWait(w);
+	}
+	Timeline& t = timelines[queue];
+	for (const Wait& w : t.nextWaits) {
+		addWait(w);
+	}
+	t.nextWaits.clear();
+}
+
+bool QueueScheduler::IsReached(Point p) const {
+	return device.getSemaphoreCounterValue(*timelines[p.queue].semaphore) >= p.value;
+}
+
+bool QueueScheduler::WaitFor(Point p, uint64_t timeout) const {
+	return WaitForAll(std::span(&p, 1), timeout);
+}
+
+bool QueueScheduler::WaitForAll(std::span<const Point> points, uint64_t timeout) const {
+	PROFILE_FUNCTION();
+	//Only the highest value on each timeline matters, so there's never more than one wait per queue
+	uint64_t highest[MaxQueues] = {};
+	for (const Point& p : points) {
+		highest[p.queue] = std::max(highest[p.queue], p.value);
+	}
+	vk::Semaphore	semaphores[MaxQueues];
+	uint64_t		values[MaxQueues];
+	uint32_t		waitCount = 0;
+	for (uint32_t i = 0; i < timelines.size(); ++i) {
+		if (highest[i] > 0) {
+			semaphores[waitCount]	= *timelines[i].semaphore;
+			values[waitCount]		= highest[i];
+			waitCount++;
+		}
+	}
+	if (waitCount == 0) {
+		return true;
+	}
+	vk::SemaphoreWaitInfo waitInfo = {
+		.semaphoreCount = waitCount,
+		.pSemaphores	= semaphores,
+		.pValues		= values
+	};
+	return device.waitSemaphores(waitInfo, timeout) == vk::Result::eSuccess;
+}
+
+QueueScheduler::Point QueueScheduler::GetLastSubmitted(uint32_t queue) const {
+	std::lock_guard guard(lock);
+	return { queue, timelines[queue].lastSubmitted };
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <mutex>
+#include <span>
+
+namespace NCL::Rendering::Vulkan {
+	/*
+	QueueScheduler: Orders work across queues with a timeline semaphore
+	for each queue, rather than binary semaphores or waitIdle.
+
+	Every submission made through the scheduler signals the next value on
+	its queue's timeline, and is handed back as a Point - a queue and a
+	value, which is reached once that submission and everything before it
+	on the queue has finished. Submissions list the Points they need, and
+	the GPU holds them back until they've been reached, so work on other
+	queues can be queued up a frame or more ahead without the CPU waiting
+	on anything. The CPU can check or wait on any Point too, without having
+	to idle a whole queue.
+
+	Queues are indexed by CommandBuffer::Type. VulkanRenderer's own frame
+	submission signals the graphics timeline as well, and picks up any
+	waits added with WaitOnNextSubmit, so other queues can wait on a frame,
+	and a frame can wait on them.
+
+	Vulkan only lets one thread submit to a queue at a time, and timeline
+	values have to go up in the order they're submitted, so submissions
+	belong on the render thread. Points can be checked and waited on from
+	any thread. Needs the timelineSemaphore feature enabled.
+	*/
+	class QueueScheduler {
+	public:
+		struct Point {
+			uint32_t queue = 0;
+			uint64_t value = 0;	//Nothing is ever signalled as 0, so it's always been reached
+		};
+		struct Wait {
+			Point					point;
+			vk::PipelineStageFlags2 stages = vk::PipelineStageFlagBits2::eAllCommands;	//that have to wait, in the waiting submission
+		};
+
+		//Plenty for every CommandBuffer::Type, and lets host waits build their lists on the stack
+		static constexpr uint32_t MaxQueues = 8;
+
+		QueueScheduler(vk::Device device, std::span<const vk::Queue> queues);
+		~QueueScheduler();
+
+		//Returns the Point reached once cmds have finished
+		Point Submit(uint32_t queue, std::span<const vk::CommandBuffer> cmds, std::span<const Wait> waits = {}, vk::Fence fence = {});
+		Point Submit(uint32_t queue, vk::CommandBuffer cmds, std::initializer_list<Wait> waits = {}, vk::Fence fence = {}) {
+			return Submit(queue, std::span(&cmds, 1), std::span(waits.begin(), waits.size()), fence);
+		}
+
+		//Adds a wait to whatever is submitted to the queue next, for when that submission is made elsewhere
+		void WaitOnNextSubmit(uint32_t queue, const Wait& wait);
+
+		//For submitting to a queue without going through Submit. Adds the queue's waits onto waitInfos, and fills in
+		//the signal for the returned Point - which must be submitted before anything else goes to the queue
+		Point PrepareSubmit(uint32_t queue, std::vector<vk::SemaphoreSubmitInfo>& waitInfos, vk::SemaphoreSubmitInfo& signalInfo);
+
+		bool IsReached(Point p) const;
+		//Both return false if the timeout ran out first
+		bool WaitFor(Point p, uint64_t timeout = UINT64_MAX) const;
+		bool WaitForAll(std::span<const Point> points, uint64_t timeout = UINT64_MAX) const;
+
+		//Waiting on this waits on everything submitted to the queue so far
+		Point GetLastSubmitted(uint32_t queue) const;
+
+		vk::Semaphore GetSemaphore(uint32_t queue) const {
+			return *timelines[queue].semaphore;
+		}
+
+	protected:
+		struct Timeline {
+			vk::Queue				queue;
+			vk::UniqueSemaphore		semaphore;
+			uint64_t				lastSubmitted = 0;
+			std::vector<Wait>		nextWaits;
+		};
+
+		//Takes the queue's pending waits too. Waits on the same timeline are merged into one, on the highest value
+		void	BuildWaits(uint32_t queue, std::span<const Wait> waits, std::vector<vk::SemaphoreSubmitInfo>& waitInfos);
+
+		vk::Device				device;
+		std::vector<Timeline>	timelines;
+
+		//Reused by each Submit, so a steady stream of submissions doesn't allocate
+		std::vector<vk::SemaphoreSubmitInfo>		submitWaits;
+		std::vector<vk::CommandBufferSubmitInfo>	submitCmds;
+
+		mutable std::mutex		lock;
+	};
+}
@@ -0,0 +1,486 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanRenderGraph.h"
+#include "VulkanUtils.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+static const vk::AccessFlags2 writeAccessBits =
+	vk::AccessFlagBits2::eShaderWrite |
+	vk::AccessFlagBits2::eShaderStorageWrite |
+	vk::AccessFlagBits2::eColorAttachmentWrite |
+	vk::AccessFlagBits2::eDepthStencilAttachmentWrite |
+	vk::AccessFlagBits2::eTransferWrite |
+	vk::AccessFlagBits2::eHostWrite |
+	vk::AccessFlagBits2::eMemoryWrite;
+
+RenderGraph::Pass& RenderGraph::Pass::ColourAttachment(ResourceID id, bool load) {
+	vk::AccessFlags2 access = vk::AccessFlagBits2::eColorAttachmentWrite;
+	if (load) {
+		access |= vk::AccessFlagBits2::eColorAttachmentRead;
+	}
+	return AddAccess({ id, vk::PipelineStageFlagBits2::eColorAttachmentOutput, access, vk::ImageLayout::eColorAttachmentOptimal, load, true, !load });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::DepthAttachment(ResourceID id, bool load) {
+	return AddAccess({ id,
+		vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+		vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+		vk::ImageLayout::eDepthAttachmentOptimal, load, true, !load });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::SampledImage(ResourceID id, vk::PipelineStageFlags2 stages, vk::ImageLayout layout) {
+	return AddAccess({ id, stages, vk::AccessFlagBits2::eShaderSampledRead, layout, true, false, false });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::StorageImageRead(ResourceID id, vk::PipelineStageFlags2 stages) {
+	return AddAccess({ id, stages, vk::AccessFlagBits2::eShaderStorageRead, vk::ImageLayout::eGeneral, true, false, false });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::StorageImageWrite(ResourceID id, vk::PipelineStageFlags2 stages) {
+	return AddAccess({ id, stages, vk::AccessFlagBits2::eShaderStorageWrite, vk::ImageLayout::eGeneral, false, true, false });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::StorageImage(ResourceID id, vk::PipelineStageFlags2 stages) {
+	return AddAccess({ id, stages, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite, vk::ImageLayout::eGeneral, true, true, false });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::BufferRead(ResourceID id, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access) {
+	return AddAccess({ id, stages, access, vk::ImageLayout::eUndefined, true, false, false });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::BufferWrite(ResourceID id, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access) {
+	return AddAccess({ id, stages, access, vk::ImageLayout::eUndefined, false, true, false });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Read(ResourceID id, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access, vk::ImageLayout layout) {
+	return AddAccess({ id, stages, access, layout, true, false, false });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Write(ResourceID id, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access, vk::ImageLayout layout, bool discard) {
+	return AddAccess({ id, stages, access, layout, (access & ~writeAccessBits) != vk::AccessFlags2(), true, discard });
+}
+
+RenderGraph::Pass& RenderGraph::Pass::HasSideEffects() {
+	sideEffects = true;
+	return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::AddAccess(Access a) {
+	accesses.push_back(a);
+	return *this;
+}
+
+RenderGraph::RenderGraph() {
+	Reset();
+}
+
+RenderGraph::~RenderGraph() {
+}
+
+RenderGraph::ResourceID RenderGraph::ImportImage(const std::string& name, vk::Image image, vk::ImageAspectFlags aspects, vk::ImageLayout firstLayout) {
+	ResourceID id = ImportExternalImage(name, image, aspects, firstLayout);
+	resources[id].persistent = true;
+
+	auto i = imageStates.find(image);
+	if (i != imageStates.end()) {
+		resources[id].state = i->second;
+	}
+	return id;
+}
+
+RenderGraph::ResourceID RenderGraph::ImportExternalImage(const std::string& name, vk::Image image, vk::ImageAspectFlags aspects, vk::ImageLayout currentLayout) {
+	for (const Resource& r : resources) {
+		assert(MessageAssert(r.image != image, "RenderGraph image imported twice in the same frame!"));
+	}
+	Resource r;
+	r.name			= name;
+	r.image			= image;
+	r.aspects		= aspects;
+	r.state.layout	= currentLayout;
+	resources.push_back(r);
+	compiled = false;
+	return (ResourceID)resources.size() - 1;
+}
+
+RenderGraph::ResourceID RenderGraph::ImportBuffer(const std::string& name, vk::Buffer buffer) {
+	for (const Resource& r : resources) {
+		assert(MessageAssert(r.buffer != buffer, "RenderGraph buffer imported twice in the same frame!"));
+	}
+	Resource r;
+	r.name			= name;
+	r.buffer		= buffer;
+	r.persistent	= true;
+
+	auto i = bufferStates.find(buffer);
+	if (i != bufferStates.end()) {
+		r.state = i->second;
+	}
+	resources.push_back(r);
+	compiled = false;
+	return (ResourceID)resources.size() - 1;
+}
+
+RenderGraph::ResourceID RenderGraph::CreateTransientImage(const std::string& name, const TransientImageInfo& info) {
+	Resource r;
+	r.name			= name;
+	r.aspects		= info.aspects;
+	r.persistent	= true;
+	r.transient		= true;
+	r.transientInfo = info;
+	resources.push_back(r);
+	compiled = false;
+	return (ResourceID)resources.size() - 1;
+}
+
+void RenderGraph::MarkOutput(ResourceID id) {
+	resources[id].output = true;
+	compiled = false;
+}
+
+void RenderGraph::ForgetImage(vk::Image image) {
+	imageStates.erase(image);
+}
+
+void RenderGraph::ForgetBuffer(vk::Buffer buffer) {
+	bufferStates.erase(buffer);
+}
+
+RenderGraph::Pass& RenderGraph::AddPass(const std::string& name, PassFunc&& func) {
+	Pass& p = passes.emplace_back();
+	p.name = name;
+	p.func = std::move(func);
+	compiled = false;
+	return p;
+}
+
+void RenderGraph::Reset() {
+	resources.clear();
+	passes.clear();
+	batches.clear();
+	barrierCount	= 0;
+	culledCount		= 0;
+	compiled		= false;
+}
+
+bool RenderGraph::Compile() {
+	for (Pass& p : passes) {
+		for (Pass::Access& a : p.accesses) {
+			assert(MessageAssert(a.id < resources.size(), "RenderGraph pass uses a resource that was never imported!"));
+			//DepthAttachment can't see the image's aspects, and the layout has to cover the stencil too if there is one
+			if (a.layout == vk::ImageLayout::eDepthAttachmentOptimal && (resources[a.id].aspects & vk::ImageAspectFlagBits::eStencil)) {
+				a.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+			}
+		}
+	}
+	CullPasses();
+	SchedulePasses();
+	if (!PlaceTransients()) {
+		return false;
+	}
+	BuildBarriers();
+	compiled = true;
+	return true;
+}
+
+//Walks backwards from the outputs, keeping only the passes that write something a kept pass (or an output) needs
+void RenderGraph::CullPasses() {
+	std::set<ResourceID> needed;
+	for (ResourceID i = 0; i < resources.size(); ++i) {
+		if (resources[i].output) {
+			needed.insert(i);
+		}
+	}
+	culledCount = 0;
+	for (auto p = passes.rbegin(); p != passes.rend(); ++p) {
+		p->culled = !p->sideEffects;
+		for (const Pass::Access& a : p->accesses) {
+			if (a.writes && needed.contains(a.id)) {
+				p->culled = false;
+			}
+		}
+		if (p->culled) {
+			culledCount++;
+			continue;
+		}
+		//Anything this pass completely overwrites doesn't need whatever wrote it before
+		for (const Pass::Access& a : p->accesses) {
+			if (a.writes && a.discard) {
+				needed.erase(a.id);
+			}
+		}
+		for (const Pass::Access& a : p->accesses) {
+			if (a.reads) {
+				needed.insert(a.id);
+			}
+		}
+	}
+}
+
+/*
+Each pass goes in the earliest batch it can, which is after the last write to
+anything it touches, and, if it writes or needs a layout change, after the last
+read too. Passes sharing a batch don't depend on each other, so they can all
+run behind the one barrier.
+*/
+void RenderGraph::SchedulePasses() {
+	struct Tracking {
+		int				lastWrite	= -1;
+		int				lastRead	= -1;
+		int				transition	= -1;
+		vk::ImageLayout layout;
+	};
+	std::vector<Tracking> tracking(resources.size());
+	for (size_t i = 0; i < resources.size(); ++i) {
+		tracking[i].layout = resources[i].state.layout;
+	}
+
+	int levelCount = 0;
+	for (Pass& p : passes) {
+		if (p.culled) {
+			continue;
+		}
+		p.level = 0;
+		for (const Pass::Access& a : p.accesses) {
+			const Tracking& t = tracking[a.id];
+			bool transition = resources[a.id].image && a.layout != vk::ImageLayout::eUndefined && a.layout != t.layout;
+			if (a.writes || transition) {
+				p.level = std::max(p.level, std::max(t.lastWrite, t.lastRead) + 1);
+			}
+			else {
+				p.level = std::max({ p.level, t.lastWrite + 1, t.transition });
+			}
+		}
+		for (const Pass::Access& a : p.accesses) {
+			Tracking& t = tracking[a.id];
+			bool transition = resources[a.id].image && a.layout != vk::ImageLayout::eUndefined && a.layout != t.layout;
+			if (a.writes) {
+				t.lastWrite		= p.level;
+				t.lastRead		= -1;
+				t.transition	= -1;
+			}
+			else {
+				t.lastRead = std::max(t.lastRead, p.level);
+				if (transition) {
+					t.transition = p.level;
+				}
+			}
+			if (transition) {
+				t.layout = a.layout;
+			}
+		}
+		levelCount = std::max(levelCount, p.level + 1);
+	}
+
+	batches.clear();
+	batches.resize(levelCount);
+	for (uint32_t i = 0; i < passes.size(); ++i) {
+		if (!passes[i].culled) {
+			batches[passes[i].level].passes.push_back(i);
+		}
+	}
+}
+
+//Transients are only alive from the first batch that uses them to the last, anything outside that can share their memory
+bool RenderGraph::PlaceTransients() {
+	std::vector<TransientAllocator::Request>	requests;
+	std::vector<ResourceID>						requestIDs;
+
+	for (ResourceID id = 0; id < resources.size(); ++id) {
+		if (!resources[id].transient) {
+			continue;
+		}
+		uint32_t firstUse	= UINT32_MAX;
+		uint32_t lastUse	= 0;
+		for (uint32_t b = 0; b < batches.size(); ++b) {
+			for (uint32_t passID : batches[b].passes) {
+				for (const Pass::Access& a : passes[passID].accesses) {
+					if (a.id == id) {
+						firstUse	= std::min(firstUse, b);
+						lastUse		= std::max(lastUse, b);
+					}
+				}
+			}
+		}
+		if (firstUse == UINT32_MAX) {
+			continue; //Everything using it was culled, so it never needs to exist
+		}
+		requests.push_back({ resources[id].name, resources[id].transientInfo, firstUse, lastUse });
+		requestIDs.push_back(id);
+	}
+	if (!transientAllocator) {
+		assert(MessageAssert(requests.empty(), "RenderGraph has transient images, but no TransientAllocator!"));
+		return true;
+	}
+	const std::vector<TransientAllocator::Placement>& placements = transientAllocator->Place(requests);
+
+	if (transientAllocator->GetGeneration() != transientGeneration) {
+		for (vk::Image i : transientImages) {
+			ForgetImage(i);
+		}
+		transientImages.clear();
+		for (const TransientAllocator::Placement& p : placements) {
+			transientImages.push_back(p.image);
+		}
+		transientGeneration = transientAllocator->GetGeneration();
+	}
+	if (placements.size() != requests.size()) {
+		return false; //The allocator has already said why
+	}
+
+	for (size_t i = 0; i < requestIDs.size(); ++i) {
+		Resource& r = resources[requestIDs[i]];
+		r.placement = placements[i];
+		r.image		= placements[i].image;
+		r.view		= placements[i].view;
+
+		auto state = imageStates.find(r.image);
+		if (state != imageStates.end()) {
+			r.state = state->second;
+		}
+	}
+	return true;
+}
+
+void RenderGraph::BuildBarriers() {
+	barrierCount = 0;
+	for (Batch& b : batches) {
+		for (Resource& r : resources) {
+			r.batchBarrier = -1;
+		}
+		for (uint32_t passID : b.passes) {
+			for (const Pass::Access& a : passes[passID].accesses) {
+				Resource& r = resources[a.id];
+				if (r.transient && !r.firstUseDone) {
+					assert(MessageAssert(a.writes && a.discard, "Transient images must be completely overwritten by their first use!"));
+					//Whatever last used this memory, this frame or the last, has to finish before we overwrite it
+					for (const Resource& other : resources) {
+						if (&other != &r && other.transient && other.image && TransientAllocator::SharesMemory(r.placement, other.placement)) {
+							r.state.writeStages |= other.state.writeStages;
+							r.state.writeAccess |= other.state.writeAccess;
+							r.state.readStages	|= other.state.readStages;
+						}
+					}
+					r.state.layout	= vk::ImageLayout::eUndefined;
+					r.firstUseDone	= true;
+				}
+				AddDependency(b, r, a);
+			}
+		}
+		if (!b.imageBarriers.empty() || b.memoryBarrier.srcStageMask || b.memoryBarrier.dstStageMask) {
+			barrierCount++;
+		}
+	}
+}
+
+void RenderGraph::AddDependency(Batch& batch, Resource& r, const Pass::Access& a) {
+	ResourceState& s = r.state;
+	bool transition = r.image && a.layout != vk::ImageLayout::eUndefined && a.layout != s.layout;
+
+	if (transition) {
+		batch.imageBarriers.push_back({
+			.srcStageMask		= s.writeStages | s.readStages,
+			.srcAccessMask		= s.writeAccess,
+			.dstStageMask		= a.stages,
+			.dstAccessMask		= a.access,
+			.oldLayout			= a.discard ? vk::ImageLayout::eUndefined : s.layout,
+			.newLayout			= a.layout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image				= r.image,
+			.subresourceRange	= {
+				.aspectMask		= r.aspects,
+				.baseMipLevel	= 0,
+				.levelCount		= VK_REMAINING_MIP_LEVELS,
+				.baseArrayLayer = 0,
+				.layerCount		= VK_REMAINING_ARRAY_LAYERS
+			}
+		});
+		r.batchBarrier		= (int)batch.imageBarriers.size() - 1;
+		s.layout			= a.layout;
+		s.visibleStages		= a.stages;
+		s.visibleAccess		= a.access;
+		//Earlier readers are covered by the transition, later writers only need to wait on this access
+		s.readStages		= {};
+	}
+	else if (a.writes) {
+		if (s.writeStages || s.readStages) {
+			batch.memoryBarrier.srcStageMask	|= s.writeStages | s.readStages;
+			batch.memoryBarrier.srcAccessMask	|= s.writeAccess;
+			batch.memoryBarrier.dstStageMask	|= a.stages;
+			batch.memoryBarrier.dstAccessMask	|= a.access;
+		}
+	}
+	else if (s.writeStages && ((a.stages & ~s.visibleStages) || (a.access & ~s.visibleAccess))) {
+		if (r.batchBarrier >= 0) {
+			//Something earlier in the batch already transitioned it, so this access has to wait on that too
+			batch.imageBarriers[r.batchBarrier].dstStageMask	|= a.stages;
+			batch.imageBarriers[r.batchBarrier].dstAccessMask	|= a.access;
+		}
+		else {
+			batch.memoryBarrier.srcStageMask	|= s.writeStages;
+			batch.memoryBarrier.srcAccessMask	|= s.writeAccess;
+			batch.memoryBarrier.dstStageMask	|= a.stages;
+			batch.memoryBarrier.dstAccessMask	|= a.access;
+		}
+		s.visibleStages |= a.stages;
+		s.visibleAccess |= a.access;
+	}
+
+	if (a.writes) {
+		s.writeStages	= a.stages;
+		s.writeAccess	= a.access & writeAccessBits;
+		s.readStages	= {};
+		s.visibleStages = {};
+		s.visibleAccess = {};
+	}
+	else {
+		s.readStages |= a.stages;
+	}
+}
+
+void RenderGraph::Execute(vk::CommandBuffer cmdBuffer) {
+	if (!compiled && !Compile()) {
+		return;
+	}
+	for (const Batch& b : batches) {
+		bool hasMemoryBarrier = b.memoryBarrier.srcStageMask || b.memoryBarrier.dstStageMask;
+		if (hasMemoryBarrier || !b.imageBarriers.empty()) {
+			vk::DependencyInfo info;
+			info.memoryBarrierCount			= hasMemoryBarrier ? 1 : 0;
+			info.pMemoryBarriers			= &b.memoryBarrier;
+			info.imageMemoryBarrierCount	= (uint32_t)b.imageBarriers.size();
+			info.pImageMemoryBarriers		= b.imageBarriers.data();
+			cmdBuffer.pipelineBarrier2(info);
+		}
+		for (uint32_t passID : b.passes) {
+			ScopedDebugArea area(cmdBuffer, passes[passID].name);
+			passes[passID].func(cmdBuffer);
+		}
+	}
+	//Next frame picks up where this one left off
+	for (const Resource& r : resources) {
+		if (!r.persistent) {
+			continue;
+		}
+		if (r.image) {
+			imageStates[r.image] = r.state;
+		}
+		else {
+			bufferStates[r.buffer] = r.state;
+		}
+	}
+}
+
+vk::ImageLayout RenderGraph::GetFinalLayout(ResourceID id) const {
+	return resources[id].state.layout;
+}
@@ -0,0 +1,180 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "VulkanTransientAllocator.h"
+#include <deque>
+#include <functional>
+
+namespace NCL::Rendering::Vulkan {
+	/*
+	A frame's worth of passes, each saying which images and buffers it reads
+	and writes. From that, the graph works out which passes actually feed
+	something we care about, what order to run them in, and the barriers and
+	layout transitions needed between them. Each group of independent passes
+	gets a single pipelineBarrier2 call in front of it, holding everything
+	that group needs, so the GPU is free to overlap the passes within it.
+
+	Images imported with ImportImage have their layout and last access
+	remembered between frames, so an image is only transitioned when a pass
+	actually needs a different layout. ImportExternalImage is for images
+	something else synchronises, like the swapchain. Transient images are
+	created by the graph itself, and only exist while they're being used,
+	sharing memory with any other transient they're never alive alongside.
+
+	The graph is rebuilt every frame: Reset, import, add passes, Execute.
+	*/
+	class RenderGraph	{
+	public:
+		using ResourceID	= uint32_t;
+		using PassFunc		= std::function<void(vk::CommandBuffer)>;
+
+		class Pass {
+			friend class RenderGraph;
+		public:
+			//load == false means the old contents are discarded, so the image can come from an undefined layout
+			Pass& ColourAttachment(ResourceID id, bool load = false);
+			//In eDepthStencilAttachmentOptimal rather than eDepthAttachmentOptimal if the image has a stencil aspect
+			Pass& DepthAttachment(ResourceID id, bool load = false);
+
+			Pass& SampledImage(ResourceID id, vk::PipelineStageFlags2 stages = vk::PipelineStageFlagBits2::eFragmentShader, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+			Pass& StorageImageRead(ResourceID id, vk::PipelineStageFlags2 stages = vk::PipelineStageFlagBits2::eComputeShader);
+			Pass& StorageImageWrite(ResourceID id, vk::PipelineStageFlags2 stages = vk::PipelineStageFlagBits2::eComputeShader);
+			Pass& StorageImage(ResourceID id, vk::PipelineStageFlags2 stages = vk::PipelineStageFlagBits2::eComputeShader);
+
+			Pass& BufferRead(ResourceID id, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access = vk::AccessFlagBits2::eShaderStorageRead);
+			Pass& BufferWrite(ResourceID id, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access = vk::AccessFlagBits2::eShaderStorageWrite);
+
+			//For anything the helpers above don't cover
+			Pass& Read(ResourceID id, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access, vk::ImageLayout layout = vk::ImageLayout::eUndefined);
+			Pass& Write(ResourceID id, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access, vk::ImageLayout layout = vk::ImageLayout::eUndefined, bool discard = false);
+
+			//Passes with side effects (timestamps, readbacks etc) are never culled
+			Pass& HasSideEffects();
+
+		protected:
+			struct Access {
+				ResourceID				id;
+				vk::PipelineStageFlags2 stages;
+				vk::AccessFlags2		access;
+				vk::ImageLayout			layout;
+				bool					reads;
+				bool					writes;
+				bool					discard;
+			};
+			Pass& AddAccess(Access a);
+
+			std::string			name;
+			PassFunc			func;
+			std::vector<Access> accesses;
+			bool				sideEffects = false;
+			bool				culled		= false;
+			int					level		= 0;
+		};
+
+		RenderGraph();
+		~RenderGraph();
+
+		//Persistent images, the graph remembers their state from the last time they were executed.
+		//firstLayout is only used the first time the graph sees the image
+		ResourceID ImportImage(const std::string& name, vk::Image image, vk::ImageAspectFlags aspects, vk::ImageLayout firstLayout);
+		//The image is in this layout, with all prior work on it finished, every time it's imported
+		ResourceID ImportExternalImage(const std::string& name, vk::Image image, vk::ImageAspectFlags aspects, vk::ImageLayout currentLayout);
+		ResourceID ImportBuffer(const std::string& name, vk::Buffer buffer);
+
+		//The first pass to use a transient image must completely overwrite it
+		ResourceID CreateTransientImage(const std::string& name, const TransientImageInfo& info);
+		void UsingTransientAllocator(TransientAllocator& allocator) {
+			transientAllocator = &allocator;
+		}
+
+		//Anything written to an output is kept, along with everything it depends on
+		void MarkOutput(ResourceID id);
+
+		//Must be called before a persistent image or buffer is destroyed, as the handle may be reused
+		void ForgetImage(vk::Image image);
+		void ForgetBuffer(vk::Buffer buffer);
+
+		Pass& AddPass(const std::string& name, PassFunc&& func);
+
+		void Reset();
+		//False if the transient images couldn't be made, in which case Execute records nothing
+		bool Compile();
+		void Execute(vk::CommandBuffer cmdBuffer);
+
+		vk::ImageLayout GetFinalLayout(ResourceID id) const;
+
+		//Transient images don't exist until the graph has been compiled
+		vk::Image		GetImage(ResourceID id) const {
+			return resources[id].image;
+		}
+		vk::ImageView	GetImageView(ResourceID id) const {
+			return resources[id].view;
+		}
+
+		uint32_t GetBarrierCount() const {
+			return barrierCount;
+		}
+		uint32_t GetCulledPassCount() const {
+			return culledCount;
+		}
+
+	protected:
+		struct ResourceState {
+			vk::ImageLayout			layout			= vk::ImageLayout::eUndefined;
+			vk::PipelineStageFlags2 writeStages;	//The last write, which later accesses must wait on
+			vk::AccessFlags2		writeAccess;
+			vk::PipelineStageFlags2 readStages;		//Reads since that write, which a new write must wait on
+			vk::PipelineStageFlags2 visibleStages;	//Where the last write has already been made visible
+			vk::AccessFlags2		visibleAccess;
+		};
+
+		struct Resource {
+			std::string				name;
+			vk::Image				image;
+			vk::Buffer				buffer;
+			vk::ImageAspectFlags	aspects;
+			ResourceState			state;
+			bool					persistent	= false;
+			bool					output		= false;
+			int						batchBarrier = -1; //image barrier already issued for it in the current batch
+
+			bool							transient	= false;
+			bool							firstUseDone = false;
+			TransientImageInfo				transientInfo;
+			TransientAllocator::Placement	placement;
+			vk::ImageView					view;
+		};
+
+		struct Batch {
+			std::vector<uint32_t>				passes;
+			std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+			vk::MemoryBarrier2					memoryBarrier;
+		};
+
+		void CullPasses();
+		void SchedulePasses();
+		bool PlaceTransients();
+		void BuildBarriers();
+		void AddDependency(Batch& batch, Resource& r, const Pass::Access& a);
+
+		std::vector<Resource>	resources;
+		std::deque<Pass>		passes;
+		std::vector<Batch>		batches;
+
+		std::map<vk::Image, ResourceState>	imageStates;
+		std::map<vk::Buffer, ResourceState>	bufferStates;
+
+		TransientAllocator*		transientAllocator = nullptr;
+		uint32_t				transientGeneration = 0;
+		std::vector<vk::Image>	transientImages;
+
+		uint32_t	barrierCount;
+		uint32_t	culledCount;
+		bool		compiled;
+	};
+}
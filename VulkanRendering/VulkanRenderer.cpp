@@ -13,6 +13,11 @@ License: MIT (see LICENSE file at the top of the source tree)
 
 #include "VulkanUtils.h"
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
 #ifdef _WIN32
 #include "Win32Window.h"
 using namespace NCL::Win32Code;
@@ -31,38 +36,96 @@ VulkanRenderer::VulkanRenderer(Window& window, const VulkanInitialisation& vkIni
 
 	vkInit = vkInitInfo;
 
+	if (vkInit.headless) {
+		//There's no surface to create or present to, so don't ask the driver for anything that needs one
+		auto needsSurface = [](const char* extension) {
+			std::string_view name(extension);
+			return name.ends_with("_surface") || name == VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+		};
+		std::erase_if(vkInit.instanceExtensions, needsSurface);
+		std::erase_if(vkInit.deviceExtensions, needsSurface);
+	}
+
 	allocatorInfo		= {};
 
 	InitInstance(vkInit);
 
 	InitPhysicalDevice(vkInit);
 
+	if (vkInit.onPhysicalDeviceSelected) {
+		vkInit.onPhysicalDeviceSelected(gpu, vkInit);
+	}
+
+	//Lets VMA ask the driver how much memory we can really use, rather than estimating from the heap sizes
+	for (const auto& e : gpu.enumerateDeviceExtensionProperties()) {
+		if (std::string_view(e.extensionName) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) {
+			memorySnapshot.budgetQueries = true;
+		}
+	}
+	if (memorySnapshot.budgetQueries && std::ranges::find_if(vkInit.deviceExtensions, [](const char* e) { return std::string_view(e) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME; }) == vkInit.deviceExtensions.end()) {
+		vkInit.deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
 	InitGPUDevice(vkInit);
 	InitMemoryAllocator(vkInit);
 
 	InitCommandPools();
+	InitFrameContexts();
+
+	immediateContexts[CommandBuffer::Graphics]		= std::make_unique<ImmediateContext>(device, queueTypes[CommandBuffer::Graphics], gfxQueueIndex);
+	immediateContexts[CommandBuffer::AsyncCompute]	= std::make_unique<ImmediateContext>(device, queueTypes[CommandBuffer::AsyncCompute], computeQueueIndex);
+	immediateContexts[CommandBuffer::Copy]			= std::make_unique<ImmediateContext>(device, queueTypes[CommandBuffer::Copy], copyQueueIndex);
 	InitDefaultDescriptorPool();
 	InitDefaultDescriptorSetLayouts();
 
+	frameUploadRing = std::make_unique<FrameUploadRing>(device, memoryAllocator, GetFramesInFlight(), vkInit.frameUploadSize,
+		std::max(deviceProperties.limits.minUniformBufferOffsetAlignment, deviceProperties.limits.minStorageBufferOffsetAlignment));
+	frameArena = std::make_unique<FrameArena>(vkInit.frameArenaSize);
+	parallelRecorder = std::make_unique<ParallelRecorder>(device, gfxQueueIndex, GetFramesInFlight());
+
+	gpuProfiler = std::make_unique<GPUProfiler>(device, GetFramesInFlight(), deviceProperties.limits.timestampPeriod, deviceQueueProps[gfxQueueIndex].timestampValidBits > 0);
+
+	if (vkInit.dynamicResolution) {
+		dynamicResolution = std::make_unique<DynamicResolution>(device, memoryAllocator, surfaceFormat, GetFramesInFlight(),
+			deviceProperties.limits.timestampPeriod, deviceQueueProps[gfxQueueIndex].timestampValidBits > 0);
+		dynamicResolution->SetTargetFrameTime(vkInit.targetFrameTime);
+		dynamicResolution->SetScaleRange(vkInit.minResolutionScale, vkInit.maxResolutionScale);
+	}
+
 	hostWindow.SetRenderer(this);
 
-	pipelineCache = device.createPipelineCache(vk::PipelineCacheCreateInfo());
+	InitPipelineCache();
 
-	frameCmds = swapChainList[currentSwap]->cmdBuffer;
+	frameCmds = frameContexts[currentFrame].cmdBuffer;
 }
 
 VulkanRenderer::~VulkanRenderer() {
 	device.waitIdle();
+	for (auto& i : immediateContexts) {
+		i.reset();
+	}
+	parallelRecorder.reset();
+	streamingUploader.reset();
+	queueScheduler.reset();
+	dynamicResolution.reset();
+	gpuProfiler.reset();
 	depthBuffer.reset();
 
 	for (auto& i : swapChainList) {
 		device.destroyImageView(i->colourView);
+		delete i;
 	};
+	offscreenImages.clear();
 
 	for (unsigned int i = 0; i < numFrameBuffers; ++i) {
 		device.destroyFramebuffer(frameBuffers[i]);
-		device.destroySemaphore(swapSemaphores[i]);
-		device.destroyFence(swapFences[i]);
+	}
+	for (auto& i : presentSemaphores) {
+		device.destroySemaphore(i);
+	}
+	for (auto& i : frameContexts) {
+		device.destroySemaphore(i.acquireSemaphore);
+		device.destroyFence(i.inFlightFence);
 	}
 
 	for (unsigned int i = 0; i < DefaultSetLayouts::MAX_SIZE; ++i) {
@@ -71,19 +134,28 @@ VulkanRenderer::~VulkanRenderer() {
 		}
 	}
 
+	frameUploadRing.reset();
 	vmaDestroyAllocator(memoryAllocator);
-	device.destroyDescriptorPool(defaultDescriptorPool);
-	device.destroySwapchainKHR(swapChain);
+	descriptorSetCache.reset();
+	descriptorAllocator.reset();
+	frameDescriptorAllocator.reset();
+	if (swapChain) {
+		device.destroySwapchainKHR(swapChain);
+	}
 
 	device.destroyCommandPool(commandPools[CommandBuffer::Graphics]);
 	device.destroyCommandPool(commandPools[CommandBuffer::Copy]);
 	device.destroyCommandPool(commandPools[CommandBuffer::AsyncCompute]);
 
 	device.destroyRenderPass(defaultRenderPass);
+	SavePipelineCache();
+	SetDefaultPipelineCache(device, {});
 	device.destroyPipelineCache(pipelineCache);
 	device.destroy(); //Destroy everything except instance before this gets destroyed!
 
-	instance.destroySurfaceKHR(surface);
+	if (surface) {
+		instance.destroySurfaceKHR(surface);
+	}
 	instance.destroy();
 
 	delete[] frameBuffers;
@@ -134,7 +206,12 @@ bool	VulkanRenderer::InitPhysicalDevice(const VulkanInitialisation& vkInit) {
 }
 
 bool VulkanRenderer::InitGPUDevice(const VulkanInitialisation& vkInit) {
-	InitSurface();
+	if (vkInit.headless) {
+		surfaceFormat	= vkInit.headlessColourFormat;
+	}
+	else {
+		InitSurface();
+	}
 	InitDeviceQueueIndices();
 
 	float queuePriority = 0.0f;
@@ -195,6 +272,7 @@ bool VulkanRenderer::InitGPUDevice(const VulkanInitialisation& vkInit) {
 	deviceProperties = gpu.getProperties();
 
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(device);
+	InstallFrameCounterHooks();
 	return true;
 }
 
@@ -226,10 +304,62 @@ bool VulkanRenderer::InitSurface() {
 }
 
 uint32_t VulkanRenderer::InitBufferChain(vk::CommandBuffer  cmdBuffer) {
-	vk::SwapchainKHR oldChain					= swapChain;
-	std::vector<FrameState*> oldSwapChainList	= swapChainList;
+	for (auto& i : swapChainList) {
+		device.destroyImageView(i->colourView);
+		delete i;
+	}
 	swapChainList.clear();
 
+	std::vector<vk::Image> images = vkInit.headless ? CreateOffscreenImages() : CreateSwapChainImages();
+
+	for (auto& i : images) {
+		FrameState* chain = new FrameState();
+
+		chain->colourImage = i;
+
+		ImageTransitionBarrier(cmdBuffer, i, vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal, vk::ImageAspectFlagBits::eColor, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+
+		chain->colourView = device.createImageView(
+			vk::ImageViewCreateInfo()
+			.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1))
+			.setFormat(surfaceFormat)
+			.setImage(i)
+			.setViewType(vk::ImageViewType::e2D)	
+		);
+
+		swapChainList.push_back(chain);
+
+		chain->cmdBuffer			= frameContexts[currentFrame].cmdBuffer;
+		chain->acquireSempaphore	= frameContexts[currentFrame].acquireSemaphore;
+		chain->acquireFence			= frameContexts[currentFrame].inFlightFence;
+
+		chain->defaultViewport		= defaultViewport;
+		chain->defaultScissor		= defaultScissor;
+		chain->defaultScreenRect	= defaultScreenRect;
+		
+		chain->colourFormat = surfaceFormat;
+
+		chain->depthImage	= depthBuffer->GetImage();
+		chain->depthView	= depthBuffer->GetDefaultView();
+		chain->depthFormat	= depthBuffer->GetFormat();
+	}
+
+	//Resizes wait for the device to go idle first, so nothing can still be waiting on these
+	for (auto& i : presentSemaphores) {
+		device.destroySemaphore(i);
+	}
+	presentSemaphores.clear();
+	for (size_t i = 0; i < images.size(); ++i) {
+		presentSemaphores.push_back(device.createSemaphore({}));
+	}
+	imageFences.assign(images.size(), vk::Fence());
+
+	return (int)images.size();
+}
+
+std::vector<vk::Image> VulkanRenderer::CreateSwapChainImages() {
+	vk::SwapchainKHR oldChain = swapChain;
+
 	vk::SurfaceCapabilitiesKHR surfaceCaps = gpu.getSurfaceCapabilitiesKHR(surface);
 
 	vk::Extent2D swapExtents = vk::Extent2D((int)hostWindow.GetScreenSize().x, (int)hostWindow.GetScreenSize().y);
@@ -273,67 +403,40 @@ uint32_t VulkanRenderer::InitBufferChain(vk::CommandBuffer  cmdBuffer) {
 		.setMinImageCount(idealImageCount)
 		.setOldSwapchain(oldChain)
 		.setImageArrayLayers(1)
-		.setImageUsage(vk::ImageUsageFlagBits::eColorAttachment);
+		.setImageUsage(vkInit.dynamicResolution ? 
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst : vk::ImageUsageFlagBits::eColorAttachment);
 
 	swapChain = device.createSwapchainKHR(swapInfo);
 
-	if (!oldSwapChainList.empty()) {
-		for (unsigned int i = 0; i < numFrameBuffers; ++i) {
-			device.destroyImageView(oldSwapChainList[i]->colourView);
-			delete oldSwapChainList[i];
-		}
-	}
 	if (oldChain) {
 		device.destroySwapchainKHR(oldChain);
 	}
 
-	auto images = device.getSwapchainImagesKHR(swapChain);
-
-	for (auto& i : images) {
-		FrameState* chain = new FrameState();
-
-		chain->colourImage = i;
-
-		ImageTransitionBarrier(cmdBuffer, i, vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal, vk::ImageAspectFlagBits::eColor, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::PipelineStageFlagBits2::eColorAttachmentOutput);
-
-		chain->colourView = device.createImageView(
-			vk::ImageViewCreateInfo()
-			.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1))
-			.setFormat(surfaceFormat)
-			.setImage(i)
-			.setViewType(vk::ImageViewType::e2D)	
-		);
-
-		swapChainList.push_back(chain);
+	return device.getSwapchainImagesKHR(swapChain);
+}
 
-		auto buffers = device.allocateCommandBuffers(	
-			{
-				.commandPool = commandPools[CommandBuffer::Graphics],
-				.level = vk::CommandBufferLevel::ePrimary,
-				.commandBufferCount = 1
-			}
+//Headless rendering cycles through these in place of swapchain images. They can be copied from
+//once a frame's fence has signalled, so results can be read back or written to disk
+std::vector<vk::Image> VulkanRenderer::CreateOffscreenImages() {
+	offscreenImages.clear();
+
+	std::vector<vk::Image> images;
+	for (uint32_t i = 0; i < std::max(vkInit.headlessImageCount, 1u); ++i) {
+		offscreenImages.push_back(TextureBuilder(GetDevice(), GetMemoryAllocator())
+			.UsingPool(GetCommandPool(CommandBuffer::Graphics))
+			.UsingQueue(GetQueue(CommandBuffer::Graphics))
+			.WithDimension(hostWindow.GetScreenSize().x, hostWindow.GetScreenSize().y)
+			.WithAspects(vk::ImageAspectFlagBits::eColor)
+			.WithFormat(surfaceFormat)
+			.WithLayout(vk::ImageLayout::eColorAttachmentOptimal)
+			.WithUsages(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst)
+			.WithPipeFlags(vk::PipelineStageFlagBits2::eColorAttachmentOutput)
+			.WithMips(false)
+			.Build("Offscreen Frame " + std::to_string(i))
 		);
-		 
-		chain->cmdBuffer = buffers[0];
-
-		swapSemaphores.push_back(device.createSemaphore({}));
-		swapFences.push_back(device.createFence({}));
-
-		chain->acquireSempaphore = swapSemaphores[swapCycle];
-		chain->acquireFence		 = swapFences[swapCycle];
-
-		chain->defaultViewport		= defaultViewport;
-		chain->defaultScissor		= defaultScissor;
-		chain->defaultScreenRect	= defaultScreenRect;
-		
-		chain->colourFormat = surfaceFormat;
-
-		chain->depthImage	= depthBuffer->GetImage();
-		chain->depthView	= depthBuffer->GetDefaultView();
-		chain->depthFormat	= depthBuffer->GetFormat();
+		images.push_back(offscreenImages.back()->GetImage());
 	}
-	swapCycle = 1;
-	return (int)images.size();
+	return images;
 }
 
 void	VulkanRenderer::InitCommandPools() {	
@@ -359,6 +462,29 @@ void	VulkanRenderer::InitCommandPools() {
 	);
 }
 
+void	VulkanRenderer::InitFrameContexts() {
+	uint32_t frameCount = std::max(vkInit.framesInFlight, 1u);
+
+	auto buffers = device.allocateCommandBuffers(
+		{
+			.commandPool = commandPools[CommandBuffer::Graphics],
+			.level = vk::CommandBufferLevel::ePrimary,
+			.commandBufferCount = frameCount
+		}
+	);
+
+	for (uint32_t i = 0; i < frameCount; ++i) {
+		FrameContext frame;
+		frame.cmdBuffer			= buffers[i];
+		frame.acquireSemaphore	= device.createSemaphore({});
+		//Starts signalled, so the first wait on each frame returns straight away
+		frame.inFlightFence		= device.createFence({ .flags = vk::FenceCreateFlagBits::eSignaled });
+
+		SetDebugName(device, vk::ObjectType::eCommandBuffer, GetVulkanHandle(frame.cmdBuffer), "Frame cmds " + std::to_string(i));
+		frameContexts.push_back(frame);
+	}
+}
+
 void	VulkanRenderer::InitMemoryAllocator(const VulkanInitialisation& vkInit) {
 	VmaVulkanFunctions funcs = {};
 	funcs.vkGetInstanceProcAddr = ::vk::defaultDispatchLoaderDynamic.vkGetInstanceProcAddr;
@@ -369,11 +495,82 @@ void	VulkanRenderer::InitMemoryAllocator(const VulkanInitialisation& vkInit) {
 	allocatorInfo.instance	= instance;
 
 	allocatorInfo.flags |= vkInit.vmaFlags;
+	if (memorySnapshot.budgetQueries) {
+		allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+	}
+	allocatorInfo.vulkanApiVersion = VK_MAKE_API_VERSION(0, vkInit.majorVersion, vkInit.minorVersion, 0);
 
 	allocatorInfo.pVulkanFunctions = &funcs;
 	vmaCreateAllocator(&allocatorInfo, &memoryAllocator);
 }
 
+void	VulkanRenderer::InitPipelineCache() {
+	std::vector<char> cacheData;
+
+	if (!vkInit.pipelineCacheFile.empty()) {
+		std::ifstream file(vkInit.pipelineCacheFile, std::ios::binary | std::ios::ate);
+		if (file) {
+			cacheData.resize((size_t)file.tellg());
+			file.seekg(0);
+			file.read(cacheData.data(), cacheData.size());
+		}
+	}
+
+	//A cache from a different GPU or driver would just be rejected, or worse, so check it's one of ours first
+	if (!cacheData.empty()) {
+		VkPipelineCacheHeaderVersionOne header = {};
+		bool valid = cacheData.size() >= sizeof(header);
+		if (valid) {
+			memcpy(&header, cacheData.data(), sizeof(header));
+			valid = header.headerSize >= sizeof(header)
+				&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+				&& header.vendorID == deviceProperties.vendorID
+				&& header.deviceID == deviceProperties.deviceID
+				&& memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+		}
+		if (valid) {
+			std::cout << __FUNCTION__ << " Loaded " << cacheData.size() << " bytes of pipeline cache from " << vkInit.pipelineCacheFile << "\n";
+		}
+		else {
+			std::cout << __FUNCTION__ << " Pipeline cache " << vkInit.pipelineCacheFile << " is from another device or driver, ignoring it\n";
+			cacheData.clear();
+		}
+	}
+
+	pipelineCache = device.createPipelineCache(
+		{
+			.initialDataSize = cacheData.size(),
+			.pInitialData = cacheData.empty() ? nullptr : cacheData.data()
+		}
+	);
+	SetDefaultPipelineCache(device, pipelineCache);
+}
+
+void	VulkanRenderer::SavePipelineCache() {
+	if (vkInit.pipelineCacheFile.empty() || !pipelineCache) {
+		return;
+	}
+	std::vector<uint8_t> cacheData = device.getPipelineCacheData(pipelineCache);
+	if (cacheData.empty()) {
+		return;
+	}
+	//Write to a temporary file and move it over the old one, so a crash mid-write can't leave a truncated cache behind
+	std::string tempFile = vkInit.pipelineCacheFile + ".tmp";
+	{
+		std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+		if (!file.write((const char*)cacheData.data(), cacheData.size())) {
+			std::cout << __FUNCTION__ << " Failed to write pipeline cache to " << tempFile << "\n";
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(tempFile, vkInit.pipelineCacheFile, error);
+	if (error) {
+		std::cout << __FUNCTION__ << " Failed to replace " << vkInit.pipelineCacheFile << ": " << error.message() << "\n";
+		std::filesystem::remove(tempFile, error);
+	}
+}
+
 bool VulkanRenderer::InitDeviceQueueIndices() {
 	deviceQueueProps = gpu.getQueueFamilyProperties();
 
@@ -388,7 +585,8 @@ bool VulkanRenderer::InitDeviceQueueIndices() {
 	int copyBits	= INT_MAX;
 
 	for (unsigned int i = 0; i < deviceQueueProps.size(); ++i) {
-		supportsPresent = gpu.getSurfaceSupportKHR(i, surface);
+		//Headless frames are never presented, so any graphics queue will do
+		supportsPresent = vkInit.headless ? VK_TRUE : gpu.getSurfaceSupportKHR(i, surface);
 
 		int queueBitCount = std::popcount((uint32_t)deviceQueueProps[i].queueFlags);
 
@@ -444,16 +642,9 @@ void VulkanRenderer::OnWindowResize(int width, int height) {
 	}
 	windowSize = { width, height };
 
-	defaultScreenRect = vk::Rect2D({ 0,0 }, { (uint32_t)windowSize.x, (uint32_t)windowSize.y });
-
-	if (vkInit.useOpenGLCoordinates) {
-		defaultViewport = vk::Viewport(0.0f, (float)windowSize.y, (float)windowSize.x, (float)windowSize.y, -1.0f, 1.0f);
-	}
-	else {
-		defaultViewport = vk::Viewport(0.0f, (float)windowSize.y, (float)windowSize.x, -(float)windowSize.y, 0.0f, 1.0f);
-	}
-
-	defaultScissor	= vk::Rect2D(vk::Offset2D(0, 0), vk::Extent2D(windowSize.x, windowSize.y));
+	defaultScreenRect	= vk::Rect2D({ 0,0 }, { (uint32_t)windowSize.x, (uint32_t)windowSize.y });
+	defaultViewport		= BuildViewport(windowSize.x, windowSize.y);
+	defaultScissor		= vk::Rect2D(vk::Offset2D(0, 0), vk::Extent2D(windowSize.x, windowSize.y));
 
 	defaultClearValues[0] = vk::ClearValue(vk::ClearColorValue(std::array<float, 4>{0.2f, 0.2f, 0.2f, 1.0f}));
 	defaultClearValues[1] = vk::ClearValue(vk::ClearDepthStencilValue(1.0f, 0));
@@ -474,8 +665,12 @@ void VulkanRenderer::OnWindowResize(int width, int height) {
 		.WithMips(false)
 		.Build("Depth Buffer");
 
-	vk::UniqueCommandBuffer cmds = CmdBufferBegin(device, commandPools[CommandBuffer::Graphics], "Window resize cmds");
-	numFrameBuffers = InitBufferChain(*cmds);
+	ImmediateContext& context = GetImmediateContext(CommandBuffer::Graphics);
+	numFrameBuffers = InitBufferChain(context.Begin("Window resize cmds"));
+	if (dynamicResolution) {
+		dynamicResolution->Resize(windowSize.x, windowSize.y, context);
+	}
+	UpdateFrameState();
 
 	InitDefaultRenderPass();
 	CreateDefaultFrameBuffers();
@@ -484,28 +679,68 @@ void VulkanRenderer::OnWindowResize(int width, int height) {
 
 	CompleteResize();
 
-	CmdBufferEndSubmitWait(*cmds, device, queueTypes[CommandBuffer::Graphics]);
+	context.SubmitWait();
 }
 
 void VulkanRenderer::CompleteResize() {
 
 }
 
-void VulkanRenderer::WaitForSwapImage() {
-	TransitionUndefinedToColour(frameCmds, swapChainList[currentSwap]->colourImage);
+vk::Viewport VulkanRenderer::BuildViewport(uint32_t width, uint32_t height) const {
+	if (vkInit.useOpenGLCoordinates) {
+		return vk::Viewport(0.0f, (float)height, (float)width, (float)height, -1.0f, 1.0f);
+	}
+	return vk::Viewport(0.0f, (float)height, (float)width, -(float)height, 0.0f, 1.0f);
+}
 
-	if (!hostWindow.IsMinimised()) {
-		vk::Result waitResult = device.waitForFences(swapChainList[currentSwap]->acquireFence, true, ~0);
+//Apps only ever see the current frame's state through here, so this is where dynamic resolution takes over the back buffer
+void VulkanRenderer::UpdateFrameState() {
+	frameState = *(swapChainList[currentSwap]);
+	if (!dynamicResolution) {
+		return;
 	}
+	vk::Extent2D extent = dynamicResolution->GetRenderExtent();
+
+	frameState.colourImage			= dynamicResolution->GetColourImage();
+	frameState.colourView			= dynamicResolution->GetColourView();
+	frameState.defaultViewport		= BuildViewport(extent.width, extent.height);
+	frameState.defaultScissor		= vk::Rect2D({ 0,0 }, extent);
+	frameState.defaultScreenRect	= vk::Rect2D({ 0,0 }, extent);
+}
+
+//The frame's submission waits on the acquire semaphore, so there's no need to stall the CPU here
+void VulkanRenderer::WaitForSwapImage() {
+	TransitionUndefinedToColour(frameCmds, frameState.colourImage);
 }
 
 void	VulkanRenderer::AcquireSwapImage() {
-	device.resetFences(swapChainList[currentSwap]->acquireFence);
+	PROFILE_FUNCTION();
+	FrameContext& frame = frameContexts[currentFrame];
 
-	currentSwap = device.acquireNextImageKHR(swapChain, UINT64_MAX, swapSemaphores[swapCycle], swapFences[swapCycle]).value;	//Get swap image
+	//Only blocks if the CPU has got framesInFlight frames ahead of the GPU
+	if (device.waitForFences(frame.inFlightFence, true, UINT64_MAX) != vk::Result::eSuccess) {
+		std::cout << __FUNCTION__ << " Frame fence wait failed?\n";
+	}
 
-	swapChainList[currentSwap]->acquireSempaphore = swapSemaphores[swapCycle];
-	swapChainList[currentSwap]->acquireFence = swapFences[swapCycle];
+	if (vkInit.headless) {
+		currentSwap = (currentSwap + 1) % (uint32_t)swapChainList.size();	//Nothing to acquire, the images are ours
+	}
+	else {
+		currentSwap = device.acquireNextImageKHR(swapChain, UINT64_MAX, frame.acquireSemaphore, {}).value;	//Get swap image
+	}
+
+	//The swapchain can hand images back out of order, so an older frame might still be drawing into this one
+	if (imageFences[currentSwap] && imageFences[currentSwap] != frame.inFlightFence) {
+		if (device.waitForFences(imageFences[currentSwap], true, UINT64_MAX) != vk::Result::eSuccess) {
+			std::cout << __FUNCTION__ << " Swap image fence wait failed?\n";
+		}
+	}
+	imageFences[currentSwap] = frame.inFlightFence;
+	device.resetFences(frame.inFlightFence);
+
+	swapChainList[currentSwap]->cmdBuffer			= frame.cmdBuffer;
+	swapChainList[currentSwap]->acquireSempaphore	= frame.acquireSemaphore;
+	swapChainList[currentSwap]->acquireFence		= frame.inFlightFence;
 
 	swapChainList[currentSwap]->defaultViewport		= defaultViewport;
 	swapChainList[currentSwap]->defaultScissor		= defaultScissor;
@@ -514,8 +749,6 @@ void	VulkanRenderer::AcquireSwapImage() {
 	swapChainList[currentSwap]->colourFormat = surfaceFormat;
 	swapChainList[currentSwap]->depthFormat  = depthBuffer->GetFormat();
 
-	swapCycle = (swapCycle + 1) % swapSemaphores.size();
-
 	defaultBeginInfo = vk::RenderPassBeginInfo()
 		.setRenderPass(defaultRenderPass)
 		.setFramebuffer(frameBuffers[currentSwap])
@@ -525,18 +758,53 @@ void	VulkanRenderer::AcquireSwapImage() {
 }
 
 void	VulkanRenderer::BeginFrame() {
+	UpdateFrameCounters();
 	AcquireSwapImage();
-	frameCmds = swapChainList[currentSwap]->cmdBuffer;
+	//the frame's fence has been waited on, so its sets and upload space are free to reuse
+	frameDescriptorAllocator->BeginFrame(currentFrame);
+	frameUploadRing->BeginFrame(currentFrame);
+	frameArena->Reset();
+	parallelRecorder->BeginFrame(currentFrame);
+	UpdateMemorySnapshot();
+	frameCmds = frameContexts[currentFrame].cmdBuffer;
 	frameCmds.reset({});
 
 	frameCmds.begin(vk::CommandBufferBeginInfo());
 
+	gpuProfiler->BeginFrame(frameCmds, currentFrame);
+	gpuProfiler->BeginZone(frameCmds, "Frame");
+
+	//Send off anything queued up for streaming, and take ownership of whatever has finished since last frame
+	if (streamingUploader) {
+		streamingUploader->Flush();
+		streamingUploadWait = streamingUploader->RecordAcquires(frameCmds);
+	}
+
+	//Picks this frame's scale, which the frame state then follows
+	if (dynamicResolution) {
+		dynamicResolution->BeginFrame(frameCmds, currentFrame);
+	}
+	UpdateFrameState();
+
 	if (!vkInit.skipDynamicState) {
-		frameCmds.setViewport(0, 1, &defaultViewport);
-		frameCmds.setScissor(0, 1, &defaultScissor);
+		frameCmds.setViewport(0, 1, &frameState.defaultViewport);
+		frameCmds.setScissor(0, 1, &frameState.defaultScissor);
 	}
 
-	if (vkInit.autoTransitionFrameBuffer) {
+	//Every frame in flight shares the one depth buffer, so the previous frame's depth work has to finish first
+	vk::MemoryBarrier2 depthBarrier = {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+		.srcAccessMask	= vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+		.dstAccessMask	= vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite
+	};
+	vk::DependencyInfo depthInfo;
+	depthInfo.memoryBarrierCount = 1;
+	depthInfo.pMemoryBarriers = &depthBarrier;
+	frameCmds.pipelineBarrier2(depthInfo);
+
+	//The dynamic resolution target has already been made ready, and the swap image isn't drawn into until the end
+	if (vkInit.autoTransitionFrameBuffer && !dynamicResolution) {
 		WaitForSwapImage();
 	}
 	if (vkInit.autoBeginDynamicRendering) {
@@ -553,35 +821,130 @@ void	VulkanRenderer::EndFrame() {
 		frameCmds.endRendering();
 	}
 
-	if (hostWindow.IsMinimised()) {
-		CmdBufferEndSubmitWait(frameCmds, device, queueTypes[CommandBuffer::Graphics]);
+	FrameContext& frame = frameContexts[currentFrame];
+
+	if (dynamicResolution) {
+		dynamicResolution->EndFrame(frameCmds, currentFrame, swapChainList[currentSwap]->colourImage);
 	}
-	else {
-		CmdBufferEndSubmit(frameCmds, queueTypes[CommandBuffer::Graphics]);
+
+	if (vkInit.headless) {
+		//Leave the finished frame ready to be copied out
+		ImageTransitionBarrier(frameCmds, swapChainList[currentSwap]->colourImage,
+			vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::eTransferSrcOptimal, vk::ImageAspectFlagBits::eColor,
+			vk::PipelineStageFlagBits2::eAllCommands, vk::PipelineStageFlagBits2::eTransfer);
+
+		SubmitFrame({}, {}, {});
+		return;
+	}
+
+	TransitionColourToPresent(frameCmds, swapChainList[currentSwap]->colourImage);
+
+	//If the framebuffer isn't transitioned for us, the app might touch the swap image from any stage
+	vk::PipelineStageFlags2 acquireWaitStage = vkInit.autoTransitionFrameBuffer ? 
+		vk::PipelineStageFlagBits2::eColorAttachmentOutput : vk::PipelineStageFlagBits2::eAllCommands;
+	if (dynamicResolution) {	//The upscale is the first thing to touch the swap image
+		acquireWaitStage |= vk::PipelineStageFlagBits2::eBlit;
+	}
+
+	//Nothing gets presented while minimised, so don't leave a signalled semaphore behind
+	vk::Semaphore signal = hostWindow.IsMinimised() ? vk::Semaphore() : presentSemaphores[currentSwap];
+
+	SubmitFrame(frame.acquireSemaphore, acquireWaitStage, signal);
+}
+
+void	VulkanRenderer::SubmitFrame(vk::Semaphore waitSemaphore, vk::PipelineStageFlags2 waitStage, vk::Semaphore signalSemaphore) {
+	gpuProfiler->EndZone(frameCmds);
+	frameCmds.end();
+
+	frameWaits.clear();
+	if (waitSemaphore) {
+		frameWaits.push_back({ .semaphore = waitSemaphore, .stageMask = waitStage });
+	}
+	//The uploads acquired this frame have already finished, so this never actually holds anything up
+	if (streamingUploadWait > 0) {
+		frameWaits.push_back({ .semaphore = streamingUploader->GetSemaphore(), .value = streamingUploadWait, .stageMask = vk::PipelineStageFlagBits2::eAllCommands });
+		streamingUploadWait = 0;
 	}
+	vk::CommandBufferSubmitInfo cmdInfo = {
+		.commandBuffer = frameCmds
+	};
+	vk::SemaphoreSubmitInfo signals[2];
+	uint32_t signalCount = 0;
+	if (signalSemaphore) {
+		signals[signalCount++] = { .semaphore = signalSemaphore, .stageMask = vk::PipelineStageFlagBits2::eAllCommands };
+	}
+	if (queueScheduler) {
+		queueScheduler->PrepareSubmit(CommandBuffer::Graphics, frameWaits, signals[signalCount++]);
+	}
+	vk::SubmitInfo2 submitInfo = {
+		.waitSemaphoreInfoCount		= (uint32_t)frameWaits.size(),
+		.pWaitSemaphoreInfos		= frameWaits.data(),
+		.commandBufferInfoCount		= 1,
+		.pCommandBufferInfos		= &cmdInfo,
+		.signalSemaphoreInfoCount	= signalCount,
+		.pSignalSemaphoreInfos		= signals
+	};
+	gpuProfiler->OnSubmit(currentFrame);
+	queueTypes[CommandBuffer::Graphics].submit2(submitInfo, frameContexts[currentFrame].inFlightFence);
 }
 
-void VulkanRenderer::SwapBuffers() {
-	if (!hostWindow.IsMinimised()) {
-		vk::CommandPool gfxPool		= commandPools[CommandBuffer::Graphics];
-		vk::Queue		gfxQueue	= queueTypes[CommandBuffer::Graphics];
+void	VulkanRenderer::UpdateMemorySnapshot() {
+	//VMA only refreshes its budget figures when the frame index changes
+	memorySnapshot.frame++;
+	vmaSetCurrentFrameIndex(memoryAllocator, (uint32_t)memorySnapshot.frame);
+	FillMemorySnapshot(memoryAllocator, memorySnapshot);
+
+	bool overBudget = memorySnapshot.GetDeviceLocalUsage() > memorySnapshot.GetDeviceLocalBudget();
+	if (overBudget && !reportedOverBudget) {	//Once each time it happens is plenty
+		std::cout << __FUNCTION__ << " Device local memory is over budget, things are likely to slow down or fail!\n";
+		PrintMemorySnapshot(memorySnapshot);
+	}
+	reportedOverBudget = overBudget;
+}
 
-		vk::UniqueCommandBuffer cmds = CmdBufferBegin(device, gfxPool, "Window swap cmds");
+void	VulkanRenderer::UpdateFrameCounters() {
+	frameCounters = TakeFrameCounters();
+	if (Profiler::IsCapturing()) {
+		uint64_t now = Profiler::Now();
+		for (size_t i = 0; i < (size_t)FrameCounter::MAX_COUNTERS; ++i) {
+			Profiler::RecordCounter(GetFrameCounterName((FrameCounter)i), frameCounters.values[i], now);
+		}
+	}
+}
 
-		TransitionColourToPresent(*cmds, swapChainList[currentSwap]->colourImage);
+bool	VulkanRenderer::WriteMemoryStats(const std::string& filename) const {
+	return WriteMemoryStatsJSON(memoryAllocator, filename);
+}
 
-		CmdBufferEndSubmitWait(*cmds, device, gfxQueue);
+StreamingUploader& VulkanRenderer::GetStreamingUploader() {
+	if (!streamingUploader) {
+		streamingUploader = std::make_unique<StreamingUploader>(device, memoryAllocator, queueTypes[CommandBuffer::Copy], copyQueueIndex, gfxQueueIndex, vkInit.streamingStagingSize);
+	}
+	return *streamingUploader;
+}
+
+QueueScheduler& VulkanRenderer::GetQueueScheduler() {
+	if (!queueScheduler) {
+		queueScheduler = std::make_unique<QueueScheduler>(device, queueTypes);
+	}
+	return *queueScheduler;
+}
+
+void VulkanRenderer::SwapBuffers() {
+	if (!vkInit.headless && !hostWindow.IsMinimised()) {
+		vk::Queue		gfxQueue	= queueTypes[CommandBuffer::Graphics];
 
 		vk::Result presentResult = gfxQueue.presentKHR(
 			{
 				.waitSemaphoreCount = 1,
-				.pWaitSemaphores = &swapChainList[currentSwap]->acquireSempaphore,
+				.pWaitSemaphores = &presentSemaphores[currentSwap],
 				.swapchainCount = 1,
 				.pSwapchains = &swapChain,
 				.pImageIndices = &currentSwap
 			}
 		);	
 	}
+	currentFrame = (currentFrame + 1) % frameContexts.size();
 }
 
 void	VulkanRenderer::InitDefaultRenderPass() {
@@ -663,29 +1026,9 @@ bool VulkanRenderer::CreateDefaultFrameBuffers() {
 }
 
 void	VulkanRenderer::InitDefaultDescriptorPool(uint32_t maxSets) {
-	vk::DescriptorPoolSize poolSizes[] = {
-		vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, maxSets),
-		vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, maxSets),
-		vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, maxSets),
-		vk::DescriptorPoolSize(vk::DescriptorType::eStorageBufferDynamic, maxSets),		
-		
-		vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, maxSets),
-		vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, maxSets),
-		vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, maxSets),
-#ifdef USE_RAY_TRACING
-		vk::DescriptorPoolSize(vk::DescriptorType::eAccelerationStructureKHR, maxSets),
-#endif
-	};
-
-	uint32_t poolCount = sizeof(poolSizes) / sizeof(vk::DescriptorPoolSize);
-
-	vk::DescriptorPoolCreateInfo poolCreate;
-	poolCreate.setPoolSizeCount(sizeof(poolSizes) / sizeof(vk::DescriptorPoolSize));
-	poolCreate.setPPoolSizes(poolSizes);
-	poolCreate.setMaxSets(maxSets * poolCount);
-	poolCreate.setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
-
-	defaultDescriptorPool = device.createDescriptorPool(poolCreate);
+	descriptorAllocator			= std::make_unique<DescriptorAllocator>(device, maxSets);
+	frameDescriptorAllocator	= std::make_unique<FrameDescriptorAllocator>(device, GetFramesInFlight());
+	descriptorSetCache			= std::make_unique<DescriptorSetCache>(*descriptorAllocator);
 }
 
 void VulkanRenderer::InitDefaultDescriptorSetLayouts() {
@@ -716,31 +1059,48 @@ void	VulkanRenderer::BeginDefaultRenderPass(vk::CommandBuffer  cmds) {
 	//cmds.setScissor(0, 1, &defaultScissor);
 }
 
-void	VulkanRenderer::BeginDefaultRendering(vk::CommandBuffer  cmds) {
+void	VulkanRenderer::BeginDefaultRendering(vk::CommandBuffer  cmds, vk::RenderingFlags flags) {
 	vk::RenderingInfoKHR renderInfo;
 	renderInfo.layerCount = 1;
+	renderInfo.flags = flags;
 
 	vk::RenderingAttachmentInfoKHR colourAttachment;
-	colourAttachment.setImageView(swapChainList[currentSwap]->colourView)
+	colourAttachment.setImageView(frameState.colourView)
 		.setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
 		.setLoadOp(vk::AttachmentLoadOp::eClear)
 		.setStoreOp(vk::AttachmentStoreOp::eStore)
 		.setClearValue(vk::ClearColorValue(0.2f, 0.2f, 0.2f, 1.0f));
 
+	bool hasStencil = FormatHasStencil(depthBuffer->GetFormat());
+
 	vk::RenderingAttachmentInfoKHR depthAttachment;
 	depthAttachment.setImageView(depthBuffer->GetDefaultView())
-		.setImageLayout(vk::ImageLayout::eDepthAttachmentOptimal)
+		.setImageLayout(hasStencil ? vk::ImageLayout::eDepthStencilAttachmentOptimal : vk::ImageLayout::eDepthAttachmentOptimal)
 		.setLoadOp(vk::AttachmentLoadOp::eClear)
 		.setStoreOp(vk::AttachmentStoreOp::eStore)
 		.clearValue.setDepthStencil({ 1.0f, ~0U });
 
 	renderInfo.setColorAttachments(colourAttachment)
 		.setPDepthAttachment(&depthAttachment);
-		//.setPStencilAttachment(&depthAttachment);
+	if (hasStencil) {
+		renderInfo.setPStencilAttachment(&depthAttachment);
+	}
 
-	renderInfo.setRenderArea(defaultScreenRect);
+	renderInfo.setRenderArea(frameState.defaultScreenRect);
 
 	cmds.beginRendering(renderInfo);
-	cmds.setViewport(0, 1, &defaultViewport);
-	cmds.setScissor(0, 1, &defaultScissor);
+	if (!(flags & vk::RenderingFlagBits::eContentsSecondaryCommandBuffers)) {	//Secondaries set their own
+		cmds.setViewport(0, 1, &frameState.defaultViewport);
+		cmds.setScissor(0, 1, &frameState.defaultScissor);
+	}
+}
+
+SecondaryRenderingInfo VulkanRenderer::GetDefaultSecondaryInfo() const {
+	return SecondaryRenderingInfo{
+		.colourFormats	= { surfaceFormat },
+		.depthFormat	= depthBuffer->GetFormat(),
+		.stencilFormat	= FormatHasStencil(depthBuffer->GetFormat()) ? depthBuffer->GetFormat() : vk::Format::eUndefined,
+		.viewport		= frameState.defaultViewport,
+		.scissor		= frameState.defaultScissor
+	};
 }
\ No newline at end of file
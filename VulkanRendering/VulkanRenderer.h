@@ -11,7 +11,20 @@ License: MIT (see LICENSE file at the top of the source tree)
 
 #include "VulkanPipeline.h"
 #include "SmartTypes.h"
+#include "VulkanUtils.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDescriptorSetCache.h"
+#include "VulkanFrameUploadRing.h"
+#include "VulkanFrameArena.h"
+#include "VulkanParallelRecorder.h"
+#include "VulkanStreamingUploader.h"
+#include "VulkanQueueScheduler.h"
+#include "VulkanMemoryStats.h"
+#include "VulkanDynamicResolution.h"
+#include "VulkanProfiler.h"
+#include "VulkanFrameCounters.h"
 #include "vma/vk_mem_alloc.h"
+#include <functional>
 using std::string;
 
 namespace NCL::Rendering::Vulkan {
@@ -80,6 +93,38 @@ namespace NCL::Rendering::Vulkan {
 		bool				autoBeginDynamicRendering = true;
 		bool				useOpenGLCoordinates = false;
 		bool				skipDynamicState = false;
+
+		//How many frames the CPU may record ahead of the GPU. Each gets its own command buffer, fence and semaphores
+		uint32_t			framesInFlight = 2;
+
+		//Bytes of the frame upload ring each frame in flight gets, for uniforms and other per-frame data
+		vk::DeviceSize		frameUploadSize = 4 * 1024 * 1024;
+
+		//Starting size of the FrameArena, for transient CPU data. It grows if a frame needs more
+		size_t				frameArenaSize = 1024 * 1024;
+
+		//Size of the StreamingUploader's staging ring. It needs the timelineSemaphore feature enabled
+		vk::DeviceSize		streamingStagingSize = 64 * 1024 * 1024;
+
+		//Pipeline cache contents are loaded from here at startup, and written back on shutdown. Leave empty to disable
+		std::string			pipelineCacheFile = "VulkanPipelineCache.bin";
+
+		//Renders into a ring of offscreen colour images instead of a swapchain, with no surface or present.
+		//Any surface / swapchain extensions in the lists above are dropped, so the same settings work either way
+		bool				headless = false;
+		vk::Format			headlessColourFormat	= vk::Format::eB8G8R8A8Unorm;
+		uint32_t			headlessImageCount		= 3;
+
+		//Renders at a fraction of the window size when frames take longer than targetFrameTime ms of GPU time,
+		//and scales the result up to fill the swapchain. FrameState's viewport and rects follow the current scale
+		bool				dynamicResolution		= false;
+		float				targetFrameTime			= 16.6f;
+		float				minResolutionScale		= 0.5f;
+		float				maxResolutionScale		= 1.0f;
+
+		//Called once the physical device has been chosen, but before the logical device is created.
+		//Allows optional features and extensions to be requested only if the device supports them
+		std::function<void(vk::PhysicalDevice, VulkanInitialisation&)> onPhysicalDeviceSelected;
 	};
 
 	class VulkanRenderer : public RendererBase {
@@ -111,12 +156,89 @@ namespace NCL::Rendering::Vulkan {
 			return commandPools[type];
 		}
 
-		vk::DescriptorPool GetDescriptorPool() {
-			return defaultDescriptorPool;
+		//Used by the pipeline builders unless they're given a cache of their own
+		vk::PipelineCache GetPipelineCache() const {
+			return pipelineCache;
+		}
+
+		//For one-off work like uploads, see ImmediateContext
+		ImmediateContext& GetImmediateContext(CommandBuffer::Type type = CommandBuffer::Graphics) {
+			return *immediateContexts[type];
+		}
+
+		DescriptorAllocator& GetDescriptorAllocator() {
+			return *descriptorAllocator;
+		}
+
+		//For sets that only depend on what's bound to them, like materials, so identical ones are shared
+		DescriptorSetCache& GetDescriptorSetCache() {
+			return *descriptorSetCache;
+		}
+
+		//For CPU data that only lasts until the end of the frame. Emptied at the start of each BeginFrame
+		FrameArena& GetFrameArena() {
+			return *frameArena;
+		}
+
+		//Uniforms and anything else rewritten every frame go here, it's safe to write while older frames are still in flight
+		FrameUploadRing& GetFrameUploadRing() {
+			return *frameUploadRing;
+		}
+
+		//For recording big lists of draws across several threads, into secondary command buffers
+		ParallelRecorder& GetParallelRecorder() {
+			return *parallelRecorder;
+		}
+
+		//For loading assets on the copy queue without stalling the frame. Made the first time it's asked for
+		StreamingUploader& GetStreamingUploader();
+
+		//For ordering work across queues with timeline semaphores. Made the first time it's asked for, after which
+		//every frame's submission signals the graphics timeline, and waits on anything added with WaitOnNextSubmit
+		QueueScheduler& GetQueueScheduler();
+
+		//Heap budgets and usage by category, as of the start of the current frame
+		const MemorySnapshot& GetMemorySnapshot() const {
+			return memorySnapshot;
+		}
+		//Writes VMA's detailed breakdown of every block and allocation out as JSON
+		bool WriteMemoryStats(const std::string& filename) const;
+
+		//Sets from here only last until the current frame in flight comes round again
+		FrameDescriptorAllocator& GetFrameDescriptorAllocator() {
+			return *frameDescriptorAllocator;
 		}
 
 		FrameState const& GetFrameState() const {
-			return *(swapChainList[currentSwap]);
+			return frameState;
+		}
+
+		//Draws, binds, barriers etc recorded over the whole of the last frame, from one BeginFrame to the next
+		const FrameCounters& GetFrameCounters() const {
+			return frameCounters;
+		}
+
+		//For timing regions of the frame's commands while the Profiler is capturing. The whole frame is already one
+		GPUProfiler& GetGPUProfiler() {
+			return *gpuProfiler;
+		}
+
+		//Only exists if VulkanInitialisation asked for it
+		DynamicResolution* GetDynamicResolution() {
+			return dynamicResolution.get();
+		}
+
+		uint32_t GetFramesInFlight() const {
+			return (uint32_t)frameContexts.size();
+		}
+
+		//Which of the frames in flight is being recorded, for indexing any per-frame resources
+		uint32_t GetCurrentFrameIndex() const {
+			return currentFrame;
+		}
+
+		bool IsHeadless() const {
+			return vkInit.headless;
 		}
 
 		vk::DescriptorSetLayout GetDefaultLayout(DefaultSetLayouts::Type layout) {
@@ -128,7 +250,9 @@ namespace NCL::Rendering::Vulkan {
 		}
 
 		void	BeginDefaultRenderPass(vk::CommandBuffer cmds);
-		void	BeginDefaultRendering(vk::CommandBuffer  cmds);
+		//Pass in eContentsSecondaryCommandBuffers to fill the frame using the ParallelRecorder
+		void	BeginDefaultRendering(vk::CommandBuffer  cmds, vk::RenderingFlags flags = {});
+		SecondaryRenderingInfo GetDefaultSecondaryInfo() const;
 
 		void BeginFrame()		override;
 		void RenderFrame()		override;
@@ -154,13 +278,24 @@ namespace NCL::Rendering::Vulkan {
 		vk::RenderPass			defaultRenderPass;
 		vk::RenderPassBeginInfo defaultBeginInfo;
 		
-		vk::DescriptorPool		defaultDescriptorPool;	//descriptor sets come from here!
+		std::unique_ptr<DescriptorAllocator> descriptorAllocator;	//descriptor sets come from here!
+		std::unique_ptr<FrameDescriptorAllocator> frameDescriptorAllocator;
+		std::unique_ptr<DescriptorSetCache>		descriptorSetCache;
+		std::unique_ptr<FrameUploadRing>		frameUploadRing;
+		std::unique_ptr<FrameArena>				frameArena;
+		std::unique_ptr<ParallelRecorder>		parallelRecorder;
+		std::unique_ptr<StreamingUploader>		streamingUploader;
+		std::unique_ptr<QueueScheduler>			queueScheduler;
+		std::unique_ptr<DynamicResolution>		dynamicResolution;
+		std::unique_ptr<GPUProfiler>			gpuProfiler;
 
 		vk::CommandPool			commandPools[CommandBuffer::Type::MAX_BUFFERS];
 		vk::Queue				queueTypes[CommandBuffer::Type::MAX_BUFFERS];
 
 		vk::CommandBuffer		frameCmds;
 
+		std::unique_ptr<ImmediateContext>	immediateContexts[CommandBuffer::Type::MAX_BUFFERS];
+
 		//Initialisation Info
 		std::vector<vk::QueueFamilyProperties> deviceQueueProps;
 
@@ -171,17 +306,27 @@ namespace NCL::Rendering::Vulkan {
 		VulkanInitialisation vkInit;
 	private: 
 		void	InitCommandPools();
+		void	InitFrameContexts();
 		bool	InitInstance(const VulkanInitialisation& vkInit);
 		bool	InitPhysicalDevice(const VulkanInitialisation& vkInit);
 		bool	InitGPUDevice(const VulkanInitialisation& vkInit);
 		bool	InitSurface();
 		void	InitMemoryAllocator(const VulkanInitialisation& vkInit);
+		void	InitPipelineCache();
+		void	SavePipelineCache();
 		uint32_t	InitBufferChain(vk::CommandBuffer  cmdBuffer);
+		std::vector<vk::Image>	CreateSwapChainImages();
+		std::vector<vk::Image>	CreateOffscreenImages();
 
 		bool	InitDeviceQueueIndices();
 		bool	CreateDefaultFrameBuffers();
 
 		void	AcquireSwapImage();
+		void	UpdateFrameState();
+		vk::Viewport	BuildViewport(uint32_t width, uint32_t height) const;
+		void	UpdateMemorySnapshot();
+		void	UpdateFrameCounters();
+		void	SubmitFrame(vk::Semaphore waitSemaphore, vk::PipelineStageFlags2 waitStage, vk::Semaphore signalSemaphore);
 
 		void InitDefaultDescriptorSetLayouts();
 
@@ -208,13 +353,27 @@ namespace NCL::Rendering::Vulkan {
 
 		std::vector<FrameState*> swapChainList;
 		uint32_t				currentSwap = 0;
-		uint32_t				swapCycle = 0;
+		FrameState				frameState;	//The current swap image's state, or the dynamic resolution target's
 		vk::Framebuffer* frameBuffers = nullptr;
 
-		std::vector<vk::Semaphore>	swapSemaphores;
-		std::vector<vk::Fence>		swapFences;
+		struct FrameContext {
+			vk::CommandBuffer	cmdBuffer;
+			vk::Semaphore		acquireSemaphore;	//signalled when the swap image is ready to be drawn into
+			vk::Fence			inFlightFence;		//signalled when the GPU has finished with this frame
+		};
+		std::vector<FrameContext>	frameContexts;
+		uint32_t					currentFrame = 0;
+		uint64_t					streamingUploadWait = 0;	//timeline value this frame's submission waits on, for its upload acquires
+		std::vector<vk::SemaphoreSubmitInfo> frameWaits;	//reused by each SubmitFrame
+		MemorySnapshot				memorySnapshot;
+		FrameCounters				frameCounters;
+		bool						reportedOverBudget = false;
+
+		std::vector<vk::Semaphore>	presentSemaphores;	//per swap image, signalled when its frame is ready to present
+		std::vector<vk::Fence>		imageFences;		//per swap image, the fence of the last frame to draw into it
 
 		vk::SwapchainKHR	swapChain;
+		std::vector<UniqueVulkanTexture> offscreenImages;	//stand in for the swapchain when headless
 		VmaAllocator		memoryAllocator;
 	};
 }
\ No newline at end of file
@@ -6,6 +6,7 @@ Contact:richgdavison@gmail.com
 License: MIT (see LICENSE file at the top of the source tree)
 *//////////////////////////////////////////////////////////////////////////////
 #include "VulkanShaderBase.h"
+#include "VulkanUtils.h"
 extern "C" {
 #include "Spirv-reflect/Spirv_reflect.h"
 }
@@ -129,5 +130,6 @@ void VulkanShaderBase::BuildLayouts(vk::Device device) {
 		vk::DescriptorSetLayoutCreateInfo createInfo;
 		createInfo.setBindings(i);
 		allLayouts.push_back(device.createDescriptorSetLayoutUnique(createInfo));
+		SetDescriptorSetLayoutSizes(*allLayouts.back(), i);
 	}
 }
\ No newline at end of file
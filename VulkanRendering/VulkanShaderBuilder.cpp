@@ -8,6 +8,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "VulkanShaderBuilder.h"
 #include "VulkanUtils.h"
 #include "VulkanShader.h"
+#include "VulkanProfiler.h"
 #include "VulkanDescriptorSetLayoutBuilder.h"
 #include "Assets.h"
 
@@ -62,6 +63,7 @@ ShaderBuilder& ShaderBuilder::WithTessEvalBinary(const string& name, const std::
 }
 
 UniqueVulkanShader ShaderBuilder::Build(const std::string& debugName) {
+	PROFILE_SCOPE("ShaderBuilder::Build", debugName);
 	VulkanShader* newShader = new VulkanShader();
 	//mesh and 'traditional' pipeline are mutually exclusive
 	assert(MessageAssert(!(!shaderFiles[ShaderStages::Mesh].empty() && !shaderFiles[ShaderStages::Vertex].empty()),
@@ -0,0 +1,333 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanStreamingUploader.h"
+#include "VulkanBufferBuilder.h"
+#include "VulkanUtils.h"
+#include "VulkanProfiler.h"
+#include "VulkanFrameCounters.h"
+
+#include <cstring>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+//Enough for buffer copies, and for the texel sizes of any format images are likely to be in
+const vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+StreamingUploader::StreamingUploader(vk::Device device, VmaAllocator allocator, vk::Queue copyQueue, uint32_t copyFamily, uint32_t graphicsFamily, vk::DeviceSize stagingSize) {
+	this->device			= device;
+	this->allocator			= allocator;
+	this->copyQueue			= copyQueue;
+	this->copyFamily		= copyFamily;
+	this->graphicsFamily	= graphicsFamily;
+	this->stagingSize		= stagingSize;
+
+	vk::SemaphoreTypeCreateInfo typeInfo = {
+		.semaphoreType	= vk::SemaphoreType::eTimeline,
+		.initialValue	= 0
+	};
+	timeline = device.createSemaphoreUnique({ .pNext = &typeInfo });
+	SetDebugName(device, vk::ObjectType::eSemaphore, GetVulkanHandle(*timeline), "Streaming Upload Timeline");
+
+	commandPool = device.createCommandPoolUnique({
+		.flags				= vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		.queueFamilyIndex	= copyFamily
+	});
+
+	staging = BufferBuilder(device, allocator)
+		.WithBufferUsage(vk::BufferUsageFlagBits::eTransferSrc)
+		.WithHostVisibility()
+		.WithPersistentMapping()
+		.WithMemoryCategory(MemoryCategory::Staging)
+		.Build(stagingSize, "Streaming Staging Ring");
+
+	stagingData		= (char*)staging.Data();
+	ringHead		= 0;
+	ringUsed		= 0;
+	nextValue		= 1;
+	completedValue	= 0;
+	acquiredValue	= 0;
+}
+
+StreamingUploader::~StreamingUploader() {
+	if (!inFlight.empty()) {
+		uint64_t lastValue = inFlight.back().value;
+		vk::SemaphoreWaitInfo waitInfo = {
+			.semaphoreCount = 1,
+			.pSemaphores	= &*timeline,
+			.pValues		= &lastValue
+		};
+		if (device.waitSemaphores(waitInfo, UINT64_MAX) != vk::Result::eSuccess) {
+			std::cout << __FUNCTION__ << " Streaming uploads taking too long?\n";
+		}
+	}
+	//Anything never flushed is just dropped, the command buffers go with the pool
+	recording.reset();
+	inFlight.clear();
+}
+
+StreamingUploader::Ticket StreamingUploader::UploadBuffer(vk::Buffer dstBuffer, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size, vk::PipelineStageFlags2 dstStages, vk::AccessFlags2 dstAccess) {
+	std::lock_guard guard(lock);
+
+	vk::Buffer		srcBuffer;
+	vk::DeviceSize	srcOffset = 0;
+	memcpy(AllocateStaging(size, srcBuffer, srcOffset), data, size);
+	AddToFrameCounter(FrameCounter::BytesUploaded, size);
+
+	Batch& batch = GetRecordingBatch();
+	batch.cmds.copyBuffer(srcBuffer, dstBuffer, vk::BufferCopy{ .srcOffset = srcOffset, .dstOffset = dstOffset, .size = size });
+
+	batch.acquires.push_back({
+		.buffer		= dstBuffer,
+		.offset		= dstOffset,
+		.size		= size,
+		.dstStages	= dstStages,
+		.dstAccess	= dstAccess
+	});
+	return { batch.value };
+}
+
+StreamingUploader::Ticket StreamingUploader::UploadImage(vk::Image dstImage, const void* data, vk::DeviceSize size, vk::Extent3D extent, uint32_t layerCount, vk::ImageAspectFlags aspects, vk::ImageLayout endLayout, vk::PipelineStageFlags2 dstStages, vk::AccessFlags2 dstAccess) {
+	std::lock_guard guard(lock);
+
+	vk::Buffer		srcBuffer;
+	vk::DeviceSize	srcOffset = 0;
+	memcpy(AllocateStaging(size, srcBuffer, srcOffset), data, size);
+	AddToFrameCounter(FrameCounter::BytesUploaded, size);
+
+	Batch& batch = GetRecordingBatch();
+
+	vk::ImageSubresourceRange range(aspects, 0, 1, 0, layerCount);
+	vk::ImageMemoryBarrier2 toTransfer = {
+		.srcStageMask		= vk::PipelineStageFlagBits2::eNone,
+		.srcAccessMask		= vk::AccessFlagBits2::eNone,
+		.dstStageMask		= vk::PipelineStageFlagBits2::eTransfer,
+		.dstAccessMask		= vk::AccessFlagBits2::eTransferWrite,
+		.oldLayout			= vk::ImageLayout::eUndefined,
+		.newLayout			= vk::ImageLayout::eTransferDstOptimal,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image				= dstImage,
+		.subresourceRange	= range
+	};
+	batch.cmds.pipelineBarrier2({ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toTransfer });
+
+	vk::BufferImageCopy copyRegion = {
+		.bufferOffset		= srcOffset,
+		.imageSubresource	= vk::ImageSubresourceLayers(aspects, 0, 0, layerCount),
+		.imageExtent		= extent
+	};
+	batch.cmds.copyBufferToImage(srcBuffer, dstImage, vk::ImageLayout::eTransferDstOptimal, copyRegion);
+
+	batch.acquires.push_back({
+		.image		= dstImage,
+		.aspects	= aspects,
+		.layerCount = layerCount,
+		.layout		= endLayout,
+		.dstStages	= dstStages,
+		.dstAccess	= dstAccess
+	});
+	return { batch.value };
+}
+
+void StreamingUploader::Flush() {
+	PROFILE_FUNCTION();
+	std::lock_guard guard(lock);
+	if (!recording) {
+		return;
+	}
+	Batch& batch = *recording;
+	RecordOwnershipBarriers(batch.cmds, batch.acquires, true);
+	batch.cmds.end();
+
+	vk::CommandBufferSubmitInfo cmdInfo = {
+		.commandBuffer = batch.cmds
+	};
+	vk::SemaphoreSubmitInfo signalInfo = {
+		.semaphore	= *timeline,
+		.value		= batch.value,
+		.stageMask	= vk::PipelineStageFlagBits2::eAllCommands
+	};
+	vk::SubmitInfo2 submitInfo = {
+		.commandBufferInfoCount		= 1,
+		.pCommandBufferInfos		= &cmdInfo,
+		.signalSemaphoreInfoCount	= 1,
+		.pSignalSemaphoreInfos		= &signalInfo
+	};
+	copyQueue.submit2(submitInfo);
+
+	nextValue++;
+	inFlight.push_back(std::move(batch));
+	recording.reset();
+}
+
+uint64_t StreamingUploader::RecordAcquires(vk::CommandBuffer graphicsCmds) {
+	std::lock_guard guard(lock);
+	RetireCompleted();
+	if (completedValue <= acquiredValue) {
+		return 0;
+	}
+	RecordOwnershipBarriers(graphicsCmds, completedAcquires, false);
+	completedAcquires.clear();
+	acquiredValue = completedValue;
+	return completedValue;
+}
+
+bool StreamingUploader::IsComplete(Ticket t) const {
+	return device.getSemaphoreCounterValue(*timeline) >= t.value;
+}
+
+void StreamingUploader::Wait(Ticket t) {
+	bool needsFlush = false;
+	{
+		std::lock_guard guard(lock);
+		needsFlush = recording && recording->value <= t.value;
+	}
+	if (needsFlush) {
+		Flush();
+	}
+	vk::SemaphoreWaitInfo waitInfo = {
+		.semaphoreCount = 1,
+		.pSemaphores	= &*timeline,
+		.pValues		= &t.value
+	};
+	if (device.waitSemaphores(waitInfo, UINT64_MAX) != vk::Result::eSuccess) {
+		std::cout << __FUNCTION__ << " Streaming upload taking too long?\n";
+	}
+}
+
+StreamingUploader::Batch& StreamingUploader::GetRecordingBatch() {
+	if (!recording) {
+		recording = std::make_unique<Batch>();
+		recording->value = nextValue;
+		if (freeCmds.empty()) {
+			recording->cmds = device.allocateCommandBuffers({
+				.commandPool		= *commandPool,
+				.level				= vk::CommandBufferLevel::ePrimary,
+				.commandBufferCount = 1
+			})[0];
+			SetDebugName(device, vk::ObjectType::eCommandBuffer, GetVulkanHandle(recording->cmds), "Streaming Upload");
+		}
+		else {
+			recording->cmds = freeCmds.back();
+			freeCmds.pop_back();
+		}
+		recording->cmds.begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+	}
+	return *recording;
+}
+
+char* StreamingUploader::AllocateStaging(vk::DeviceSize size, vk::Buffer& buffer, vk::DeviceSize& offset) {
+	Batch& batch = GetRecordingBatch();
+
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		vk::DeviceSize start	= (ringHead + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+		vk::DeviceSize consumed = start - ringHead + size;
+		if (start + size > stagingSize) {	//Doesn't fit before the end, so skip the rest of the ring and start again at 0
+			start		= 0;
+			consumed	= stagingSize - ringHead + size;
+		}
+		if (consumed <= stagingSize - ringUsed) {
+			ringHead		= start + size;
+			ringUsed		+= consumed;
+			batch.ringBytes += consumed;
+
+			buffer = staging.buffer;
+			offset = start;
+			return stagingData + start;
+		}
+		//Some earlier batches might have finished since we last looked
+		RetireCompleted();
+	}
+	//Too big for the ring, or the ring's still full of uploads in flight. Rather than wait for
+	//them, this one gets its own staging buffer, which goes once the batch has finished
+	batch.oversized.push_back(BufferBuilder(device, allocator)
+		.WithBufferUsage(vk::BufferUsageFlagBits::eTransferSrc)
+		.WithHostVisibility()
+		.WithPersistentMapping()
+		.Build(size, "Streaming Staging Overflow"));
+
+	buffer = batch.oversized.back().buffer;
+	offset = 0;
+	return (char*)batch.oversized.back().Data();
+}
+
+void StreamingUploader::RetireCompleted() {
+	uint64_t signalled = device.getSemaphoreCounterValue(*timeline);
+	//Batches are submitted in order, so they finish in order, and the ring frees from the tail
+	while (!inFlight.empty() && inFlight.front().value <= signalled) {
+		Batch& batch = inFlight.front();
+		ringUsed -= batch.ringBytes;
+		freeCmds.push_back(batch.cmds);
+		completedAcquires.insert(completedAcquires.end(), batch.acquires.begin(), batch.acquires.end());
+		completedValue = batch.value;
+		inFlight.pop_front();
+	}
+	if (ringUsed == 0) {
+		ringHead = 0;
+	}
+}
+
+void StreamingUploader::RecordOwnershipBarriers(vk::CommandBuffer cmds, const std::vector<Acquire>& acquires, bool release) {
+	bool transfersOwnership = copyFamily != graphicsFamily;
+	if (!release && !transfersOwnership) {
+		return; //The semaphore wait covers everything
+	}
+	std::vector<vk::BufferMemoryBarrier2>	bufferBarriers;
+	std::vector<vk::ImageMemoryBarrier2>	imageBarriers;
+
+	for (const Acquire& a : acquires) {
+		//A release only has a source scope, and a matching acquire only a destination one
+		vk::PipelineStageFlags2 srcStages	= release ? vk::PipelineStageFlags2(vk::PipelineStageFlagBits2::eTransfer)	: vk::PipelineStageFlagBits2::eNone;
+		vk::AccessFlags2		srcAccess	= release ? vk::AccessFlags2(vk::AccessFlagBits2::eTransferWrite)			: vk::AccessFlagBits2::eNone;
+		vk::PipelineStageFlags2 dstStages	= release ? vk::PipelineStageFlags2(vk::PipelineStageFlagBits2::eNone)		: a.dstStages;
+		vk::AccessFlags2		dstAccess	= release ? vk::AccessFlags2(vk::AccessFlagBits2::eNone)					: a.dstAccess;
+		if (!transfersOwnership) {
+			//Same family, so just the image layout to sort out, before the semaphore is signalled
+			dstStages = vk::PipelineStageFlagBits2::eAllCommands;
+		}
+		uint32_t srcFamily = transfersOwnership ? copyFamily		: VK_QUEUE_FAMILY_IGNORED;
+		uint32_t dstFamily = transfersOwnership ? graphicsFamily	: VK_QUEUE_FAMILY_IGNORED;
+
+		if (a.image) {
+			imageBarriers.push_back({
+				.srcStageMask			= srcStages,
+				.srcAccessMask			= srcAccess,
+				.dstStageMask			= dstStages,
+				.dstAccessMask			= dstAccess,
+				.oldLayout				= vk::ImageLayout::eTransferDstOptimal,
+				.newLayout				= a.layout,
+				.srcQueueFamilyIndex	= srcFamily,
+				.dstQueueFamilyIndex	= dstFamily,
+				.image					= a.image,
+				.subresourceRange		= vk::ImageSubresourceRange(a.aspects, 0, 1, 0, a.layerCount)
+			});
+		}
+		else if (transfersOwnership) {
+			bufferBarriers.push_back({
+				.srcStageMask			= srcStages,
+				.srcAccessMask			= srcAccess,
+				.dstStageMask			= dstStages,
+				.dstAccessMask			= dstAccess,
+				.srcQueueFamilyIndex	= srcFamily,
+				.dstQueueFamilyIndex	= dstFamily,
+				.buffer					= a.buffer,
+				.offset					= a.offset,
+				.size					= a.size
+			});
+		}
+	}
+	if (bufferBarriers.empty() && imageBarriers.empty()) {
+		return;
+	}
+	vk::DependencyInfo dependencyInfo;
+	dependencyInfo.setBufferMemoryBarriers(bufferBarriers);
+	dependencyInfo.setImageMemoryBarriers(imageBarriers);
+	cmds.pipelineBarrier2(dependencyInfo);
+}
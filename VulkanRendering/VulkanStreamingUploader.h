@@ -0,0 +1,138 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "VulkanBuffers.h"
+#include <mutex>
+#include <deque>
+#include <atomic>
+
+namespace NCL::Rendering::Vulkan {
+	/*
+	StreamingUploader: Gets buffer and image data onto the GPU using the
+	copy queue, so loading assets never waits on, or holds up, the frame.
+
+	Data is copied into a persistently mapped staging ring straight away,
+	so the source can be freed as soon as an Upload call returns, and the
+	copy is recorded into a batch. Flush submits the batch to the copy
+	queue, signalling a timeline semaphore value - every upload returns a
+	Ticket holding the value its batch will signal.
+
+	If the copy queue is from a different family to the graphics queue,
+	the resource's ownership is released at the end of the batch, and
+	acquired again on the graphics queue at the start of the first frame
+	after the copy has finished. VulkanRenderer does this in BeginFrame,
+	along with Flush, and makes the frame wait on the semaphore. A ticket
+	IsReady once that's happened, and the resource can be used by anything
+	recorded in that frame or later - render code only has to check the
+	tickets of what it's about to draw.
+
+	Upload calls can be made from any thread. Flush and RecordAcquires
+	submit to queues, so belong on the render thread.
+	*/
+	class StreamingUploader	{
+	public:
+		struct Ticket {
+			uint64_t value = 0;
+		};
+
+		StreamingUploader(vk::Device device, VmaAllocator allocator, vk::Queue copyQueue, uint32_t copyFamily, uint32_t graphicsFamily, vk::DeviceSize stagingSize = 64 * 1024 * 1024);
+		~StreamingUploader();
+
+		//stages / access are of the first use on the graphics queue
+		Ticket UploadBuffer(vk::Buffer dstBuffer, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size,
+			vk::PipelineStageFlags2 dstStages = vk::PipelineStageFlagBits2::eVertexInput | vk::PipelineStageFlagBits2::eComputeShader,
+			vk::AccessFlags2 dstAccess = vk::AccessFlagBits2::eMemoryRead);
+
+		//Fills mip level 0 of every layer, with the layers packed one after another. The image is left in endLayout
+		Ticket UploadImage(vk::Image dstImage, const void* data, vk::DeviceSize size, vk::Extent3D extent, uint32_t layerCount = 1,
+			vk::ImageAspectFlags aspects = vk::ImageAspectFlagBits::eColor,
+			vk::ImageLayout endLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::PipelineStageFlags2 dstStages = vk::PipelineStageFlagBits2::eFragmentShader,
+			vk::AccessFlags2 dstAccess = vk::AccessFlagBits2::eShaderSampledRead);
+
+		//Submits everything uploaded since the last Flush
+		void Flush();
+
+		//Records the graphics queue side of every upload that has finished since the last call, returning
+		//the semaphore value the submission containing graphicsCmds must wait on, or 0 if there's nothing to wait on
+		uint64_t RecordAcquires(vk::CommandBuffer graphicsCmds);
+
+		//The copy has finished, and has been acquired by a frame that's already been recorded
+		bool IsReady(Ticket t) const {
+			return t.value <= acquiredValue;
+		}
+		//Only says the copy has finished - the graphics queue might not own the resource yet
+		bool IsComplete(Ticket t) const;
+
+		//Blocks until the copy has finished, flushing it first if need be
+		void Wait(Ticket t);
+
+		vk::Semaphore GetSemaphore() const {
+			return *timeline;
+		}
+
+		vk::DeviceSize GetStagingSize() const {
+			return stagingSize;
+		}
+
+	protected:
+		struct Acquire {
+			vk::Buffer				buffer;
+			vk::DeviceSize			offset	= 0;
+			vk::DeviceSize			size	= 0;
+
+			vk::Image				image;
+			vk::ImageAspectFlags	aspects;
+			uint32_t				layerCount = 0;
+			vk::ImageLayout			layout;
+
+			vk::PipelineStageFlags2 dstStages;
+			vk::AccessFlags2		dstAccess;
+		};
+
+		struct Batch {
+			uint64_t			value		= 0;
+			vk::CommandBuffer	cmds;
+			vk::DeviceSize		ringBytes	= 0;	//including any space skipped over when the ring wrapped
+			std::vector<VulkanBuffer>	oversized;	//staging that didn't fit in the ring
+			std::vector<Acquire>		acquires;
+		};
+
+		//Where to write the data, either in the staging ring or, if it won't fit, a one-off buffer kept by the batch
+		char*		AllocateStaging(vk::DeviceSize size, vk::Buffer& buffer, vk::DeviceSize& offset);
+		Batch&		GetRecordingBatch();
+		void		RetireCompleted();
+		void		RecordOwnershipBarriers(vk::CommandBuffer cmds, const std::vector<Acquire>& acquires, bool release);
+
+		vk::Device		device;
+		VmaAllocator	allocator;
+		vk::Queue		copyQueue;
+		uint32_t		copyFamily;
+		uint32_t		graphicsFamily;
+
+		vk::UniqueSemaphore		timeline;
+		vk::UniqueCommandPool	commandPool;
+		std::vector<vk::CommandBuffer> freeCmds;
+
+		VulkanBuffer	staging;
+		char*			stagingData;
+		vk::DeviceSize	stagingSize;
+		vk::DeviceSize	ringHead;
+		vk::DeviceSize	ringUsed;
+
+		std::unique_ptr<Batch>	recording;
+		std::deque<Batch>		inFlight;
+		std::vector<Acquire>	completedAcquires;
+
+		uint64_t				nextValue;		//the value the batch being recorded will signal
+		uint64_t				completedValue;	//every batch up to here has finished, and had its staging freed
+		std::atomic<uint64_t>	acquiredValue;	//every batch up to here is safe to use on the graphics queue
+
+		mutable std::mutex	lock;
+	};
+}
@@ -24,6 +24,7 @@ VulkanTexture::VulkanTexture() {
 
 VulkanTexture::~VulkanTexture() {
 	if (image) {
+		UntrackAllocation(allocationHandle);
 		vmaDestroyImage(allocator, image, allocationHandle);
 	}
 }
@@ -31,6 +31,10 @@ namespace NCL::Rendering::Vulkan {
 			return image;
 		}
 
+		uint32_t GetMipCount() const {
+			return mipCount;
+		}
+
 		//Allows us to pass a texture as vk type to various functions
 		operator vk::Image() const {
 			return image;
@@ -8,6 +8,9 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "VulkanTextureBuilder.h"
 #include "VulkanTexture.h"
 #include "VulkanUtils.h"
+#include "VulkanProfiler.h"
+#include "VulkanThreadPool.h"
+#include "VulkanFrameCounters.h"
 #include "VulkanBufferBuilder.h"
 #include "TextureLoader.h"
 
@@ -20,12 +23,14 @@ TextureBuilder::TextureBuilder(vk::Device inDevice, VmaAllocator inAllocator) {
     sourceAllocator = inAllocator;
 
     generateMips    = true;
+    blitMips        = true;
 
     format      = vk::Format::eR8G8B8A8Unorm;
     layout      = vk::ImageLayout::eShaderReadOnlyOptimal;
     usages      = vk::ImageUsageFlagBits::eSampled;
     aspects     = vk::ImageAspectFlagBits::eColor;
     pipeFlags   = vk::PipelineStageFlagBits2::eFragmentShader;
+    category    = MemoryCategory::MAX_CATEGORIES;
 
     layerCount      = 1;
 }
@@ -65,14 +70,20 @@ TextureBuilder& TextureBuilder::WithLayerCount(uint32_t layers) {
     return *this;
 }
 
+TextureBuilder& TextureBuilder::WithMemoryCategory(MemoryCategory c) {
+    category = c;
+    return *this;
+}
+
 
-TextureBuilder& TextureBuilder::WithMips(bool inMips) {
+TextureBuilder& TextureBuilder::WithMips(bool inMips, bool inBlitMips) {
     generateMips = inMips;
+    blitMips     = inBlitMips;
     return *this;
 }
 
 TextureBuilder& TextureBuilder::WithCommandBuffer(vk::CommandBuffer inBuffer) {
-    assert(MessageAssert(queue == 0 && pool == 0, "Builder is either passed a command buffer OR uses a queue and pool!"));
+    assert(MessageAssert(queue == 0 && pool == 0 && !context, "Builder is either passed a command buffer OR uses a queue and pool!"));
     cmdBuffer = inBuffer;
     return *this;
 }
@@ -89,12 +100,18 @@ TextureBuilder& TextureBuilder::UsingPool(vk::CommandPool inPool) {
     return *this;
 }
 
+TextureBuilder& TextureBuilder::UsingContext(ImmediateContext& inContext) {
+    assert(MessageAssert(cmdBuffer == 0, "Builder is either passed a command buffer OR uses a context!"));
+    context = &inContext;
+    return *this;
+}
+
 UniqueVulkanTexture TextureBuilder::Build(const std::string& debugName) {
     vk::UniqueCommandBuffer	uniqueBuffer;
     vk::CommandBuffer	    usingBuffer;
     BeginTexture(debugName, uniqueBuffer, usingBuffer);
 
-    if (generateMips) {
+    if (generateMips && blitMips) {
         usages |= vk::ImageUsageFlagBits::eTransferSrc;
         usages |= vk::ImageUsageFlagBits::eTransferDst;
     }
@@ -115,6 +132,10 @@ void TextureBuilder::BeginTexture(const std::string& debugName, vk::UniqueComman
     if (cmdBuffer) {
         usingBuffer = cmdBuffer;
     }
+    //We're recording into an immediate context, which handles the submission
+    else if (context) {
+        usingBuffer = context->Begin(debugName + " Creation");
+    }
     //We're in charge of our own command buffers
     else if (queue && pool) {
         uniqueBuffer = Vulkan::CmdBufferBegin(sourceDevice, pool, debugName + " Creation");
@@ -128,14 +149,24 @@ void TextureBuilder::BeginTexture(const std::string& debugName, vk::UniqueComman
 void TextureBuilder::EndTexture(const std::string& debugName, vk::UniqueCommandBuffer& uniqueBuffer, vk::CommandBuffer& usingBuffer, TextureJob& job, UniqueVulkanTexture& t) {
     if (generateMips) {
         int mipCount = VulkanTexture::GetMaxMips(t->GetDimensions());
-        if (mipCount > 1) {
-            t->mipCount = mipCount;
+        t->mipCount = mipCount;
+        if (mipCount > 1 && blitMips) {
             t->GenerateMipMaps(usingBuffer);
         }
     }
 
+    //The context might batch this up with other work, so the source data has to stay around until it's done
+    if (context) {
+        auto staging = std::make_shared<VulkanBuffer>(std::move(job.stagingBuffer));
+        context->OnComplete([staging, dataSrcs = job.dataSrcs]() {
+            for (const auto& i : dataSrcs) {
+                TextureLoader::DeleteTextureData(i);
+            }
+        });
+        context->Submit();
+    }
     //If we're in charge of our own buffers, we just stop and wait for completion now
-    if (uniqueBuffer) {
+    else if (uniqueBuffer) {
         CmdBufferEndSubmitWait(usingBuffer, sourceDevice, queue);
         for (const auto& i : job.dataSrcs) {
             TextureLoader::DeleteTextureData(i);
@@ -150,16 +181,46 @@ void TextureBuilder::EndTexture(const std::string& debugName, vk::UniqueCommandB
 }
 
 UniqueVulkanTexture TextureBuilder::BuildFromFile(const std::string& filename) {
+    PROFILE_SCOPE("TextureBuilder::BuildFromFile", filename);
     char* texData = nullptr;
     Vector3i dimensions(0, 0, 1);
     int channels    = 0;
     int flags       = 0;
     TextureLoader::LoadTexture(filename, texData, dimensions.x, dimensions.y, channels, flags);
 
+    return BuildFromLoadedData(filename, texData, dimensions, channels);
+}
+
+std::vector<UniqueVulkanTexture> TextureBuilder::BuildFromFiles(const std::vector<std::string>& filenames) {
+    PROFILE_SCOPE("TextureBuilder::BuildFromFiles");
+    struct LoadedFile {
+        char*       texData     = nullptr;
+        Vector3i    dimensions  = Vector3i(0, 0, 1);
+        int         channels    = 0;
+        int         flags       = 0;
+    };
+    //Decoding is the slow part, and each file is independent. Recording the uploads stays on this thread
+    std::vector<LoadedFile> loaded(filenames.size());
+    ThreadPool::Shared().ParallelFor((uint32_t)filenames.size(), 1, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            PROFILE_SCOPE("TextureLoader::LoadTexture", filenames[i]);
+            TextureLoader::LoadTexture(filenames[i], loaded[i].texData, loaded[i].dimensions.x, loaded[i].dimensions.y, loaded[i].channels, loaded[i].flags);
+        }
+    });
+
+    std::vector<UniqueVulkanTexture> textures;
+    textures.reserve(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        textures.push_back(BuildFromLoadedData(filenames[i], loaded[i].texData, loaded[i].dimensions, loaded[i].channels));
+    }
+    return textures;
+}
+
+UniqueVulkanTexture TextureBuilder::BuildFromLoadedData(const std::string& debugName, char* texData, Vector3i dimensions, int channels) {
     vk::UniqueCommandBuffer	uniqueBuffer;
     vk::CommandBuffer	    usingBuffer;
 
-    BeginTexture(filename, uniqueBuffer, usingBuffer);
+    BeginTexture(debugName, uniqueBuffer, usingBuffer);
 
     vk::ImageUsageFlags	realUsages = usages;
 
@@ -169,7 +230,7 @@ UniqueVulkanTexture TextureBuilder::BuildFromFile(const std::string& filename) {
         usages |= vk::ImageUsageFlagBits::eTransferSrc;
     }
 
-    UniqueVulkanTexture tex = GenerateTexture(usingBuffer, dimensions, false, filename);
+    UniqueVulkanTexture tex = GenerateTexture(usingBuffer, dimensions, false, debugName);
 
     TextureJob job;
     job.dataSrcs = {texData};
@@ -178,7 +239,7 @@ UniqueVulkanTexture TextureBuilder::BuildFromFile(const std::string& filename) {
 
     UploadTextureData(usingBuffer, job, dimensions, channels, vk::ImageAspectFlagBits::eColor);
 
-    EndTexture(filename, uniqueBuffer, usingBuffer, job, tex);
+    EndTexture(debugName, uniqueBuffer, usingBuffer, job, tex);
 
     usages = realUsages;
 
@@ -190,6 +251,7 @@ UniqueVulkanTexture TextureBuilder::BuildCubemapFromFile(
     const std::string& negativeYFile, const std::string& positiveYFile,
     const std::string& negativeZFile, const std::string& positiveZFile,
     const std::string& debugName) {
+    PROFILE_SCOPE("TextureBuilder::BuildCubemapFromFile", debugName);
 
     TextureJob job;
     job.dataSrcs.resize(6);
@@ -208,9 +270,11 @@ UniqueVulkanTexture TextureBuilder::BuildCubemapFromFile(
         &positiveZFile
     };
 
-    for (int i = 0; i < 6; ++i) {
-        TextureLoader::LoadTexture(*filenames[i], job.dataSrcs[i], dimensions[i].x, dimensions[i].y, channels[i], flags[i]);
-    }
+    ThreadPool::Shared().ParallelFor(6, 1, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            TextureLoader::LoadTexture(*filenames[i], job.dataSrcs[i], dimensions[i].x, dimensions[i].y, channels[i], flags[i]);
+        }
+    });
 
     vk::UniqueCommandBuffer	uniqueBuffer;
     vk::CommandBuffer	    usingBuffer;
@@ -274,6 +338,16 @@ UniqueVulkanTexture	TextureBuilder::GenerateTexture(vk::CommandBuffer cmdBuffer,
 	vmaallocInfo.usage = VMA_MEMORY_USAGE_AUTO;
 	vmaCreateImage(sourceAllocator, (VkImageCreateInfo*)&createInfo, &vmaallocInfo, (VkImage*)&t->image, &t->allocationHandle, &t->allocationInfo);
 
+	MemoryCategory trackAs = category;
+	if (trackAs == MemoryCategory::MAX_CATEGORIES) {
+		trackAs = (usages & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment)) ?
+			MemoryCategory::RenderTargets : MemoryCategory::Textures;
+	}
+	TrackAllocation(sourceAllocator, t->allocationHandle, trackAs);
+	if (!debugName.empty()) {
+		vmaSetAllocationName(sourceAllocator, t->allocationHandle, debugName.c_str());
+	}
+
     vk::ImageViewType viewType = layerCount > 1 ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D;
     if (isCube) {
         viewType = layerCount > 1 ? vk::ImageViewType::eCubeArray : vk::ImageViewType::eCube;
@@ -319,6 +393,7 @@ void TextureBuilder::UploadTextureData(vk::CommandBuffer buffer, TextureJob& job
         gpuPtr += faceSize;     
     }
     job.stagingBuffer.Unmap();
+    AddToFrameCounter(FrameCounter::BytesUploaded, allocationSize);
 
     //We'll also set up each layer of the image to accept new transfers
     ImageTransitionBarrier(buffer, job.image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, aspectFlags, vk::PipelineStageFlagBits2::eHost, vk::PipelineStageFlagBits2::eTransfer, 0, 1, 0);
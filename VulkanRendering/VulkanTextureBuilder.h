@@ -10,6 +10,8 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "VulkanBuffers.h"
 
 namespace NCL::Rendering::Vulkan {
+	class ImmediateContext;
+
 	class TextureBuilder	{
 	public:
 		TextureBuilder(vk::Device device, VmaAllocator allocator);
@@ -24,17 +26,26 @@ namespace NCL::Rendering::Vulkan {
 		TextureBuilder& WithCommandBuffer(vk::CommandBuffer buffer);
 		TextureBuilder& UsingQueue(vk::Queue queue);
 		TextureBuilder& UsingPool(vk::CommandPool pool);
+		//Records into the context, which can batch several textures into one submission
+		TextureBuilder& UsingContext(ImmediateContext& context);
 
-		TextureBuilder& WithMips(bool state);
+		//If blitMips is false, the mip chain is allocated but left for the caller to fill (e.g. from a compute pass)
+		TextureBuilder& WithMips(bool state, bool blitMips = true);
 		TextureBuilder& WithDimension(uint32_t width, uint32_t height, uint32_t depth = 1);
 		TextureBuilder& WithLayerCount(uint32_t layers);
 
+		//What the memory stats count the texture as. If not set, attachments are render targets, and anything else a texture
+		TextureBuilder& WithMemoryCategory(MemoryCategory category);
+
 		//Builds an empty texture
 		UniqueVulkanTexture Build(const std::string& debugName = "");
 
 		//Builds a texture loaded from file
 		UniqueVulkanTexture BuildFromFile(const std::string& filename);
 
+		//Builds a texture from each file, decoding them all at once on the shared ThreadPool
+		std::vector<UniqueVulkanTexture> BuildFromFiles(const std::vector<std::string>& filenames);
+
 		//Builds an empty cubemap
 		UniqueVulkanTexture BuildCubemap(const std::string& debugName = "");
 
@@ -86,18 +97,22 @@ namespace NCL::Rendering::Vulkan {
 		void EndTexture(const std::string& debugName, vk::UniqueCommandBuffer& uniqueBuffer, vk::CommandBuffer& usingBuffer, TextureJob& job, UniqueVulkanTexture& t);
 
 		UniqueVulkanTexture	GenerateTexture(vk::CommandBuffer cmdBuffer, Maths::Vector3i dimensions, bool isCube, const std::string& debugName);
+		//Takes ownership of texData, which must have come from TextureLoader
+		UniqueVulkanTexture	BuildFromLoadedData(const std::string& debugName, char* texData, Maths::Vector3i dimensions, int channels);
 
 		void UploadTextureData(vk::CommandBuffer buffer, TextureJob& job, Maths::Vector3i dimensions, uint32_t channelCount, vk::ImageAspectFlags aspectFlags);
 
 		NCL::Maths::Vector3i	requestedSize;
 		uint32_t				layerCount;
 		bool					generateMips;
+		bool					blitMips;
 
 		vk::Format				format;
 		vk::ImageLayout			layout;
 		vk::ImageAspectFlags	aspects;
 		vk::ImageUsageFlags		usages;
 		vk::PipelineStageFlags2	pipeFlags;
+		MemoryCategory			category;
 
 		vk::Device			sourceDevice;
 		VmaAllocator		sourceAllocator;
@@ -105,6 +120,7 @@ namespace NCL::Rendering::Vulkan {
 		vk::Queue			queue;
 		vk::CommandPool		pool;
 		vk::CommandBuffer	cmdBuffer;
+		ImmediateContext*	context = nullptr;
 
 		std::vector<TextureJob> activeJobs;
 	};
@@ -0,0 +1,278 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanThreadPool.h"
+#include "VulkanProfiler.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+namespace {
+	//Which pool's worker this thread is, if any, so tasks it schedules can go on its own queue
+	thread_local const ThreadPool*	workerPool	= nullptr;
+	thread_local uint32_t			workerIndex = 0;
+}
+
+bool ThreadPool::TaskHandle::IsDone() const {
+	return !task || task->done;
+}
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+	if (threadCount == 0) {
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	for (uint32_t i = 0; i <= threadCount; ++i) {
+		queues.push_back(std::make_unique<TaskQueue>());
+	}
+	for (uint32_t i = 0; i < threadCount; ++i) {
+		workers.emplace_back([this, i]() {
+			Profiler::SetThreadName("Thread Pool Worker " + std::to_string(i));
+			workerPool	= this;
+			workerIndex = i;
+			WorkerLoop(i);
+		});
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard lock(sleepLock);
+		stopping = true;
+	}
+	taskAdded.notify_all();
+	for (auto& i : workers) {
+		i.join();
+	}
+}
+
+ThreadPool::TaskHandle ThreadPool::Schedule(std::function<void()>&& work, std::span<const TaskHandle> dependencies) {
+	TaskHandle handle;
+	handle.task = std::make_shared<Task>();
+	handle.task->work = std::move(work);
+	//Held at 1 while the dependencies are added, so finishing one of them can't let the task run early
+	handle.task->waitingOn = 1;
+
+	for (const TaskHandle& d : dependencies) {
+		if (!d.task) {
+			continue;
+		}
+		std::lock_guard lock(d.task->dependentsLock);
+		if (!d.task->done) {
+			handle.task->waitingOn++;
+			handle.task->dependencies.push_back(d.task);
+			d.task->dependents.push_back(handle.task);
+		}
+		else if (d.task->exception && !handle.task->exception) {
+			handle.task->exception = d.task->exception;
+		}
+	}
+	if (--handle.task->waitingOn == 0) {
+		Enqueue(std::shared_ptr<Task>(handle.task));
+	}
+	return handle;
+}
+
+void ThreadPool::ParallelFor(uint32_t itemCount, uint32_t minItemsPerRange, const std::function<void(uint32_t first, uint32_t count)>& func) {
+	if (itemCount == 0) {
+		return;
+	}
+	//A few ranges per thread, so a thread that finishes early has something left to steal
+	minItemsPerRange		= std::max(minItemsPerRange, 1u);
+	uint32_t rangeCount		= std::clamp((itemCount + minItemsPerRange - 1) / minItemsPerRange, 1u, (GetThreadCount() + 1) * 4);
+	uint32_t itemsPerRange	= (itemCount + rangeCount - 1) / rangeCount;
+	rangeCount				= (itemCount + itemsPerRange - 1) / itemsPerRange;
+
+	if (rangeCount == 1) {
+		func(0, itemCount);
+		return;
+	}
+	std::vector<TaskHandle> ranges;
+	ranges.reserve(rangeCount);
+	for (uint32_t i = 0; i < rangeCount; ++i) {
+		uint32_t first = i * itemsPerRange;
+		uint32_t count = std::min(itemsPerRange, itemCount - first);
+		ranges.push_back(Schedule([&func, first, count]() { func(first, count); }));
+	}
+	WaitAll(ranges);
+}
+
+void ThreadPool::Wait(const TaskHandle& handle) {
+	WaitAll(std::span(&handle, 1));
+}
+
+void ThreadPool::WaitAll(std::span<const TaskHandle> handles) {
+	size_t firstLeft = 0;
+	while (true) {
+		uint64_t seenProgress = progress;
+		while (firstLeft < handles.size() && handles[firstLeft].IsDone()) {
+			firstLeft++;
+		}
+		if (firstLeft == handles.size()) {
+			break;
+		}
+		bool ranTask = false;
+		for (size_t i = firstLeft; i < handles.size() && !ranTask; ++i) {
+			ranTask = !handles[i].IsDone() && TryRunWaitedTask(handles[i].task);
+		}
+		if (ranTask) {
+			continue;
+		}
+		//Whatever's left is already running on other threads, or waiting on something that is
+		waitingThreads++;
+		{
+			std::unique_lock lock(sleepLock);
+			waitProgress.wait(lock, [&]() { return progress != seenProgress; });
+		}
+		waitingThreads--;
+	}
+	for (const TaskHandle& h : handles) {
+		if (h.task && h.task->exception) {
+			std::rethrow_exception(h.task->exception);
+		}
+	}
+}
+
+void ThreadPool::Enqueue(std::shared_ptr<Task>&& task) {
+	uint32_t queueIndex = LocalQueueIndex();
+	TaskQueue& q = *queues[queueIndex];
+	{
+		std::lock_guard lock(q.lock);
+		task->queueIndex = queueIndex;
+		q.tasks.push_back(std::move(task));
+	}
+	queuedTasks++;
+	progress++;
+	{	//Taken so a thread can't miss the count going up between checking it and going to sleep
+		std::lock_guard lock(sleepLock);
+	}
+	taskAdded.notify_one();
+	if (waitingThreads > 0) {
+		waitProgress.notify_all();
+	}
+}
+
+bool ThreadPool::TryTakeTask(uint32_t queueIndex, std::shared_ptr<Task>& task) {
+	if (queuedTasks == 0) {
+		return false;
+	}
+	uint32_t queueCount = (uint32_t)queues.size();
+	for (uint32_t i = 0; i < queueCount; ++i) {
+		uint32_t index = (queueIndex + i) % queueCount;
+		TaskQueue& q = *queues[index];
+		std::lock_guard lock(q.lock);
+		if (q.tasks.empty()) {
+			continue;
+		}
+		//Workers take the newest from their own queue, and the oldest from anyone else's
+		if (i == 0 && index != SharedQueueIndex()) {
+			task = std::move(q.tasks.back());
+			q.tasks.pop_back();
+		}
+		else {
+			task = std::move(q.tasks.front());
+			q.tasks.pop_front();
+		}
+		queuedTasks--;
+		return true;
+	}
+	return false;
+}
+
+bool ThreadPool::TryRunWaitedTask(const std::shared_ptr<Task>& task) {
+	if (task->done) {
+		return false;
+	}
+	uint32_t queueIndex = task->queueIndex;
+	if (queueIndex == UINT32_MAX) {
+		//Not runnable yet, but whatever's holding it up might be
+		for (const std::weak_ptr<Task>& d : task->dependencies) {
+			std::shared_ptr<Task> dependency = d.lock();
+			if (dependency && TryRunWaitedTask(dependency)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	{
+		TaskQueue& q = *queues[queueIndex];
+		std::lock_guard lock(q.lock);
+		auto i = std::find(q.tasks.begin(), q.tasks.end(), task);
+		if (i == q.tasks.end()) {
+			return false;	//Another thread has already started it
+		}
+		q.tasks.erase(i);
+		queuedTasks--;
+	}
+	RunTask(task);
+	return true;
+}
+
+void ThreadPool::RunTask(const std::shared_ptr<Task>& task) {
+	//A task whose dependency failed has already been given its exception, and isn't run
+	if (!task->exception) {
+		try {
+			task->work();
+		}
+		catch (...) {
+			task->exception = std::current_exception();
+		}
+	}
+	task->work = nullptr;	//Lets go of anything it captured, even if a handle keeps the task itself around
+
+	std::vector<std::shared_ptr<Task>> dependents;
+	{
+		std::lock_guard lock(task->dependentsLock);
+		task->done = true;
+		dependents.swap(task->dependents);
+	}
+	for (auto& d : dependents) {
+		if (task->exception) {
+			std::lock_guard lock(d->dependentsLock);
+			if (!d->exception) {
+				d->exception = task->exception;
+			}
+		}
+		if (--d->waitingOn == 0) {
+			Enqueue(std::move(d));
+		}
+	}
+	progress++;
+	if (waitingThreads > 0) {
+		{
+			std::lock_guard lock(sleepLock);
+		}
+		waitProgress.notify_all();
+	}
+}
+
+void ThreadPool::WorkerLoop(uint32_t index) {
+	while (true) {
+		std::shared_ptr<Task> task;
+		if (TryTakeTask(index, task)) {
+			RunTask(task);
+			continue;
+		}
+		std::unique_lock lock(sleepLock);
+		taskAdded.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+		//Anything already queued still gets run, so no future is left waiting forever
+		if (stopping && queuedTasks == 0) {
+			return;
+		}
+	}
+}
+
+uint32_t ThreadPool::LocalQueueIndex() const {
+	return workerPool == this ? workerIndex : SharedQueueIndex();
+}
+
+ThreadPool& ThreadPool::Shared() {
+	static ThreadPool pool;
+	return pool;
+}
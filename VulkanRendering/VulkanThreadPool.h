@@ -0,0 +1,135 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <span>
+#include <thread>
+
+namespace NCL::Rendering::Vulkan {
+	/*
+	A fixed set of worker threads, shared by anything with CPU work that can
+	be split up - loading, building pipelines, recording command buffers -
+	so nothing needs to make threads of its own.
+
+	Each worker has its own queue. Tasks scheduled from a worker go on the
+	back of that worker's queue, and it takes from the back too, so work it
+	has just split up is run while its data is still in cache. A worker with
+	nothing to do steals from the front of the others' queues. Tasks from
+	any other thread go on a shared queue, which every worker takes from.
+
+	A task can be made to wait for others to finish before it's run. Wait
+	takes the tasks it's waiting on (or the ones they're waiting on) off
+	the queues and runs them itself, so the thread calling it helps out
+	rather than sitting idle, and a task can wait on others without tying
+	up its worker. It never picks up anything else, so the render thread
+	waiting on a few command buffers can't get stuck in a long pipeline
+	compile it didn't ask for.
+
+	A task that throws still counts as finished, and Wait, WaitAll and
+	ParallelFor rethrow its exception once everything they're waiting on
+	is done. Anything depending on it isn't run, and fails with the same
+	exception. Submit's future gets the exception instead.
+	*/
+	class ThreadPool {
+	protected:
+		struct Task;
+	public:
+		//Something to wait on, or for other tasks to wait on. An empty handle has always finished
+		class TaskHandle {
+		public:
+			bool IsDone() const;
+		protected:
+			friend class ThreadPool;
+			std::shared_ptr<Task> task;
+		};
+
+		//0 threads means one per hardware thread
+		ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		template <typename F>
+		auto Submit(F&& task) -> std::future<std::invoke_result_t<F>> {
+			//std::function needs something copyable, which packaged_task isn't
+			auto work = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(task));
+			auto result = work->get_future();
+			Schedule([work]() { (*work)(); });
+			return result;
+		}
+
+		//Runs task once all of its dependencies have finished
+		TaskHandle Schedule(std::function<void()>&& task, std::span<const TaskHandle> dependencies = {});
+		TaskHandle Schedule(std::function<void()>&& task, std::initializer_list<TaskHandle> dependencies) {
+			return Schedule(std::move(task), std::span(dependencies.begin(), dependencies.size()));
+		}
+
+		//Calls func(first, count) on ranges covering [0, itemCount), each at least minItemsPerRange long
+		//unless it's the last, spread over the pool and the calling thread. Returns once they've all finished
+		void ParallelFor(uint32_t itemCount, uint32_t minItemsPerRange, const std::function<void(uint32_t first, uint32_t count)>& func);
+
+		//Runs the tasks waited on, and anything they depend on, until they've all finished.
+		//Then rethrows the first exception any of them threw
+		void Wait(const TaskHandle& handle);
+		void WaitAll(std::span<const TaskHandle> handles);
+
+		uint32_t GetThreadCount() const {
+			return (uint32_t)workers.size();
+		}
+
+		//Shared by everything in the renderer, created on first use
+		static ThreadPool& Shared();
+
+	protected:
+		struct Task {
+			std::function<void()>	work;
+			std::atomic<uint32_t>	waitingOn	= 0;
+			std::atomic<bool>		done		= false;
+			std::atomic<uint32_t>	queueIndex	= UINT32_MAX;	//Set once it's been queued
+			std::exception_ptr		exception;	//From it or a dependency, read once it's done
+
+			std::vector<std::weak_ptr<Task>>	dependencies;	//Fixed once Schedule returns
+
+			std::mutex							dependentsLock;
+			std::vector<std::shared_ptr<Task>>	dependents;	//Tasks waiting on this one
+		};
+		struct TaskQueue {
+			std::mutex							lock;
+			std::deque<std::shared_ptr<Task>>	tasks;
+		};
+
+		void Enqueue(std::shared_ptr<Task>&& task);
+		bool TryTakeTask(uint32_t queueIndex, std::shared_ptr<Task>& task);
+		//Runs task, or something it depends on, if it's still queued
+		bool TryRunWaitedTask(const std::shared_ptr<Task>& task);
+		void RunTask(const std::shared_ptr<Task>& task);
+		void WorkerLoop(uint32_t index);
+
+		//The queue tasks scheduled from this thread go on
+		uint32_t LocalQueueIndex() const;
+		//Workers are still being added as the first ones start, so this goes by the queues, which are all made first
+		uint32_t SharedQueueIndex() const {
+			return (uint32_t)queues.size() - 1;
+		}
+
+		std::vector<std::thread>				workers;
+		std::vector<std::unique_ptr<TaskQueue>>	queues;		//One per worker, then the shared queue on the end
+
+		std::atomic<uint32_t>		queuedTasks		= 0;
+		std::atomic<uint32_t>		waitingThreads	= 0;	//In Wait, with nothing left to run
+		std::atomic<uint64_t>		progress		= 0;	//Goes up whenever a task is queued or finishes
+		std::mutex					sleepLock;
+		std::condition_variable		taskAdded;		//Wakes workers
+		std::condition_variable		waitProgress;	//Wakes threads in Wait, when a task finishes or is added
+		bool						stopping = false;
+	};
+}
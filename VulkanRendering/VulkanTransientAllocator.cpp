@@ -0,0 +1,188 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#include "VulkanTransientAllocator.h"
+#include "VulkanUtils.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+TransientAllocator::TransientAllocator(vk::Device device, VmaAllocator allocator, uint32_t framesInFlight) {
+	this->device			= device;
+	this->allocator			= allocator;
+	this->framesInFlight	= framesInFlight;
+
+	generation		= 0;
+	peakMemory		= 0;
+	unaliasedMemory = 0;
+}
+
+TransientAllocator::~TransientAllocator() {
+	for (auto& a : retired) {
+		Free(a);
+	}
+	Free(current);
+}
+
+const std::vector<TransientAllocator::Placement>& TransientAllocator::Place(const std::vector<Request>& requests) {
+	for (auto& a : retired) {
+		a.framesLeft--;
+	}
+	while (!retired.empty() && retired.front().framesLeft == 0) {
+		Free(retired.front());
+		retired.pop_front();
+	}
+	if (requests != currentRequests && !Rebuild(requests)) {
+		//Tried again next time, as the memory might have been freed up by then
+		currentRequests.clear();
+		placements.clear();
+		peakMemory = 0;
+	}
+	return placements;
+}
+
+bool TransientAllocator::Rebuild(const std::vector<Request>& requests) {
+	//Earlier frames might still be rendering into the old images
+	current.framesLeft = framesInFlight;
+	retired.push_back(std::move(current));
+	current = Allocations();
+
+	currentRequests = requests;
+	placements.clear();
+	placements.resize(requests.size());
+	peakMemory		= 0;
+	unaliasedMemory = 0;
+	generation++;
+
+	std::vector<vk::MemoryRequirements> memReqs(requests.size());
+	std::map<uint32_t, std::vector<size_t>> memoryTypes;
+
+	for (size_t i = 0; i < requests.size(); ++i) {
+		const TransientImageInfo& info = requests[i].info;
+		auto createInfo = vk::ImageCreateInfo()
+			.setImageType(vk::ImageType::e2D)
+			.setExtent(vk::Extent3D(info.width, info.height, 1))
+			.setFormat(info.format)
+			.setUsage(info.usages)
+			.setMipLevels(1)
+			.setArrayLayers(1);
+
+		placements[i].image = device.createImage(createInfo);
+		current.images.push_back(placements[i].image);
+		SetDebugName(device, vk::ObjectType::eImage, GetVulkanHandle(placements[i].image), requests[i].name);
+
+		memReqs[i]			= device.getImageMemoryRequirements(placements[i].image);
+		placements[i].size	= memReqs[i].size;
+		unaliasedMemory		+= memReqs[i].size;
+		memoryTypes[memReqs[i].memoryTypeBits].push_back(i);
+	}
+
+	auto livesOverlap = [&](size_t a, size_t b) {
+		return requests[a].firstUse <= requests[b].lastUse && requests[b].firstUse <= requests[a].lastUse;
+	};
+
+	//Everything that can share a memory type goes in one block. Biggest images are placed first,
+	//each at the lowest offset that doesn't overlap anything alive at the same time as it
+	for (auto& [typeBits, images] : memoryTypes) {
+		std::stable_sort(images.begin(), images.end(), [&](size_t a, size_t b) {
+			return memReqs[a].size > memReqs[b].size;
+		});
+		uint32_t		block		= (uint32_t)current.blocks.size();
+		vk::DeviceSize	blockSize	= 0;
+		vk::DeviceSize	alignment	= 1;
+		std::vector<size_t> placed;
+
+		for (size_t i : images) {
+			std::vector<vk::DeviceSize> candidates = { 0 };
+			for (size_t p : placed) {
+				if (livesOverlap(i, p)) {
+					candidates.push_back(placements[p].offset + placements[p].size);
+				}
+			}
+			std::sort(candidates.begin(), candidates.end());
+
+			for (vk::DeviceSize c : candidates) {
+				vk::DeviceSize offset = (c + memReqs[i].alignment - 1) / memReqs[i].alignment * memReqs[i].alignment;
+				bool fits = true;
+				for (size_t p : placed) {
+					if (livesOverlap(i, p) && offset < placements[p].offset + placements[p].size && placements[p].offset < offset + memReqs[i].size) {
+						fits = false;
+						break;
+					}
+				}
+				if (fits) {
+					placements[i].offset = offset;
+					break;
+				}
+			}
+			placements[i].block = block;
+			placed.push_back(i);
+			blockSize = std::max(blockSize, placements[i].offset + memReqs[i].size);
+			alignment = std::max(alignment, memReqs[i].alignment);
+		}
+
+		VkMemoryRequirements blockReqs = {
+			.size			= blockSize,
+			.alignment		= alignment,
+			.memoryTypeBits = typeBits
+		};
+		VmaAllocationCreateInfo allocInfo = {};
+		allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+		VmaAllocation allocation = VK_NULL_HANDLE;
+		if (vmaAllocateMemory(allocator, &blockReqs, &allocInfo, &allocation, nullptr) != VK_SUCCESS) {
+			std::cout << __FUNCTION__ << " Failed to allocate " << blockSize << " bytes of transient memory!\n";
+			Free(current);
+			return false;
+		}
+		current.blocks.push_back(allocation);
+		TrackAllocation(allocator, allocation, MemoryCategory::RenderTargets);
+		peakMemory += blockSize;
+
+		for (size_t i : images) {
+			if (vmaBindImageMemory2(allocator, allocation, placements[i].offset, placements[i].image, nullptr) != VK_SUCCESS) {
+				std::cout << __FUNCTION__ << " Failed to bind transient image " << requests[i].name << "!\n";
+				Free(current);
+				return false;
+			}
+		}
+	}
+
+	//Views can only be made once the memory is bound
+	for (size_t i = 0; i < requests.size(); ++i) {
+		auto viewInfo = vk::ImageViewCreateInfo()
+			.setViewType(vk::ImageViewType::e2D)
+			.setFormat(requests[i].info.format)
+			.setSubresourceRange(vk::ImageSubresourceRange(requests[i].info.aspects, 0, 1, 0, 1))
+			.setImage(placements[i].image);
+
+		current.views.push_back(device.createImageViewUnique(viewInfo));
+		placements[i].view = *current.views.back();
+		SetDebugName(device, vk::ObjectType::eImageView, GetVulkanHandle(placements[i].view), requests[i].name);
+	}
+
+	std::cout << __FUNCTION__ << " " << requests.size() << " transient images in "
+		<< peakMemory / (1024 * 1024) << "MB, "
+		<< unaliasedMemory / (1024 * 1024) << "MB without aliasing\n";
+	return true;
+}
+
+void TransientAllocator::Free(Allocations& a) {
+	a.views.clear();
+	for (vk::Image i : a.images) {
+		device.destroyImage(i);
+	}
+	for (VmaAllocation b : a.blocks) {
+		UntrackAllocation(b);
+		vmaFreeMemory(allocator, b);
+	}
+	a.images.clear();
+	a.blocks.clear();
+}
@@ -0,0 +1,103 @@
+/******************************************************************************
+This file is part of the Newcastle Vulkan Tutorial Series
+
+Author:Rich Davison
+Contact:richgdavison@gmail.com
+License: MIT (see LICENSE file at the top of the source tree)
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <deque>
+
+namespace NCL::Rendering::Vulkan {
+	struct TransientImageInfo {
+		uint32_t				width	= 0;
+		uint32_t				height	= 0;
+		vk::Format				format	= vk::Format::eUndefined;
+		vk::ImageUsageFlags		usages;
+		vk::ImageAspectFlags	aspects = vk::ImageAspectFlagBits::eColor;
+
+		bool operator==(const TransientImageInfo& other) const = default;
+	};
+
+	/*
+	Render targets that only live for part of a frame don't each need their
+	own memory. Given when each image is first and last used (in render graph
+	batches), this packs them into as few, and as small, memory blocks as it
+	can, with images that are never alive at the same time sharing memory.
+
+	Placing is only redone when the requests change (ie the screen is resized),
+	otherwise the same images are handed back every frame. Anything replaced
+	is kept alive until the frames that might still be using it are done.
+
+	The contents of an aliased image are undefined at the start of its
+	lifetime, so its first use has to overwrite it - RenderGraph takes care of
+	the barriers against whatever used the memory before.
+	*/
+	class TransientAllocator	{
+	public:
+		struct Request {
+			std::string			name;
+			TransientImageInfo	info;
+			uint32_t			firstUse;
+			uint32_t			lastUse;
+
+			bool operator==(const Request& other) const = default;
+		};
+
+		struct Placement {
+			vk::Image		image;
+			vk::ImageView	view;
+			uint32_t		block;
+			vk::DeviceSize	offset;
+			vk::DeviceSize	size;
+		};
+
+		TransientAllocator(vk::Device device, VmaAllocator allocator, uint32_t framesInFlight = 3);
+		~TransientAllocator();
+
+		//One placement per request, in the same order. Should be called once per frame.
+		//Empty if there wasn't the memory for them
+		const std::vector<Placement>& Place(const std::vector<Request>& requests);
+
+		static bool SharesMemory(const Placement& a, const Placement& b) {
+			return a.block == b.block && a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+		}
+
+		//Changes every time the images are recreated, so anything holding views knows to update
+		uint32_t GetGeneration() const {
+			return generation;
+		}
+		//Memory actually allocated for the current images
+		vk::DeviceSize GetPeakMemory() const {
+			return peakMemory;
+		}
+		//What they would have needed with an allocation each
+		vk::DeviceSize GetUnaliasedMemory() const {
+			return unaliasedMemory;
+		}
+
+	protected:
+		struct Allocations {
+			std::vector<vk::Image>				images;
+			std::vector<vk::UniqueImageView>	views;
+			std::vector<VmaAllocation>			blocks;
+			uint32_t							framesLeft = 0;
+		};
+
+		bool Rebuild(const std::vector<Request>& requests);
+		void Free(Allocations& a);
+
+		vk::Device		device;
+		VmaAllocator	allocator;
+		uint32_t		framesInFlight;
+
+		std::vector<Request>	currentRequests;
+		std::vector<Placement>	placements;
+		Allocations				current;
+		std::deque<Allocations>	retired;
+
+		uint32_t		generation;
+		vk::DeviceSize	peakMemory;
+		vk::DeviceSize	unaliasedMemory;
+	};
+}
@@ -9,11 +9,15 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "VulkanTexture.h"
 #include "VulkanBuffers.h"
 
+#include <algorithm>
+
 using namespace NCL;
 using namespace Rendering;
 using namespace Vulkan;
 
 std::map<vk::Device, vk::DescriptorSetLayout > nullDescriptors;
+std::map<vk::Device, vk::PipelineCache > defaultPipelineCaches;
+std::map<vk::DescriptorSetLayout, std::vector<vk::DescriptorPoolSize>> descriptorSetLayoutSizes;
 
 vk::DynamicLoader NCL::Rendering::Vulkan::dynamicLoader;
 
@@ -47,6 +51,34 @@ vk::DescriptorSetLayout Vulkan::GetNullDescriptor(vk::Device device) {
 	return nullDescriptors[device];
 }
 
+void Vulkan::SetDefaultPipelineCache(vk::Device device, vk::PipelineCache cache) {
+	defaultPipelineCaches[device] = cache;
+}
+
+vk::PipelineCache Vulkan::GetDefaultPipelineCache(vk::Device device) {
+	auto i = defaultPipelineCaches.find(device);
+	return i == defaultPipelineCaches.end() ? vk::PipelineCache() : i->second;
+}
+
+void Vulkan::SetDescriptorSetLayoutSizes(vk::DescriptorSetLayout layout, const std::vector<vk::DescriptorSetLayoutBinding>& bindings) {
+	std::vector<vk::DescriptorPoolSize>& sizes = descriptorSetLayoutSizes[layout];
+	sizes.clear();
+	for (const auto& b : bindings) {
+		auto i = std::find_if(sizes.begin(), sizes.end(), [&](const vk::DescriptorPoolSize& s) { return s.type == b.descriptorType; });
+		if (i == sizes.end()) {
+			sizes.push_back({ b.descriptorType, b.descriptorCount });
+		}
+		else {
+			i->descriptorCount += b.descriptorCount;
+		}
+	}
+}
+
+const std::vector<vk::DescriptorPoolSize>* Vulkan::GetDescriptorSetLayoutSizes(vk::DescriptorSetLayout layout) {
+	auto i = descriptorSetLayoutSizes.find(layout);
+	return i == descriptorSetLayoutSizes.end() ? nullptr : &i->second;
+}
+
 vk::AccessFlags Vulkan::DefaultAccessFlags(vk::ImageLayout forLayout) {
 	if (forLayout == vk::ImageLayout::eTransferDstOptimal) {
 		return vk::AccessFlagBits::eTransferWrite;
@@ -85,6 +117,13 @@ vk::AccessFlags2 Vulkan::DefaultAccessFlags2(vk::ImageLayout forLayout) {
 	return vk::AccessFlagBits2::eNone;
 }
 
+bool Vulkan::FormatHasStencil(vk::Format format) {
+	return	format == vk::Format::eS8Uint ||
+			format == vk::Format::eD16UnormS8Uint ||
+			format == vk::Format::eD24UnormS8Uint ||
+			format == vk::Format::eD32SfloatS8Uint;
+}
+
 void Vulkan::ImageTransitionBarrier(vk::CommandBuffer  buffer, vk::Image i, vk::ImageMemoryBarrier2 barrier) {
 	barrier.image = i;
 
@@ -203,7 +242,7 @@ vk::UniqueCommandBuffer	Vulkan::CmdBufferBegin(vk::Device device, vk::CommandPoo
 	return std::move(buffer);
 }
 
-void	Vulkan::CmdBufferEndSubmit(vk::CommandBuffer  buffer, vk::Queue queue, vk::Fence fence, vk::Semaphore waitSemaphore, vk::Semaphore signalSempahore) {
+void	Vulkan::CmdBufferEndSubmit(vk::CommandBuffer  buffer, vk::Queue queue, vk::Fence fence, vk::Semaphore waitSemaphore, vk::Semaphore signalSempahore, vk::PipelineStageFlags waitStage) {
 	if (!buffer) {
 		std::cout << __FUNCTION__ << " Submitting invalid buffer?\n";
 		return;
@@ -214,8 +253,6 @@ void	Vulkan::CmdBufferEndSubmit(vk::CommandBuffer  buffer, vk::Queue queue, vk::
 	submitInfo.setCommandBufferCount(1);
 	submitInfo.setPCommandBuffers(&buffer);
 
-	vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eTopOfPipe;
-
 	if (waitSemaphore) {
 		submitInfo.waitSemaphoreCount = 1;
 		submitInfo.pWaitSemaphores = &waitSemaphore;
@@ -312,6 +349,25 @@ void	Vulkan::WriteStorageImageDescriptor(vk::Device device, vk::DescriptorSet se
 	device.updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
 }
 
+void	Vulkan::WriteStorageImageDescriptor(vk::Device device, vk::DescriptorSet set, uint32_t bindingNum, uint32_t subIndex, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout) {
+	vk::DescriptorImageInfo imageInfo = {
+		.sampler		= sampler,
+		.imageView		= view,
+		.imageLayout	= layout
+	};
+
+	vk::WriteDescriptorSet descriptorWrite = {
+		.dstSet			= set,
+		.dstBinding		= bindingNum,
+		.dstArrayElement = subIndex,
+		.descriptorCount = 1,
+		.descriptorType = vk::DescriptorType::eStorageImage,
+		.pImageInfo = &imageInfo
+	};
+
+	device.updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+}
+
 void	Vulkan::WriteBufferDescriptor(vk::Device device, vk::DescriptorSet set, uint32_t bindingSlot, vk::DescriptorType bufferType, vk::Buffer buff, size_t offset, size_t range) {
 	vk::DescriptorBufferInfo descriptorInfo = {
 		.buffer = buff,
@@ -408,7 +464,7 @@ void Vulkan::CopyImageToImage(vk::CommandBuffer cmd, VkImage source, VkImage des
 	blitRegion.dstSubresource.layerCount = 1;
 	blitRegion.dstSubresource.mipLevel = 0;
 
-	vk::BlitImageInfo2 blitInfo{ .sType = vk::StructureType::eImageBlit2, .pNext = nullptr };
+	vk::BlitImageInfo2 blitInfo{ .sType = vk::StructureType::eBlitImageInfo2, .pNext = nullptr };
 	blitInfo.dstImage = destination;
 	blitInfo.dstImageLayout = vk::ImageLayout::eTransferDstOptimal;
 	blitInfo.srcImage = source;
@@ -418,4 +474,181 @@ void Vulkan::CopyImageToImage(vk::CommandBuffer cmd, VkImage source, VkImage des
 	blitInfo.pRegions = &blitRegion;
 
 	cmd.blitImage2(&blitInfo);
-}
\ No newline at end of file
+}
+
+ImmediateContext::ImmediateContext(vk::Device inDevice, vk::Queue inQueue, uint32_t queueFamily, uint32_t bufferCount) {
+	device	= inDevice;
+	queue	= inQueue;
+	pool	= device.createCommandPoolUnique(
+		{
+			.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient,
+			.queueFamilyIndex = queueFamily
+		}
+	);
+
+	auto buffers = device.allocateCommandBuffers(
+		{
+			.commandPool = *pool,
+			.level = vk::CommandBufferLevel::ePrimary,
+			.commandBufferCount = std::max(bufferCount, 1u)
+		}
+	);
+	slots.resize(buffers.size());
+	for (size_t i = 0; i < buffers.size(); ++i) {
+		slots[i].cmdBuffer	= buffers[i];
+		slots[i].fence		= device.createFence({});
+		SetDebugName(device, vk::ObjectType::eCommandBuffer, GetVulkanHandle(buffers[i]), "Immediate cmds " + std::to_string(i));
+	}
+}
+
+ImmediateContext::~ImmediateContext() {
+	WaitAll();
+	for (auto& i : slots) {
+		device.destroyFence(i.fence);
+	}
+	//The command buffers go with the pool
+}
+
+vk::CommandBuffer ImmediateContext::Begin(const std::string& debugName) {
+	if (recording) {
+		return recording->cmdBuffer;
+	}
+	//Take a free slot if there is one, otherwise the oldest submission is the one most likely to be done
+	Slot* chosen = nullptr;
+	for (auto& i : slots) {
+		if (i.id == 0) {
+			chosen = &i;
+			break;
+		}
+		if (!chosen || i.id < chosen->id) {
+			chosen = &i;
+		}
+	}
+	Release(*chosen, true);
+
+	chosen->id = nextID++;
+	chosen->cmdBuffer.reset({});
+	chosen->cmdBuffer.begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+	if (!debugName.empty()) {
+		SetDebugName(device, vk::ObjectType::eCommandBuffer, GetVulkanHandle(chosen->cmdBuffer), debugName);
+	}
+	recording = chosen;
+	return recording->cmdBuffer;
+}
+
+ImmediateContext::Token ImmediateContext::Submit() {
+	if (!recording) {
+		return {};
+	}
+	if (batchDepth > 0) {
+		return { recording->id };
+	}
+	return Flush();
+}
+
+void ImmediateContext::SubmitWait() {
+	Wait(Flush());
+}
+
+void ImmediateContext::BeginBatch() {
+	batchDepth++;
+}
+
+ImmediateContext::Token ImmediateContext::EndBatch(bool wait) {
+	assert(MessageAssert(batchDepth > 0, "EndBatch called without a matching BeginBatch!"));
+	batchDepth--;
+	if (batchDepth > 0) {
+		return recording ? Token{ recording->id } : Token{};
+	}
+	Token t = Flush();
+	if (wait) {
+		Wait(t);
+	}
+	return t;
+}
+
+ImmediateContext::Token ImmediateContext::Flush() {
+	if (!recording) {
+		return {};
+	}
+	//Later submissions on this queue might read anything written here, without knowing it came from us
+	vk::MemoryBarrier2 barrier = {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eAllCommands,
+		.srcAccessMask	= vk::AccessFlagBits2::eMemoryWrite,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eAllCommands,
+		.dstAccessMask	= vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite
+	};
+	vk::DependencyInfo barrierInfo;
+	barrierInfo.memoryBarrierCount	= 1;
+	barrierInfo.pMemoryBarriers		= &barrier;
+	recording->cmdBuffer.pipelineBarrier2(barrierInfo);
+
+	CmdBufferEndSubmit(recording->cmdBuffer, queue, recording->fence);
+	recording->submitted = true;
+
+	Token t = { recording->id };
+	recording = nullptr;
+
+	//Free up anything from earlier submissions that has finished in the meantime
+	for (auto& i : slots) {
+		if (i.submitted && device.getFenceStatus(i.fence) == vk::Result::eSuccess) {
+			Release(i, false);
+		}
+	}
+	return t;
+}
+
+void ImmediateContext::Release(Slot& s, bool wait) {
+	if (s.submitted) {
+		if (wait && device.waitForFences(s.fence, true, UINT64_MAX) != vk::Result::eSuccess) {
+			std::cout << __FUNCTION__ << " Immediate submission taking too long?\n";
+		}
+		device.resetFences(s.fence);
+	}
+	for (auto& f : s.onComplete) {
+		f();
+	}
+	s.onComplete.clear();
+	s.id		= 0;
+	s.submitted = false;
+}
+
+ImmediateContext::Slot* ImmediateContext::FindSlot(Token t) {
+	for (auto& i : slots) {
+		if (i.id != 0 && i.id == t.id) {
+			return &i;
+		}
+	}
+	return nullptr;
+}
+
+bool ImmediateContext::IsComplete(Token t) {
+	Slot* s = FindSlot(t);
+	if (!s) {
+		return true; //Already released
+	}
+	return s->submitted && device.getFenceStatus(s->fence) == vk::Result::eSuccess;
+}
+
+void ImmediateContext::Wait(Token t) {
+	Slot* s = FindSlot(t);
+	if (!s) {
+		return;
+	}
+	if (s == recording) {
+		Flush();
+	}
+	Release(*s, true);
+}
+
+void ImmediateContext::WaitAll() {
+	Flush();
+	for (auto& i : slots) {
+		Release(i, true);
+	}
+}
+
+void ImmediateContext::OnComplete(std::function<void()>&& func) {
+	assert(MessageAssert(recording != nullptr, "OnComplete must be called between Begin and Submit!"));
+	recording->onComplete.push_back(std::move(func));
+}
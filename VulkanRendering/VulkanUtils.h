@@ -6,6 +6,7 @@ Contact:richgdavison@gmail.com
 License: MIT (see LICENSE file at the top of the source tree)
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
+#include <functional>
 
 namespace NCL::Rendering::Vulkan {
 	class VulkanTexture;
@@ -15,8 +16,16 @@ namespace NCL::Rendering::Vulkan {
 	void SetNullDescriptor(vk::Device device, vk::DescriptorSetLayout layout);
 	vk::DescriptorSetLayout GetNullDescriptor(vk::Device device);
 
+	//Pipeline builders fall back to this cache if Build isn't given one
+	void SetDefaultPipelineCache(vk::Device device, vk::PipelineCache cache);
+	vk::PipelineCache GetDefaultPipelineCache(vk::Device device);
+
 	void SetDescriptorSizes(vk::Device, vk::PhysicalDeviceDescriptorBufferPropertiesEXT& props);
 
+	//How many of each descriptor type a layout holds, so descriptor pools can be sized to what's actually used
+	void SetDescriptorSetLayoutSizes(vk::DescriptorSetLayout layout, const std::vector<vk::DescriptorSetLayoutBinding>& bindings);
+	const std::vector<vk::DescriptorPoolSize>* GetDescriptorSetLayoutSizes(vk::DescriptorSetLayout layout);
+
 	template <typename T>
 	uint64_t GetVulkanHandle(T const& cppHandle) {
 		return uint64_t(static_cast<T::CType>(cppHandle));
@@ -55,6 +64,8 @@ namespace NCL::Rendering::Vulkan {
 	vk::AccessFlags	 DefaultAccessFlags(vk::ImageLayout forLayout);
 	vk::AccessFlags2 DefaultAccessFlags2(vk::ImageLayout forLayout);
 
+	bool FormatHasStencil(vk::Format format);
+
 	vk::UniqueDescriptorSet CreateDescriptorSet(vk::Device device, vk::DescriptorPool pool, vk::DescriptorSetLayout  layout, uint32_t variableDescriptorCount = 0);
 
 	void	WriteDescriptor(vk::Device device, vk::WriteDescriptorSet setInfo, vk::DescriptorBufferInfo bufferInfo);
@@ -64,6 +75,7 @@ namespace NCL::Rendering::Vulkan {
 	void	WriteImageDescriptor(vk::Device device, vk::DescriptorSet set, uint32_t bindingSlot, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
 	void	WriteImageDescriptor(vk::Device device, vk::DescriptorSet set, uint32_t bindingSlot, uint32_t subIndex, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
 	void	WriteStorageImageDescriptor(vk::Device device, vk::DescriptorSet set, uint32_t bindingSlot, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+	void	WriteStorageImageDescriptor(vk::Device device, vk::DescriptorSet set, uint32_t bindingSlot, uint32_t subIndex, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
 	void	WriteTLASDescriptor(vk::Device device, vk::DescriptorSet set, uint32_t bindingSlot, vk::AccelerationStructureKHR tlas);
 
 	vk::UniqueCommandBuffer	CmdBufferCreate(vk::Device device, vk::CommandPool fromPool, const std::string& debugName = "");
@@ -72,7 +84,7 @@ namespace NCL::Rendering::Vulkan {
 	void	CmdBufferResetBegin(vk::CommandBuffer  buffer);
 	void	CmdBufferResetBegin(const vk::UniqueCommandBuffer&  buffer);
 
-	void	CmdBufferEndSubmit(vk::CommandBuffer  buffer, vk::Queue queue, vk::Fence fence = {}, vk::Semaphore waitSemaphore = {}, vk::Semaphore signalSempahore = {});
+	void	CmdBufferEndSubmit(vk::CommandBuffer  buffer, vk::Queue queue, vk::Fence fence = {}, vk::Semaphore waitSemaphore = {}, vk::Semaphore signalSempahore = {}, vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eTopOfPipe);
 	void	CmdBufferEndSubmitWait(vk::CommandBuffer  buffer, vk::Device device, vk::Queue queue);
 
 	void WriteBufferDescriptor(vk::Device device,
@@ -85,4 +97,58 @@ namespace NCL::Rendering::Vulkan {
 	);
 
 	void CopyImageToImage(vk::CommandBuffer cmd, VkImage source, VkImage destination, VkExtent2D srcSize, VkExtent2D dstSize);
+
+	/*
+	Records one-off work such as uploads, reusing a handful of command buffers and fences 
+	rather than creating new ones each time. Each Begin / Submit pair is normally its own
+	submission, but between BeginBatch and EndBatch everything shares one, so loading a
+	whole scene only takes a few submits. Not thread safe, it's meant for the loading thread.
+	*/
+	class ImmediateContext {
+	public:
+		//Identifies a submission. Stays valid once its command buffer has been reused, and just reports as complete
+		struct Token {
+			uint64_t id = 0;
+		};
+
+		ImmediateContext(vk::Device device, vk::Queue queue, uint32_t queueFamily, uint32_t bufferCount = 4);
+		~ImmediateContext();
+
+		//Returns the command buffer being recorded, starting a new one if need be
+		vk::CommandBuffer	Begin(const std::string& debugName = "");
+		//Submits what has been recorded, unless inside a batch
+		Token				Submit();
+		//Always submits, even inside a batch, and waits for the GPU to finish
+		void				SubmitWait();
+
+		void	BeginBatch();
+		Token	EndBatch(bool wait = false);
+
+		bool	IsComplete(Token t);
+		void	Wait(Token t);
+		void	WaitAll();
+
+		//Called once the GPU is done with the current recording, e.g. to free its staging buffers
+		void	OnComplete(std::function<void()>&& func);
+
+	protected:
+		struct Slot {
+			vk::CommandBuffer	cmdBuffer;
+			vk::Fence			fence;
+			uint64_t			id			= 0;	//0 while free
+			bool				submitted	= false;
+			std::vector<std::function<void()>> onComplete;
+		};
+		Token	Flush();
+		void	Release(Slot& s, bool wait);
+		Slot*	FindSlot(Token t);
+
+		vk::Device				device;
+		vk::Queue				queue;
+		vk::UniqueCommandPool	pool;
+		std::vector<Slot>		slots;
+		Slot*					recording	= nullptr;
+		uint32_t				batchDepth	= 0;
+		uint64_t				nextID		= 1;
+	};
 }
\ No newline at end of file
@@ -22,7 +22,7 @@ AsyncComputeExample::AsyncComputeExample(Window& window) : VulkanTutorial(window
 	frameID = 0;
 
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	particlePositions = BufferBuilder(device, renderer->GetMemoryAllocator())
 		.WithBufferUsage(vk::BufferUsageFlagBits::eStorageBuffer)
@@ -37,7 +37,7 @@ AsyncComputeExample::AsyncComputeExample(Window& window) : VulkanTutorial(window
 		.WithStorageBuffers(1, 1, vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute)
 		.Build("Compute Data"); //Get our camera matrices...
 
-	bufferDescriptor = CreateDescriptorSet(device, pool, *dataLayout);
+	bufferDescriptor = descriptorAllocator.Allocate(*dataLayout);
 	WriteBufferDescriptor(device,*bufferDescriptor, 0, vk::DescriptorType::eStorageBuffer, particlePositions);
 	WriteBufferDescriptor(device,*bufferDescriptor, 1, vk::DescriptorType::eStorageBuffer, frameIDBuffer);
 
@@ -45,7 +45,10 @@ AsyncComputeExample::AsyncComputeExample(Window& window) : VulkanTutorial(window
 	BuildRasterPipeline();
 
 	vk::CommandPool asyncPool = renderer->GetCommandPool(CommandBuffer::AsyncCompute);
-	asyncBuffer = CmdBufferBegin(device, asyncPool, "Async cmds");
+	for (uint32_t i = 0; i < renderer->GetFramesInFlight(); ++i) {
+		asyncBuffers.push_back(CmdBufferCreate(device, asyncPool, "Async cmds"));
+	}
+	asyncPoints.resize(renderer->GetFramesInFlight());
 }
 
 void	AsyncComputeExample::BuildRasterPipeline() {
@@ -74,28 +77,30 @@ void AsyncComputeExample::RenderFrame(float dt) {
 	//Compute goes outside of a render pass...
 
 	FrameState const& state = renderer->GetFrameState();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
-	vk::Queue		asyncQueue = renderer->GetQueue(CommandBuffer::AsyncCompute);
+	QueueScheduler& scheduler = renderer->GetQueueScheduler();
+	uint32_t		frameIndex = renderer->GetCurrentFrameIndex();
 
 	vk::CommandBuffer cmdBuffer = state.cmdBuffer;
+	vk::CommandBuffer asyncBuffer = *asyncBuffers[frameIndex];
 
-	asyncQueue.waitIdle();
+	//Only the compute from this frame in flight's last turn has to be finished, and it almost always is
+	scheduler.WaitFor(asyncPoints[frameIndex]);
 
-	asyncBuffer->reset();
-	asyncBuffer->begin(vk::CommandBufferBeginInfo());
-	asyncBuffer->bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline);
-	asyncBuffer->bindDescriptorSets(vk::PipelineBindPoint::eCompute, *computePipeline.layout, 0, 1, &*bufferDescriptor, 0, nullptr);
-	asyncBuffer->pushConstants(*computePipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(float), (void*)&runTime);
-	asyncBuffer->pushConstants(*computePipeline.layout, vk::ShaderStageFlagBits::eCompute, sizeof(float), sizeof(uint32_t), (void*)&frameID);
+	CmdBufferResetBegin(asyncBuffer);
+	asyncBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline);
+	asyncBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *computePipeline.layout, 0, 1, &*bufferDescriptor, 0, nullptr);
+	asyncBuffer.pushConstants(*computePipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(float), (void*)&runTime);
+	asyncBuffer.pushConstants(*computePipeline.layout, vk::ShaderStageFlagBits::eCompute, sizeof(float), sizeof(uint32_t), (void*)&frameID);
 
-	asyncBuffer->dispatch(PARTICLE_COUNT / 32, 1, 1);
-	CmdBufferEndSubmit(*asyncBuffer, asyncQueue);
+	asyncBuffer.dispatch(PARTICLE_COUNT / 32, 1, 1);
+	asyncBuffer.end();
 
-	cmdBuffer.pipelineBarrier(
-		vk::PipelineStageFlagBits::eComputeShader,
-		vk::PipelineStageFlagBits::eVertexShader,
-		vk::DependencyFlags(), 0, nullptr, 0, nullptr, 0, nullptr
-	);
+	//The buffers are overwritten, so the compute can't start until the last frame has finished drawing them,
+	//and this frame can't start drawing until the compute has finished. Neither needs the CPU to wait
+	asyncPoints[frameIndex] = scheduler.Submit(CommandBuffer::AsyncCompute, asyncBuffer,
+		{ { scheduler.GetLastSubmitted(CommandBuffer::Graphics), vk::PipelineStageFlagBits2::eComputeShader } });
+
+	scheduler.WaitOnNextSubmit(CommandBuffer::Graphics, { asyncPoints[frameIndex], vk::PipelineStageFlagBits2::eVertexShader });
 
 	cmdBuffer.beginRendering(
 		DynamicRenderBuilder()
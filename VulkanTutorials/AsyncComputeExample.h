@@ -33,7 +33,9 @@ namespace NCL::Rendering::Vulkan {
 
 		vk::UniqueDescriptorSetLayout dataLayout;
 
-		vk::UniqueCommandBuffer asyncBuffer;
+		//One for each frame in flight, along with the point its last submission reaches
+		std::vector<vk::UniqueCommandBuffer>	asyncBuffers;
+		std::vector<QueueScheduler::Point>		asyncPoints;
 
 		uint32_t frameID;
     };
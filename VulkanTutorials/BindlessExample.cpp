@@ -32,7 +32,7 @@ BindlessExample::BindlessExample(Window& window) : VulkanTutorial(window){
 
 	FrameState const& frameState = renderer->GetFrameState();
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	camera.SetYaw(270.0f).SetPitch(-50.0f).SetPosition({-10, 24, 15});
 	textures[0] = LoadTexture("Vulkan.png");
@@ -62,7 +62,7 @@ BindlessExample::BindlessExample(Window& window) : VulkanTutorial(window){
 		.WithDescriptorSetLayout(2, *bindlessLayout)	//All textures Set 2
 		.Build("Bindless Pipeline");
 
-	descriptorSet	= CreateDescriptorSet(device, pool, shader->GetLayout(1));
+	descriptorSet	= descriptorAllocator.Allocate(shader->GetLayout(1));
 	bindlessSet		= CreateDescriptorSet(device, *bindlessDescriptorPool, *bindlessLayout, _NumSamplers);
 
 	matrices = BufferBuilder(device, renderer->GetMemoryAllocator())
@@ -101,7 +101,7 @@ void BindlessExample::RenderFrame(float dt) {
 	state.cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
 
 	vk::DescriptorSet sets[3] = {
-		*cameraDescriptor,
+		cameraDescriptor,
 		*descriptorSet,
 		*bindlessSet
 	};
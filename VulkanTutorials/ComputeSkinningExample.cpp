@@ -21,7 +21,7 @@ ComputeSkinningExample::ComputeSkinningExample(Window& window) : VulkanTutorial(
 
 	FrameState const& frameState = renderer->GetFrameState();
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	GLTFLoader::Load("CesiumMan/CesiumMan.gltf",scene);
 
@@ -37,14 +37,17 @@ ComputeSkinningExample::ComputeSkinningExample(Window& window) : VulkanTutorial(
 		.WithImageSamplers(0, 1, vk::ShaderStageFlagBits::eFragment)
 		.Build("Object Textures");
 
+	//Layers that use the same texture get the same set, and every new set is written in one call
+	DescriptorSetWriter materialWriter(device);
 	for (const auto& m : scene.materials) {	//Build descriptors for each mesh and its sublayers
 		layerDescriptors.push_back({});
-		std::vector<vk::UniqueDescriptorSet>& matSet = layerDescriptors.back();
+		std::vector<vk::DescriptorSet>& matSet = layerDescriptors.back();
 		for (const auto& l : m.allLayers) {
-			matSet.push_back(CreateDescriptorSet(device, pool, *textureLayout));
-			WriteImageDescriptor(device , *matSet.back(), 0,((VulkanTexture*)l.albedo.get())->GetDefaultView(), *defaultSampler);
+			matSet.push_back(renderer->GetDescriptorSetCache().Get(*textureLayout,
+				{ DescriptorWrite::Image(0, ((VulkanTexture*)l.albedo.get())->GetDefaultView(), *defaultSampler) }, materialWriter));
 		}
 	}
+	materialWriter.Flush();
 
 	drawShader = ShaderBuilder(device)
 		.WithVertexBinary("SimpleVertexTransform.vert.spv")
@@ -76,7 +79,7 @@ ComputeSkinningExample::ComputeSkinningExample(Window& window) : VulkanTutorial(
 		.WithStorageBuffers(4, 1, vk::ShaderStageFlagBits::eCompute) //4: joint Matrices
 		.Build("Compute Data"); //Get our camera matrices...
 
-	computeDescriptor = CreateDescriptorSet(device , pool,  *computeLayout);
+	computeDescriptor = descriptorAllocator.Allocate(*computeLayout);
 
 	skinShader = UniqueVulkanCompute(new VulkanCompute(device, "ComputeSkinning.comp.spv"));
 
@@ -115,7 +118,6 @@ ComputeSkinningExample::ComputeSkinningExample(Window& window) : VulkanTutorial(
 		//??
 	}
 
-	WriteBufferDescriptor(device, *cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraBuffer);
 
 	WriteBufferDescriptor(device, *computeDescriptor, 0, vk::DescriptorType::eStorageBuffer, vertexBuffer, vertexOffset, vertexRange);
 	WriteBufferDescriptor(device, *computeDescriptor, 1, vk::DescriptorType::eStorageBuffer, weightBuffer, weightOffset, weightRange);
@@ -123,7 +125,6 @@ ComputeSkinningExample::ComputeSkinningExample(Window& window) : VulkanTutorial(
 	WriteBufferDescriptor(device, *computeDescriptor, 3, vk::DescriptorType::eStorageBuffer, outputVertices);
 	WriteBufferDescriptor(device, *computeDescriptor, 4, vk::DescriptorType::eStorageBuffer, jointsBuffer);
 
-	computeSemaphore = device.createSemaphoreUnique({});
 	vk::CommandPool asyncPool	= renderer->GetCommandPool(CommandBuffer::AsyncCompute);
 	vk::CommandPool gfxPool		= renderer->GetCommandPool(CommandBuffer::Graphics);
 	asyncCmds  = CmdBufferCreate(device, asyncPool, "Async cmds");
@@ -138,22 +139,24 @@ ComputeSkinningExample::~ComputeSkinningExample() {
 void ComputeSkinningExample::RenderFrame(float dt) {
 	VulkanMesh* mesh = (VulkanMesh*)scene.meshes[0].get();
 
-	vk::Queue		asyncQueue	= renderer->GetQueue(CommandBuffer::AsyncCompute);
-	vk::Queue		gfxQueue	= renderer->GetQueue(CommandBuffer::Graphics);
+	QueueScheduler& scheduler = renderer->GetQueueScheduler();
 
 	frameTime -= dt;
 
 	//Mesh*  mesh = scene.meshes[0].get();
 	MeshAnimation* anim = scene.animations[0].get();
 
+	//The joints and the async commands are about to be rewritten, so last frame's skinning has to have finished
+	scheduler.WaitFor(computeDone);
+
 	if (frameTime <= 0.0f) {
 		currentFrame = (currentFrame + 1) % anim->GetFrameCount();
 		frameTime += anim->GetFrameTime();
-		std::vector<Matrix4> invBindPos = mesh->GetInverseBindPose();
+		const std::vector<Matrix4>& invBindPos = mesh->GetInverseBindPose();
 
 		const Matrix4* frameMats = anim->GetJointData(currentFrame);
 
-		std::vector<Matrix4> jointData(invBindPos.size());
+		std::pmr::vector<Matrix4> jointData(invBindPos.size(), &renderer->GetFrameArena());
 
 		for (int i = 0; i < invBindPos.size(); ++i) {
 			jointData[i] = (frameMats[i] * invBindPos[i]);
@@ -166,17 +169,20 @@ void ComputeSkinningExample::RenderFrame(float dt) {
 	asyncCmds->bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline);
 	asyncCmds->bindDescriptorSets(vk::PipelineBindPoint::eCompute, *computePipeline.layout, 0, 1, &*computeDescriptor, 0, nullptr);
 	asyncCmds->dispatch(mesh->GetVertexCount(), 1, 1);
-	CmdBufferEndSubmit(*asyncCmds, asyncQueue, {}, {}, *computeSemaphore);
+	asyncCmds->end();
+	//Skinning overwrites the vertices last frame's draw read from, but the GPU can hold it back for that by itself
+	computeDone = scheduler.Submit(CommandBuffer::AsyncCompute, *asyncCmds, { { renderDone, vk::PipelineStageFlagBits2::eComputeShader } });
 
 	////Now to render the mesh!
+	scheduler.WaitFor(renderDone);
 	CmdBufferResetBegin(renderCmds);
 	renderCmds->bindPipeline(vk::PipelineBindPoint::eGraphics, drawPipeline);
-	renderCmds->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *drawPipeline.layout, 0, 1, &*cameraDescriptor, 0, nullptr);
+	renderCmds->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *drawPipeline.layout, 0, 1, &cameraDescriptor, 0, nullptr);
 
 	Matrix4 modelMatrix;
 	renderCmds->pushConstants(*drawPipeline.layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(Matrix4), (void*)&modelMatrix);
 
-	std::vector<vk::UniqueDescriptorSet>& set = layerDescriptors[0];
+	std::vector<vk::DescriptorSet>& set = layerDescriptors[0];
 
 	mesh->BindToCommandBuffer(*renderCmds);
 
@@ -186,7 +192,7 @@ void ComputeSkinningExample::RenderFrame(float dt) {
 	renderer->BeginDefaultRendering(*renderCmds);
 
 	for (unsigned int j = 0; j < mesh->GetSubMeshCount(); ++j) {
-		renderCmds->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *drawPipeline.layout, 1, 1, &*set[j], 0, nullptr);
+		renderCmds->bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *drawPipeline.layout, 1, 1, &set[j], 0, nullptr);
 
 		const SubMesh* sm = mesh->GetSubMesh(j);
 
@@ -198,5 +204,6 @@ void ComputeSkinningExample::RenderFrame(float dt) {
 		}
 	}
 	renderCmds->endRendering();
-	CmdBufferEndSubmit(*renderCmds, gfxQueue, {}, *computeSemaphore, {});
+	renderCmds->end();
+	renderDone = scheduler.Submit(CommandBuffer::Graphics, *renderCmds, { { computeDone, vk::PipelineStageFlagBits2::eVertexInput } });
 }
\ No newline at end of file
@@ -28,21 +28,22 @@ namespace NCL::Rendering::Vulkan {
         VulkanBuffer		            outputVertices;
 
         vk::UniqueDescriptorSetLayout	textureLayout;
-        std::vector<std::vector<vk::UniqueDescriptorSet>>	 layerDescriptors;
+        std::vector<std::vector<vk::DescriptorSet>>	 layerDescriptors;
 
         std::vector < vk::UniqueDescriptorSet > layerSets;
 
         vk::UniqueDescriptorSet		    computeDescriptor;
         vk::UniqueDescriptorSetLayout   computeLayout;
 
-        vk::UniqueSemaphore computeSemaphore;
-
         VulkanPipeline		drawPipeline;
         VulkanPipeline		computePipeline;
 
         vk::UniqueCommandBuffer asyncCmds;
         vk::UniqueCommandBuffer renderCmds;
 
+        QueueScheduler::Point   computeDone;
+        QueueScheduler::Point   renderDone;
+
         float   frameTime       = 0.0f;
         int     currentFrame    = 0;
     };
@@ -21,7 +21,7 @@ CubeMapExample::CubeMapExample(Window& window) : VulkanTutorial(window) {
 
 	FrameState const& state = renderer->GetFrameState();
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	cubeTex = LoadCubemap(
 		"Cubemap/skyrender0004.png", "Cubemap/skyrender0001.png",
@@ -63,12 +63,11 @@ CubeMapExample::CubeMapExample(Window& window) : VulkanTutorial(window) {
 		.WithDepthAttachment(state.depthFormat, vk::CompareOp::eLessOrEqual, true, true)
 	.Build("CubeMapRenderer Object Pipeline");
 
-	cubemapDescriptor = CreateDescriptorSet(device, pool, objectShader->GetLayout(1)); //Both use compatible layout
+	cubemapDescriptor = descriptorAllocator.Allocate(objectShader->GetLayout(1)); //Both use compatible layout
 	WriteImageDescriptor(device , *cubemapDescriptor, 0, cubeTex->GetDefaultView(), *defaultSampler);
 
-	cameraPosDescriptor = CreateDescriptorSet(device, pool, objectShader->GetLayout(2));
+	cameraPosDescriptor = descriptorAllocator.Allocate(objectShader->GetLayout(2));
 
-	WriteBufferDescriptor(device, *cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraBuffer);
 	WriteBufferDescriptor(device, *cameraPosDescriptor, 0, vk::DescriptorType::eUniformBuffer, camPosUniform);
 }
 
@@ -83,7 +82,7 @@ void CubeMapExample::RenderFrame(float dt)		 {
 	camPosUniform.CopyData(&newCamPos, sizeof(Vector3));
 
 	vk::DescriptorSet skyboxSets[] = {
-		*cameraDescriptor, //Set 0
+		cameraDescriptor, //Set 0
 		*cubemapDescriptor //Set 1
 	};
 
@@ -96,7 +95,7 @@ void CubeMapExample::RenderFrame(float dt)		 {
 	cmdBuffer.pushConstants(*objectPipeline.layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(Matrix4), (void*)&objectModelMatrix);
 
 	vk::DescriptorSet objectSets[] = {
-		*cameraDescriptor,		//Set 0
+		cameraDescriptor,		//Set 0
 		*cubemapDescriptor,		//Set 1
 		*cameraPosDescriptor	//Set 2
 	};
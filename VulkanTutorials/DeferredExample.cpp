@@ -19,16 +19,22 @@ struct LightStageUBOData {
 	Vector3 camPosition;
 	float	nothing;
 	Vector2 screenResolution;
+	Vector2 textureScale;
 };
 
 DeferredExample::DeferredExample(Window& window) : VulkanTutorial(window) {
 	VulkanInitialisation vkInit = DefaultInitialisation();	
 	vkInit.autoBeginDynamicRendering = false;
+	//All those lights add up, so let the resolution drop rather than the frame rate
+	vkInit.dynamicResolution = true;
 	renderer = new VulkanRenderer(window, vkInit);
 	InitTutorialObjects();
 
+	transientAllocator = std::make_unique<TransientAllocator>(renderer->GetDevice(), renderer->GetMemoryAllocator(), renderer->GetFramesInFlight());
+	renderGraph.UsingTransientAllocator(*transientAllocator);
+
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 	FrameState const& frameState = renderer->GetFrameState();
 
 	camera.SetPitch(-20.0f).SetPosition({ 0, 75.0f, 200 }).SetFarPlane(1000.0f);
@@ -43,10 +49,10 @@ DeferredExample::DeferredExample(Window& window) : VulkanTutorial(window) {
 	floorObject.mesh		= &*cubeMesh;
 	floorObject.transform = Matrix::Scale(Vector3{ 500.0f, 1.0f, 500.0f });
 
-	objectTextures[0] = LoadTexture("rust_diffuse.png");
-	objectTextures[1] = LoadTexture("rust_bump.png");
-	objectTextures[2] = LoadTexture("concrete_diffuse.png");
-	objectTextures[3] = LoadTexture("concrete_bump.png");
+	std::vector<UniqueVulkanTexture> textures = LoadTextures({ "rust_diffuse.png", "rust_bump.png", "concrete_diffuse.png", "concrete_bump.png" });
+	for (int i = 0; i < 4; ++i) {
+		objectTextures[i] = std::move(textures[i]);
+	}
 
 	LoadShaders();
 	CreateFrameBuffers(hostWindow.GetScreenSize().x, hostWindow.GetScreenSize().y);
@@ -71,15 +77,7 @@ DeferredExample::DeferredExample(Window& window) : VulkanTutorial(window) {
 		.Build(sizeof(allLights), "Lights");
 	lightUniform.CopyData(&allLights, sizeof(allLights));
 
-	lightStageUniform = BufferBuilder(device, renderer->GetMemoryAllocator())
-		.WithBufferUsage(vk::BufferUsageFlagBits::eUniformBuffer)
-		.WithHostVisibility()
-		.Build(sizeof(LightStageUBOData), "Light Stage");
-
-	WriteBufferDescriptor(device, *descriptors[Descriptors::LightState], 0, vk::DescriptorType::eUniformBuffer, lightStageUniform);
 	WriteBufferDescriptor(device, *descriptors[Descriptors::Lighting], 0, vk::DescriptorType::eUniformBuffer, lightUniform);
-
-	UpdateDescriptors();
 }
 
 //void DeferredExample::OnWindowResize(int w, int h) {
@@ -102,66 +100,67 @@ void	DeferredExample::LoadShaders() {
 		.WithVertexBinary("DeferredCombine.vert.spv")
 		.WithFragmentBinary("DeferredCombine.frag.spv")
 	.Build("Deferred Combine Shader");
+
+	postShader = ShaderBuilder(renderer->GetDevice())
+		.WithVertexBinary("DeferredCombine.vert.spv")
+		.WithFragmentBinary("Display.frag.spv")
+	.Build("Deferred Post Process Shader");
 }
 
 void	DeferredExample::CreateFrameBuffers(uint32_t width, uint32_t height) {
-	TextureBuilder builder(renderer->GetDevice(), renderer->GetMemoryAllocator());
-
-	builder.UsingPool(renderer->GetCommandPool(CommandBuffer::Graphics))
-			.UsingQueue(renderer->GetQueue(CommandBuffer::Graphics))
-			.WithDimension(width, height, 1)
-			.WithMips(false)
-			.WithUsages(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled)
-			.WithPipeFlags(vk::PipelineStageFlagBits2::eColorAttachmentOutput)
-			.WithLayout(vk::ImageLayout::eColorAttachmentOptimal)
-			.WithFormat(vk::Format::eB8G8R8A8Unorm);
-
-	bufferTextures[ScreenTextures::Albedo]		= builder.Build("GBuffer Diffuse");
-	bufferTextures[ScreenTextures::Normals]		= builder.Build("GBuffer Normals");
-	bufferTextures[ScreenTextures::Diffuse]		= builder.Build("Deferred Diffuse");
-	bufferTextures[ScreenTextures::Specular]	= builder.Build("Deferred Specular");
-
-	bufferTextures[ScreenTextures::Depth] = builder
-		.WithUsages(vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled)
-		.WithLayout(vk::ImageLayout::eDepthAttachmentOptimal)
-		.WithFormat(vk::Format::eD32Sfloat)
-		.WithAspects(vk::ImageAspectFlagBits::eDepth)
-	.Build("GBuffer Depth");
-
-	UpdateDescriptors();
+	//The images themselves are made by the render graph, once it knows which of them can share memory
+	TransientImageInfo colourInfo = {
+		.width	= width,
+		.height = height,
+		.format = vk::Format::eB8G8R8A8Unorm,
+		.usages = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled
+	};
+	screenTextureInfo[ScreenTextures::Albedo]	= colourInfo;
+	screenTextureInfo[ScreenTextures::Normals]	= colourInfo;
+	screenTextureInfo[ScreenTextures::Diffuse]	= colourInfo;
+	screenTextureInfo[ScreenTextures::Specular] = colourInfo;
+	screenTextureInfo[ScreenTextures::SceneColour] = colourInfo;
+
+	screenTextureInfo[ScreenTextures::Depth] = {
+		.width		= width,
+		.height		= height,
+		.format		= vk::Format::eD32Sfloat,
+		.usages		= vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled,
+		.aspects	= vk::ImageAspectFlagBits::eDepth
+	};
 }
 
 void	DeferredExample::UpdateDescriptors() {
-	if (!descriptors[Descriptors::LightTexture]) {
-		return;
-	}
-
 	DescriptorSetWriter(renderer->GetDevice(), *descriptors[Descriptors::LightTexture])
-		.WriteImage(0, *bufferTextures[1], *defaultSampler)
-		.WriteImage(1, *bufferTextures[2], *defaultSampler, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+		.WriteImage(0, renderGraph.GetImageView(screenTextures[ScreenTextures::Normals]), *defaultSampler)
+		.WriteImage(1, renderGraph.GetImageView(screenTextures[ScreenTextures::Depth]), *defaultSampler, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
 
 	DescriptorSetWriter(renderer->GetDevice(), *descriptors[Descriptors::Combine])
-		.WriteImage(0, *bufferTextures[0], *defaultSampler)
-		.WriteImage(1, *bufferTextures[3], *defaultSampler)
-		.WriteImage(2, *bufferTextures[4], *defaultSampler);
+		.WriteImage(0, renderGraph.GetImageView(screenTextures[ScreenTextures::Albedo]), *defaultSampler)
+		.WriteImage(1, renderGraph.GetImageView(screenTextures[ScreenTextures::Diffuse]), *defaultSampler)
+		.WriteImage(2, renderGraph.GetImageView(screenTextures[ScreenTextures::Specular]), *defaultSampler);
+
+	DescriptorSetWriter(renderer->GetDevice(), *descriptors[Descriptors::Post])
+		.WriteImage(0, renderGraph.GetImageView(screenTextures[ScreenTextures::SceneColour]), *defaultSampler);
 }
 
 void	DeferredExample::BuildPipelines() {
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 	FrameState const& frameState = renderer->GetFrameState();
+	std::vector<std::future<void>> pipelineBuilds;
 	{
-		gBufferPipeline = PipelineBuilder(device)
+		pipelineBuilds.push_back(PipelineBuilder(device)
 			.WithVertexInputState(cubeMesh->GetVertexInputState())
 			.WithTopology(vk::PrimitiveTopology::eTriangleList)
 			.WithShader(gBufferShader)
-			.WithColourAttachment(bufferTextures[ScreenTextures::Albedo]->GetFormat())
-			.WithColourAttachment(bufferTextures[ScreenTextures::Normals]->GetFormat())
-			.WithDepthAttachment(bufferTextures[ScreenTextures::Depth]->GetFormat(), vk::CompareOp::eLessOrEqual, true, true)
-			.Build("Main Scene Pipeline");
+			.WithColourAttachment(screenTextureInfo[ScreenTextures::Albedo].format)
+			.WithColourAttachment(screenTextureInfo[ScreenTextures::Normals].format)
+			.WithDepthAttachment(screenTextureInfo[ScreenTextures::Depth].format, vk::CompareOp::eLessOrEqual, true, true)
+			.BuildAsync(gBufferPipeline, "Main Scene Pipeline"));
 
-		boxObject.descriptorSet		= CreateDescriptorSet(device, pool, gBufferShader->GetLayout(1));
-		floorObject.descriptorSet	= CreateDescriptorSet(device, pool, gBufferShader->GetLayout(1));
+		boxObject.descriptorSet		= descriptorAllocator.Allocate(gBufferShader->GetLayout(1));
+		floorObject.descriptorSet	= descriptorAllocator.Allocate(gBufferShader->GetLayout(1));
 
 		DescriptorSetWriter(device, *boxObject.descriptorSet)
 			.WriteImage(0, *objectTextures[0], *defaultSampler)
@@ -172,31 +171,43 @@ void	DeferredExample::BuildPipelines() {
 			.WriteImage(1, *objectTextures[3], *defaultSampler);
 	}
 	{
-		lightPipeline = PipelineBuilder(device)
+		pipelineBuilds.push_back(PipelineBuilder(device)
 			.WithVertexInputState(sphereMesh->GetVertexInputState())
 			.WithTopology(vk::PrimitiveTopology::eTriangleList)
 			.WithShader(lightingShader)
 			.WithRasterState(vk::CullModeFlagBits::eFront, vk::PolygonMode::eFill)
 
-			.WithColourAttachment(bufferTextures[ScreenTextures::Diffuse]->GetFormat(), vk::BlendFactor::eOne, vk::BlendFactor::eOne)
-			.WithColourAttachment(bufferTextures[ScreenTextures::Specular]->GetFormat(), vk::BlendFactor::eOne, vk::BlendFactor::eOne)
+			.WithColourAttachment(screenTextureInfo[ScreenTextures::Diffuse].format, vk::BlendFactor::eOne, vk::BlendFactor::eOne)
+			.WithColourAttachment(screenTextureInfo[ScreenTextures::Specular].format, vk::BlendFactor::eOne, vk::BlendFactor::eOne)
 
-		.Build("Deferred Lighting Pipeline");
+		.BuildAsync(lightPipeline, "Deferred Lighting Pipeline"));
 
-		descriptors[Descriptors::Lighting]		= CreateDescriptorSet(device, pool, lightingShader->GetLayout(1));
-		descriptors[Descriptors::LightState]	= CreateDescriptorSet(device, pool, lightingShader->GetLayout(2));
-		descriptors[Descriptors::LightTexture]	= CreateDescriptorSet(device, pool, lightingShader->GetLayout(3));
+		descriptors[Descriptors::Lighting]		= descriptorAllocator.Allocate(lightingShader->GetLayout(1));
+		descriptors[Descriptors::LightTexture]	= descriptorAllocator.Allocate(lightingShader->GetLayout(3));
 	}
 	{
-		combinePipeline = PipelineBuilder(device)
+		pipelineBuilds.push_back(PipelineBuilder(device)
 			.WithVertexInputState(quadMesh->GetVertexInputState())
 			.WithTopology(vk::PrimitiveTopology::eTriangleStrip)
 			.WithShader(combineShader)		
+			.WithColourAttachment(screenTextureInfo[ScreenTextures::SceneColour].format)
+		.BuildAsync(combinePipeline, "Deferred Combine Pipeline"));
+
+		descriptors[Descriptors::Combine] = descriptorAllocator.Allocate(combineShader->GetLayout(0));
+	}
+	{
+		pipelineBuilds.push_back(PipelineBuilder(device)
+			.WithVertexInputState(quadMesh->GetVertexInputState())
+			.WithTopology(vk::PrimitiveTopology::eTriangleStrip)
+			.WithShader(postShader)
 			.WithColourAttachment(frameState.colourFormat)
-			.WithDepthAttachment(frameState.depthFormat)
-		.Build("Post process pipeline");
+		.BuildAsync(postPipeline, "Post process pipeline"));
 
-		descriptors[Descriptors::Combine] = CreateDescriptorSet(device, pool, combineShader->GetLayout(0));
+		descriptors[Descriptors::Post] = descriptorAllocator.Allocate(postShader->GetLayout(0));
+	}
+	//The descriptor sets above were made while the pipelines compiled, now wait for them to finish
+	for (auto& i : pipelineBuilds) {
+		i.get();
 	}
 }
 
@@ -204,92 +215,163 @@ void DeferredExample::RenderFrame(float dt) {
 	LightStageUBOData newData;
 	newData.camPosition = camera.GetPosition();
 
-	Vector2i screenSize = hostWindow.GetScreenSize();
+	FrameState const& frameState = renderer->GetFrameState();
 
-	newData.screenResolution.x = 1.0f / (float)(screenSize.x);
-	newData.screenResolution.y = 1.0f / (float)(screenSize.y);
-	newData.inverseViewProj = Matrix::Inverse(camera.BuildProjectionMatrix(hostWindow.GetScreenAspect()) * camera.BuildViewMatrix());
+	//The G-Buffer is window sized, but with dynamic resolution only the top left of it gets drawn into
+	vk::Extent2D renderSize = frameState.defaultScreenRect.extent;
+	Vector2i	 screenSize = hostWindow.GetScreenSize();
+	textureScale = Vector2((float)renderSize.width / (float)screenSize.x, (float)renderSize.height / (float)screenSize.y);
 
-	lightStageUniform.CopyData(&newData, sizeof(LightStageUBOData));
+	newData.screenResolution.x	= 1.0f / (float)(renderSize.width);
+	newData.screenResolution.y	= 1.0f / (float)(renderSize.height);
+	newData.textureScale		= textureScale;
+	newData.inverseViewProj = Matrix::Inverse(camera.BuildProjectionMatrix(hostWindow.GetScreenAspect()) * camera.BuildViewMatrix());
 
-	FillGBuffer();
-	RenderLights();
-	CombineBuffers();
+	FrameUploadRing::Allocation lightStageData = renderer->GetFrameUploadRing().Upload(newData);
+	lightStateDescriptor = renderer->GetFrameDescriptorAllocator().Allocate(lightingShader->GetLayout(2));
+	WriteBufferDescriptor(renderer->GetDevice(), lightStateDescriptor, 0, vk::DescriptorType::eUniformBuffer, lightStageData.buffer, lightStageData.offset, lightStageData.size);
+
+	renderGraph.Reset();
+	screenTextures[ScreenTextures::Albedo]		= renderGraph.CreateTransientImage("GBuffer Albedo"	, screenTextureInfo[ScreenTextures::Albedo]);
+	screenTextures[ScreenTextures::Normals]		= renderGraph.CreateTransientImage("GBuffer Normals"	, screenTextureInfo[ScreenTextures::Normals]);
+	screenTextures[ScreenTextures::Depth]		= renderGraph.CreateTransientImage("GBuffer Depth"		, screenTextureInfo[ScreenTextures::Depth]);
+	screenTextures[ScreenTextures::Diffuse]		= renderGraph.CreateTransientImage("Deferred Diffuse"	, screenTextureInfo[ScreenTextures::Diffuse]);
+	screenTextures[ScreenTextures::Specular]	= renderGraph.CreateTransientImage("Deferred Specular", screenTextureInfo[ScreenTextures::Specular]);
+	screenTextures[ScreenTextures::SceneColour]	= renderGraph.CreateTransientImage("Scene Colour"		, screenTextureInfo[ScreenTextures::SceneColour]);
+
+	RenderGraph::ResourceID albedo		= screenTextures[ScreenTextures::Albedo];
+	RenderGraph::ResourceID normals		= screenTextures[ScreenTextures::Normals];
+	RenderGraph::ResourceID depth		= screenTextures[ScreenTextures::Depth];
+	RenderGraph::ResourceID diffuse		= screenTextures[ScreenTextures::Diffuse];
+	RenderGraph::ResourceID specular	= screenTextures[ScreenTextures::Specular];
+	RenderGraph::ResourceID sceneColour	= screenTextures[ScreenTextures::SceneColour];
+	//The renderer has already transitioned this frame's swapchain image for us
+	RenderGraph::ResourceID backBuffer	= renderGraph.ImportExternalImage("Back Buffer", frameState.colourImage, vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eColorAttachmentOptimal);
+	renderGraph.MarkOutput(backBuffer);
+
+	renderGraph.AddPass("Fill GBuffer", [this](vk::CommandBuffer cmds) { FillGBuffer(cmds); })
+		.ColourAttachment(albedo)
+		.ColourAttachment(normals)
+		.DepthAttachment(depth);
+
+	renderGraph.AddPass("Deferred Lighting", [this](vk::CommandBuffer cmds) { RenderLights(cmds); })
+		.SampledImage(normals)
+		.SampledImage(depth, vk::PipelineStageFlagBits2::eFragmentShader, vk::ImageLayout::eDepthStencilReadOnlyOptimal)
+		.ColourAttachment(diffuse)
+		.ColourAttachment(specular);
+
+	renderGraph.AddPass("Combine", [this](vk::CommandBuffer cmds) { CombineBuffers(cmds); })
+		.SampledImage(albedo)
+		.SampledImage(diffuse)
+		.SampledImage(specular)
+		.ColourAttachment(sceneColour);
+
+	//The normals and depth are finished with by now, so the scene colour can reuse their memory
+	renderGraph.AddPass("Post Process", [this](vk::CommandBuffer cmds) { PostProcess(cmds); })
+		.SampledImage(sceneColour)
+		.ColourAttachment(backBuffer);
+
+	if (!renderGraph.Compile()) {
+		//No G-Buffer this frame, but the back buffer still has to be written before it's presented
+		frameState.cmdBuffer.beginRendering(
+			DynamicRenderBuilder()
+				.WithColourAttachment(frameState.colourView, vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
+				.WithRenderArea(frameState.defaultScreenRect)
+				.Build()
+		);
+		frameState.cmdBuffer.endRendering();
+		return;
+	}
+	if (transientAllocator->GetGeneration() != screenTextureGeneration) {
+		//New images, so the descriptors need pointing at them. Earlier frames might still be using the old ones
+		renderer->GetDevice().waitIdle();
+		UpdateDescriptors();
+		screenTextureGeneration = transientAllocator->GetGeneration();
+	}
+	renderGraph.Execute(frameState.cmdBuffer);
 }
 
-void	DeferredExample::FillGBuffer() {
+void	DeferredExample::FillGBuffer(vk::CommandBuffer cmdBuffer) {
 	FrameState const& frameState = renderer->GetFrameState();
-	frameState.cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, gBufferPipeline);
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, gBufferPipeline);
 
-	frameState.cmdBuffer.beginRendering(
+	cmdBuffer.beginRendering(
 		DynamicRenderBuilder()
-			.WithColourAttachment(*bufferTextures[ScreenTextures::Albedo], vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
-			.WithColourAttachment(*bufferTextures[ScreenTextures::Normals], vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
-			.WithDepthAttachment(*bufferTextures[ScreenTextures::Depth], vk::ImageLayout::eDepthAttachmentOptimal, true, { {1.0f} }, false)
+			.WithColourAttachment(renderGraph.GetImageView(screenTextures[ScreenTextures::Albedo]), vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
+			.WithColourAttachment(renderGraph.GetImageView(screenTextures[ScreenTextures::Normals]), vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
+			.WithDepthAttachment(renderGraph.GetImageView(screenTextures[ScreenTextures::Depth]), vk::ImageLayout::eDepthAttachmentOptimal, true, { {1.0f} }, false)
 			.WithRenderArea(frameState.defaultScreenRect)
 			.Build()
 	);
 
-	WriteBufferDescriptor(renderer->GetDevice(), *cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraBuffer);
-	frameState.cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *gBufferPipeline.layout, 0, 1, &*cameraDescriptor, 0, nullptr);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *gBufferPipeline.layout, 0, 1, &cameraDescriptor, 0, nullptr);
 
-	RenderSingleObject(boxObject	, frameState.cmdBuffer, gBufferPipeline	, 1);
-	RenderSingleObject(floorObject	, frameState.cmdBuffer, gBufferPipeline	, 1);
+	RenderSingleObject(boxObject	, cmdBuffer, gBufferPipeline	, 1);
+	RenderSingleObject(floorObject	, cmdBuffer, gBufferPipeline	, 1);
 
-	frameState.cmdBuffer.endRendering();
+	cmdBuffer.endRendering();
 }
 
-void	DeferredExample::RenderLights() {	//Second step: Take in the GBuffer and render lights
+void	DeferredExample::RenderLights(vk::CommandBuffer cmdBuffer) {	//Second step: Take in the GBuffer and render lights
 	FrameState const& frameState = renderer->GetFrameState();
-	frameState.cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, lightPipeline);
-	TransitionColourToSampler(frameState.cmdBuffer, *bufferTextures[ScreenTextures::Normals]);
-	TransitionDepthToSampler(frameState.cmdBuffer, *bufferTextures[ScreenTextures::Depth]);
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, lightPipeline);
 
-	frameState.cmdBuffer.beginRendering(
+	cmdBuffer.beginRendering(
 		DynamicRenderBuilder()
-		.WithColourAttachment(*bufferTextures[ScreenTextures::Diffuse], vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
-		.WithColourAttachment(*bufferTextures[ScreenTextures::Specular], vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
+		.WithColourAttachment(renderGraph.GetImageView(screenTextures[ScreenTextures::Diffuse]), vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
+		.WithColourAttachment(renderGraph.GetImageView(screenTextures[ScreenTextures::Specular]), vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
 		.WithRenderArea(frameState.defaultScreenRect)
 		.WithLayerCount(1)
 		.Build()
 	);
 
 	DescriptorSetMultiBinder()
-		.Bind(*cameraDescriptor, 0)
+		.Bind(cameraDescriptor, 0)
 		.Bind(*descriptors[Descriptors::Lighting], 1)
-		.Bind(*descriptors[Descriptors::LightState], 2)
+		.Bind(lightStateDescriptor, 2)
 		.Bind(*descriptors[Descriptors::LightTexture], 3)
-		.Commit(frameState.cmdBuffer, *lightPipeline.layout);
+		.Commit(cmdBuffer, *lightPipeline.layout);
 
-	sphereMesh->Draw(frameState.cmdBuffer, LIGHTCOUNT);
+	sphereMesh->Draw(cmdBuffer, LIGHTCOUNT);
 
-	frameState.cmdBuffer.endRendering();
+	cmdBuffer.endRendering();
 }
 
-void	DeferredExample::CombineBuffers() {
+void	DeferredExample::CombineBuffers(vk::CommandBuffer cmdBuffer) {	//Third step: Combine the GBuffer and lighting into the scene colour
 	FrameState const& frameState = renderer->GetFrameState();
-	vk::CommandBuffer cmdBuffer = frameState.cmdBuffer;
-
-	TransitionColourToSampler(cmdBuffer, *bufferTextures[ScreenTextures::Albedo]);
-	TransitionColourToSampler(cmdBuffer, *bufferTextures[ScreenTextures::Diffuse]);
-	TransitionColourToSampler(cmdBuffer, *bufferTextures[ScreenTextures::Specular]);
-
 	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, combinePipeline);
 
-	renderer->BeginDefaultRendering(cmdBuffer);
+	cmdBuffer.beginRendering(
+		DynamicRenderBuilder()
+			.WithColourAttachment(renderGraph.GetImageView(screenTextures[ScreenTextures::SceneColour]), vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
+			.WithRenderArea(frameState.defaultScreenRect)
+			.Build()
+	);
 
 	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *combinePipeline.layout, 0, 1, &*descriptors[Descriptors::Combine], 0, nullptr);
+	cmdBuffer.pushConstants(*combinePipeline.layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(Vector2), (void*)&textureScale);
 
 	quadMesh->Draw(cmdBuffer);
 
 	cmdBuffer.endRendering();
+}
+
+void	DeferredExample::PostProcess(vk::CommandBuffer cmdBuffer) {	//Last step: Copy the scene colour out to the back buffer, which is where any post effects would go
+	FrameState const& frameState = renderer->GetFrameState();
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, postPipeline);
+
+	cmdBuffer.beginRendering(
+		DynamicRenderBuilder()
+			.WithColourAttachment(frameState.colourView, vk::ImageLayout::eColorAttachmentOptimal, true, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f))
+			.WithRenderArea(frameState.defaultScreenRect)
+			.Build()
+	);
 
-	TransitionSamplerToColour(cmdBuffer, *bufferTextures[ScreenTextures::Albedo]);
-	TransitionSamplerToColour(cmdBuffer, *bufferTextures[ScreenTextures::Normals]);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *postPipeline.layout, 0, 1, &*descriptors[Descriptors::Post], 0, nullptr);
+	cmdBuffer.pushConstants(*postPipeline.layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(Vector2), (void*)&textureScale);
 
-	TransitionSamplerToDepth(cmdBuffer, *bufferTextures[ScreenTextures::Depth]);
+	quadMesh->Draw(cmdBuffer);
 
-	TransitionSamplerToColour(cmdBuffer, *bufferTextures[ScreenTextures::Diffuse]);
-	TransitionSamplerToColour(cmdBuffer, *bufferTextures[ScreenTextures::Specular]);
+	cmdBuffer.endRendering();
 }
 //Old tutorial was 264 LOC...
\ No newline at end of file
@@ -7,6 +7,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "VulkanTutorial.h"
+#include "../VulkanRendering/VulkanRenderGraph.h"
 
 namespace NCL::Rendering::Vulkan {
 	class DeferredExample : public VulkanTutorial {
@@ -22,17 +23,18 @@ namespace NCL::Rendering::Vulkan {
 		void	BuildPipelines();
 
 
-		void	FillGBuffer();
-		void	RenderLights();
-		void	CombineBuffers();
+		void	FillGBuffer(vk::CommandBuffer cmdBuffer);
+		void	RenderLights(vk::CommandBuffer cmdBuffer);
+		void	CombineBuffers(vk::CommandBuffer cmdBuffer);
+		void	PostProcess(vk::CommandBuffer cmdBuffer);
 		void	UpdateDescriptors();
 
 		UniqueVulkanShader gBufferShader;
 		UniqueVulkanShader lightingShader;
 		UniqueVulkanShader combineShader;
+		UniqueVulkanShader postShader;
 
 		VulkanBuffer lightUniform;
-		VulkanBuffer lightStageUniform;
 
 		RenderObject boxObject;
 		RenderObject floorObject;
@@ -47,24 +49,35 @@ namespace NCL::Rendering::Vulkan {
 			Depth,
 			Diffuse,
 			Specular,
+			SceneColour,
 			MAX_TEXTURES
 		};
 
 		enum Descriptors {
 			Lighting,
 			Combine,
-			LightState,
 			LightTexture,
+			Post,
 			MAX_DESCRIPTORS
 		};
 
-		UniqueVulkanTexture bufferTextures[ScreenTextures::MAX_TEXTURES];
+		//The G-Buffer and lighting targets only exist for the frame, and may share memory
+		TransientImageInfo		screenTextureInfo[ScreenTextures::MAX_TEXTURES];
+		RenderGraph::ResourceID	screenTextures[ScreenTextures::MAX_TEXTURES];
+		uint32_t				screenTextureGeneration = 0;
+		Vector2					textureScale;	//How much of the screen textures this frame draws into
 		UniqueVulkanTexture objectTextures[4];
 
 		vk::UniqueDescriptorSet	descriptors[Descriptors::MAX_DESCRIPTORS];
+		vk::DescriptorSet		lightStateDescriptor;	//Made every frame, pointing at that frame's camera data
 
 		VulkanPipeline	gBufferPipeline;
 		VulkanPipeline	lightPipeline;
 		VulkanPipeline	combinePipeline;
+		VulkanPipeline	postPipeline;
+
+		//Works out the G-Buffer transitions, and where in memory each target lives
+		RenderGraph		renderGraph;
+		std::unique_ptr<TransientAllocator> transientAllocator;
 	};
 }
\ No newline at end of file
@@ -19,7 +19,7 @@ DescriptorExample::DescriptorExample(Window& window) : VulkanTutorial(window)	{
 	triMesh = GenerateTriangle();
 
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	shader = ShaderBuilder(device)
 		.WithVertexBinary("BasicDescriptor.vert.spv")
@@ -42,7 +42,7 @@ DescriptorExample::DescriptorExample(Window& window) : VulkanTutorial(window)	{
 		.WithDescriptorSetLayout(0, *descriptorLayout)
 	.Build("Basic Descriptor pipeline");
 
-	descriptorSet = CreateDescriptorSet(device, pool, *descriptorLayout);
+	descriptorSet = descriptorAllocator.Allocate(*descriptorLayout);
 
 	uniformData[0] = BufferBuilder(device, renderer->GetMemoryAllocator())
 		.WithBufferUsage(vk::BufferUsageFlagBits::eUniformBuffer)
@@ -13,12 +13,15 @@ using namespace Vulkan;
 
 GLTFExample::GLTFExample(Window& window) : VulkanTutorial(window)	{
 	VulkanInitialisation vkInit = DefaultInitialisation();
+	vkInit.autoBeginDynamicRendering = false;	//It's begun in RenderFrame, to be filled by secondary command buffers
 	renderer = new VulkanRenderer(window, vkInit);
 	InitTutorialObjects();
 
 	FrameState const& frameState = renderer->GetFrameState();
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+
+	//Every texture upload goes into the one submission
+	renderer->GetImmediateContext().BeginBatch();
 
 	GLTFLoader::Load("Sponza/Sponza.gltf",scene);
 
@@ -26,10 +29,13 @@ GLTFExample::GLTFExample(Window& window) : VulkanTutorial(window)	{
 		.SetYaw(90.0f)
 		.SetPosition({ 850, 840, -30 })
 		.SetFarPlane(5000.0f);
+	renderer->GetImmediateContext().EndBatch();
 
+	//Meshes stream in on the copy queue, and are drawn from the first frame they're ready in
+	std::vector<StreamingUploader::Ticket> meshTickets;
 	for (const auto& m : scene.meshes) {
 		VulkanMesh* loadedMesh = (VulkanMesh*)m.get();
-		loadedMesh->UploadToGPU(renderer);
+		meshTickets.push_back(loadedMesh->StreamToGPU(renderer));
 	}
 
 	shader = ShaderBuilder(device)
@@ -37,12 +43,22 @@ GLTFExample::GLTFExample(Window& window) : VulkanTutorial(window)	{
 		.WithFragmentBinary("SingleTexture.frag.spv")
 	.Build("Texturing Shader");
 
+	//Layers that use the same texture get the same set, and every new set is written in one call
+	DescriptorSetWriter materialWriter(device);
 	for (const auto& m : scene.materials) {	//Build descriptors for each mesh and its sublayers
 		layerDescriptors.push_back({});
-		std::vector<vk::UniqueDescriptorSet>& matSet = layerDescriptors.back();
+		std::vector<vk::DescriptorSet>& matSet = layerDescriptors.back();
 		for (const auto& l : m.allLayers) {
-			matSet.push_back(CreateDescriptorSet(device, pool, shader->GetLayout(1)));
-			WriteImageDescriptor(device , *matSet.back(), 0, ((VulkanTexture*)l.albedo.get())->GetDefaultView(), *defaultSampler);
+			matSet.push_back(renderer->GetDescriptorSetCache().Get(shader->GetLayout(1),
+				{ DescriptorWrite::Image(0, ((VulkanTexture*)l.albedo.get())->GetDefaultView(), *defaultSampler) }, materialWriter));
+		}
+	}
+	materialWriter.Flush();
+
+	for (size_t i = 0; i < scene.meshes.size(); ++i) {
+		VulkanMesh* loadedMesh = (VulkanMesh*)scene.meshes[i].get();
+		for (unsigned int j = 0; j < loadedMesh->GetSubMeshCount(); ++j) {
+			drawItems.push_back({ loadedMesh, j, layerDescriptors[i][j], meshTickets[i] });
 		}
 	}
 
@@ -58,24 +74,27 @@ GLTFExample::GLTFExample(Window& window) : VulkanTutorial(window)	{
 
 void GLTFExample::RenderFrame(float dt) {
 	FrameState const& state = renderer->GetFrameState();
-
-	vk::Device device = renderer->GetDevice();
 	vk::CommandBuffer cmdBuffer = state.cmdBuffer;
 
-	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
-	Matrix4 identity;
-	cmdBuffer.pushConstants(*pipeline.layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(Matrix4), (void*)&identity);
-
-	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, 1, &*cameraDescriptor, 0, nullptr);
-	WriteBufferDescriptor(device, *cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraBuffer);
-	for(size_t i = 0; i < scene.meshes.size(); ++i) {
-		VulkanMesh* loadedMesh = (VulkanMesh*)scene.meshes[i].get();
-		std::vector<vk::UniqueDescriptorSet>& set = layerDescriptors[i];
+	//Each thread gets a range of the draws to record into its own secondary buffer, which are then run in order.
+	//Nothing is inherited from the primary, so every range binds everything it needs
+	StreamingUploader& uploader = renderer->GetStreamingUploader();
+	renderer->BeginDefaultRendering(cmdBuffer, vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+	renderer->GetParallelRecorder().Record(cmdBuffer, renderer->GetDefaultSecondaryInfo(), (uint32_t)drawItems.size(),
+		[&](vk::CommandBuffer cmds, uint32_t first, uint32_t count) {
+			cmds.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+			Matrix4 identity;
+			cmds.pushConstants(*pipeline.layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(Matrix4), (void*)&identity);
+			cmds.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, 1, &cameraDescriptor, 0, nullptr);
 
-		for (unsigned int j = 0; j < loadedMesh->GetSubMeshCount(); ++j) {
-			cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 1, 1, &*set[j], 0, nullptr);
-		
-			loadedMesh->DrawLayer(j, cmdBuffer);
+			for (uint32_t i = first; i < first + count; ++i) {
+				if (!uploader.IsReady(drawItems[i].ticket)) {
+					continue;
+				}
+				cmds.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 1, 1, &drawItems[i].set, 0, nullptr);
+				drawItems[i].mesh->DrawLayer(drawItems[i].layer, cmds);
+			}
 		}
-	}
+	);
+	cmdBuffer.endRendering();
 }
\ No newline at end of file
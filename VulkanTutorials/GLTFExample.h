@@ -23,10 +23,19 @@ namespace NCL::Rendering::Vulkan {
 
 		GLTFScene  scene;
 
-		std::vector<std::vector<vk::UniqueDescriptorSet>>	 layerDescriptors;
+		std::vector<std::vector<vk::DescriptorSet>>	 layerDescriptors;
 
 		std::vector < vk::UniqueDescriptorSet > layerSets;
 
+		//Every submesh of every mesh, flattened so the list can be split evenly between recording threads
+		struct DrawItem {
+			VulkanMesh*			mesh;
+			uint32_t			layer;
+			vk::DescriptorSet	set;
+			StreamingUploader::Ticket ticket;
+		};
+		std::vector<DrawItem>	drawItems;
+
 		VulkanPipeline		pipeline;
 	};
 }
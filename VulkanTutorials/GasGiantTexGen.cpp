@@ -3,9 +3,12 @@ This file began life as a Vulkan tutorial called BasicCompute.cpp by Rich Daviso
 procedurally generating gas giants. 
 *//////////////////////////////////////////////////////////////////////////////
 #include "GasGiantTexGen.h"
+#include "../VulkanRendering/VulkanThreadPool.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <random>
-#include <thread>
 
 using namespace NCL;
 using namespace Rendering;
@@ -13,27 +16,49 @@ using namespace Vulkan;
 
 
 GasGiantTexGen::GasGiantTexGen(Window& window)
-	: VulkanTutorial(window), seed{ time(0) }, currentTex{ 0 }, frameNum{0}, msToCompute {0.0f}, msToEnd {0.0f}, LoDIndex{0}, timedMode{false}
+	: VulkanTutorial(window), seed{ (uint64_t)time(0) }, recipeStride{ 0 }, planetMipCount{ 1 }, currentTex{ 0 }, frameNum{0}, msToCompute {0.0f}, msToEnd {0.0f}, LoDIndex{0}, timedMode{false}, halfPrecisionSupported{false}, useHalfPrecision{false}, litMode{false},
+	tileCache(ATLAS_TILES * ATLAS_TILES), zoom{ 1.0f }, tileTime{ 0.0f }, tileFrame{ 0 }, tiledMode{ false }, tileTableDirty{ true }
 {
 	VulkanInitialisation vkInit = DefaultInitialisation();
 	vkInit.autoBeginDynamicRendering = false;
 
+	//only ask for fp16 shader arithmetic if the device has it, otherwise we fall back to the fp32 kernel
+	vkInit.onPhysicalDeviceSelected = [&](vk::PhysicalDevice gpu, VulkanInitialisation& init) {
+		static vk::PhysicalDeviceShaderFloat16Int8Features float16Features;
+
+		vk::PhysicalDeviceShaderFloat16Int8Features float16Support;
+		vk::PhysicalDeviceFeatures2 deviceFeatures;
+		deviceFeatures.pNext = &float16Support;
+		gpu.getFeatures2(&deviceFeatures);
+
+		halfPrecisionSupported = float16Support.shaderFloat16;
+		if (halfPrecisionSupported)
+		{
+			float16Features.shaderFloat16 = true;
+			init.features.push_back((void*)&float16Features);
+		}
+	};
+
 	renderer = new VulkanRenderer(window, vkInit);
 	InitTutorialObjects();
 	quad = GenerateQuad();
 	InitLoDs();
 	FrameState const& state = renderer->GetFrameState();
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
-	// Create the query pool object used to get the GPU time stamps
+	// Create the query pool object used to get the GPU time stamps, with a set of 3 for each frame in flight
 	vk::QueryPoolCreateInfo qpInfo{};
 	qpInfo.sType = vk::StructureType::eQueryPoolCreateInfo;	
 	qpInfo.queryType = vk::QueryType::eTimestamp;
-	qpInfo.queryCount = 3;
+	qpInfo.queryCount = 3 * renderer->GetFramesInFlight();
 	device.createQueryPool(&qpInfo,nullptr, &timeStampQP);
+	//the queries are read back before they're first written, so they need to start out reset
+	device.resetQueryPool(timeStampQP, 0, qpInfo.queryCount);
 
 
+	InitPlanetRecipes();
+	InitPlanetMips();
 	for (int i = 0; i < MAX_PLANETS; i++)
 	{
 		CreateNewPlanetDescrSets(i);
@@ -42,23 +67,44 @@ GasGiantTexGen::GasGiantTexGen(Window& window)
 
 	//build the compute shader, and attach the compute image descriptor to the pipeline
 	computeShader = UniqueVulkanCompute(new VulkanCompute(device, "GasGiantTex.comp.spv"));
-	computePipeline = ComputePipelineBuilder(device)
+	pipelineBuilds.push_back(ComputePipelineBuilder(device)
 		.WithShader(computeShader)
 		.WithDescriptorSetLayout(0, *imageDescrLayout[0])
-		.Build("Compute Pipeline");
+		.BuildAsync(computePipeline, "Compute Pipeline"));
+
+	if (halfPrecisionSupported)
+	{
+		halfComputeShader = UniqueVulkanCompute(new VulkanCompute(device, "GasGiantTexFP16.comp.spv"));
+		pipelineBuilds.push_back(ComputePipelineBuilder(device)
+			.WithShader(halfComputeShader)
+			.WithDescriptorSetLayout(0, *imageDescrLayout[0])
+			.BuildAsync(halfComputePipeline, "FP16 Compute Pipeline"));
+		useHalfPrecision = true;
+		std::cout << "Device supports shaderFloat16, using the fp16 noise kernel\n";
+	}
 
 	//build the raster shader, and attach the compute image descriptor to the pipeline
 	rasterShader = ShaderBuilder(device)
 		.WithVertexBinary("BasicCompute.vert.spv")
 		.WithFragmentBinary("BasicCompute.frag.spv")
 		.Build("Shader using compute data!");
-	basicPipeline = PipelineBuilder(device)
+	pipelineBuilds.push_back(PipelineBuilder(device)
 		.WithVertexInputState(quad->GetVertexInputState())
 		.WithTopology(vk::PrimitiveTopology::eTriangleStrip)
 		.WithShader(rasterShader)
 		.WithColourAttachment(state.colourFormat)
 		.WithDescriptorSetLayout(0, *imageDescrLayout[1])
-		.Build("Raster Pipeline");
+		.BuildAsync(basicPipeline, "Raster Pipeline"));
+
+	InitTiledZoom();
+	InitSurfaceMaps();
+
+	//every pipeline has been compiling on the thread pool in the background, they must all be ready before the first frame
+	for (auto& i : pipelineBuilds)
+	{
+		i.get();
+	}
+	pipelineBuilds.clear();
 }
 
 void GasGiantTexGen::Update(float dt)
@@ -68,6 +114,9 @@ void GasGiantTexGen::Update(float dt)
 
 	if (!timedMode)
 	{
+		int oldTex = currentTex;
+		int oldLoD = LoDIndex;
+
 		if (Window::GetKeyboard()->KeyPressed(KeyCodes::RIGHT))
 		{
 			currentTex = (currentTex < planetDescr.size() - 1) ? currentTex + 1 : currentTex;
@@ -87,6 +136,48 @@ void GasGiantTexGen::Update(float dt)
 		{
 			LoDIndex = (LoDIndex > 0) ? LoDIndex - 1 : 0;
 		}
+
+		if (Window::GetKeyboard()->KeyPressed(KeyCodes::H) && halfPrecisionSupported)
+		{
+			useHalfPrecision = !useHalfPrecision;
+			std::cout << "Using the " << (useHalfPrecision ? "fp16" : "fp32") << " noise kernel\n";
+		}
+
+		if (Window::GetKeyboard()->KeyPressed(KeyCodes::F))
+		{
+			CompareHalfPrecision();
+		}
+
+		if (Window::GetKeyboard()->KeyPressed(KeyCodes::G))
+		{
+			BenchmarkPlanetRecipes();
+		}
+
+		if (Window::GetKeyboard()->KeyPressed(KeyCodes::L))
+		{
+			litMode = !litMode;
+			std::cout << "Lighting " << (litMode ? "on" : "off") << "\n";
+		}
+
+		if (Window::GetKeyboard()->KeyPressed(KeyCodes::Z))
+		{
+			tiledMode = !tiledMode;
+			if (tiledMode)
+			{
+				//tiles are cached, so the planet is frozen at the moment we zoom in
+				tileTime = runTime;
+				InvalidateTiles();
+			}
+		}
+
+		if (tiledMode)
+		{
+			if (oldTex != currentTex || oldLoD != LoDIndex)
+			{
+				InvalidateTiles();
+			}
+			UpdateTiledZoom(dt);
+		}
 	}
 	
 
@@ -101,6 +192,7 @@ void GasGiantTexGen::Update(float dt)
 
 		if (timedMode)
 		{
+			tiledMode = false;
 			currentTex = 0;
 			frameNum = 0;
 			msToCompute = 0.0f;
@@ -120,18 +212,7 @@ void GasGiantTexGen::InitLoDs()
 void GasGiantTexGen::CreateNewPlanetDescrSets(int iteration)
 {
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
-
-	//InitTestConstVectors();
-	InitConstantVectors();
-	InitColourVars();
-	constVectorBuffer = BufferBuilder(renderer->GetDevice(), renderer->GetMemoryAllocator())
-		.WithBufferUsage(vk::BufferUsageFlagBits::eStorageBuffer)
-		.WithHostVisibility()
-		.WithPersistentMapping()
-		.Build(sizeof(Vector4) * (NUM_PERMUTATIONS * 2 + 1), "Constant Vector Buffer");
-
-	constVectorBuffer.CopyData(perms, sizeof(Vector4) * (NUM_PERMUTATIONS * 2 + 1));
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	//create descriptor set and descriptor set layout for the compute image
 	imageDescrLayout[0] = DescriptorSetLayoutBuilder(device)
@@ -141,87 +222,278 @@ void GasGiantTexGen::CreateNewPlanetDescrSets(int iteration)
 	imageDescrLayout[1] = DescriptorSetLayoutBuilder(device)
 		.WithImageSamplers(1, 1, vk::ShaderStageFlagBits::eFragment)
 		.Build("Raster version");
-	planetDescr.push_back(CreateDescriptorSet(device, pool, *imageDescrLayout[0]));
-	vertFragDescr.push_back(CreateDescriptorSet(device, pool, *imageDescrLayout[1]));
+	planetDescr.push_back(descriptorAllocator.Allocate(*imageDescrLayout[0]));
+	vertFragDescr.push_back(descriptorAllocator.Allocate(*imageDescrLayout[1]));
 
 	//build the texture to be used by the compute shader, and then actually turn it into an ImageDescriptor
 	TextureBuilder builder(renderer->GetDevice(), renderer->GetMemoryAllocator());
 	builder.UsingPool(renderer->GetCommandPool(CommandBuffer::Graphics))
 		.UsingQueue(renderer->GetQueue(CommandBuffer::Graphics))
 		.WithDimension(hostWindow.GetScreenSize().x, hostWindow.GetScreenSize().y, 1)
-		.WithMips(false)
+		.WithMips(true, false)
 		.WithUsages(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled)
 		.WithLayout(vk::ImageLayout::eGeneral)
-		.WithFormat(vk::Format::eB8G8R8A8Unorm);
+		.WithFormat(vk::Format::eR8G8B8A8Unorm)
+		.WithMemoryCategory(MemoryCategory::Planets);
 
 	computeTextures[iteration] = builder.Build("compute RW texture");
-	WriteStorageImageDescriptor(device, *planetDescr.back(), 0, *computeTextures[iteration], *defaultSampler, vk::ImageLayout::eGeneral);
-	WriteBufferDescriptor(device, *planetDescr.back(), 2, vk::DescriptorType::eStorageBuffer, constVectorBuffer);
+
+	//storage images can only see one mip at a time, so every level gets its own view
+	planetMipCount = std::min(computeTextures[iteration]->GetMipCount(), (uint32_t)MAX_PLANET_MIPS);
+	mipDescr.push_back(renderer->GetDescriptorAllocator().Allocate(*mipDescrLayout));
+	for (uint32_t mip = 0; mip < planetMipCount; mip++)
+	{
+		vk::ImageViewCreateInfo viewInfo = vk::ImageViewCreateInfo()
+			.setViewType(vk::ImageViewType::e2D)
+			.setFormat(computeTextures[iteration]->GetFormat())
+			.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, mip, 1, 0, 1))
+			.setImage(computeTextures[iteration]->GetImage());
+		mipViews[iteration].push_back(device.createImageViewUnique(viewInfo));
+	}
+	//unused slots still have to hold something valid, they're never read past mipCount
+	for (uint32_t mip = 0; mip < MAX_PLANET_MIPS; mip++)
+	{
+		vk::ImageView view = *mipViews[iteration][std::min(mip, planetMipCount - 1)];
+		WriteStorageImageDescriptor(device, *mipDescr.back(), 0, mip, view, *defaultSampler, vk::ImageLayout::eGeneral);
+	}
+	WriteBufferDescriptor(device, *mipDescr.back(), 1, vk::DescriptorType::eStorageBuffer, mipCounters);
+
+	WriteStorageImageDescriptor(device, *planetDescr.back(), 0, *mipViews[iteration][0], *defaultSampler, vk::ImageLayout::eGeneral);
+	WriteBufferDescriptor(device, *planetDescr.back(), 2, vk::DescriptorType::eStorageBuffer, recipeBuffer, iteration * recipeStride, sizeof(PlanetRecipe));
 	WriteImageDescriptor(device, *vertFragDescr.back(), 1, *computeTextures[iteration], *defaultSampler, vk::ImageLayout::eGeneral);
 
 }
 
-void GasGiantTexGen::InitColourVars()
+void GasGiantTexGen::InitPlanetMips()
 {
-	Vector4 vars;
-	float x = ((float)rand() / (RAND_MAX)) - 0.5f;
-	//whether to add or subtract for bass warp
-	vars.x = (x > 0) ? 1 : -1;
-	//upper limit for bass colour smoothstep
-	vars.y = 0.35 + ((float)rand() / (RAND_MAX) * 0.5);
-	//adjustment for frequency
-	vars.z = ((float)rand() / (RAND_MAX)) - 0.35f;
-
-	perms[NUM_PERMUTATIONS * 2] = vars;
+	vk::Device device = renderer->GetDevice();
+
+	mipDescrLayout = DescriptorSetLayoutBuilder(device)
+		.WithStorageImages(0, MAX_PLANET_MIPS, vk::ShaderStageFlagBits::eCompute)
+		.WithStorageBuffers(1, 1, vk::ShaderStageFlagBits::eCompute)
+		.Build("Planet Mip Chain");
+
+	//one finished-workgroup counter per planet, the last workgroup of each dispatch puts it back to 0
+	mipCounters = BufferBuilder(device, renderer->GetMemoryAllocator())
+		.WithBufferUsage(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst)
+		.WithMemoryCategory(MemoryCategory::Planets)
+		.Build(sizeof(uint32_t) * MAX_PLANETS, "Planet Mip Counters");
+
+	ImmediateContext& context = renderer->GetImmediateContext(CommandBuffer::Graphics);
+	vk::CommandBuffer cmds = context.Begin("Planet mip counter clear");
+	cmds.fillBuffer(mipCounters, 0, VK_WHOLE_SIZE, 0);
+	context.SubmitWait();
+
+	mipShader = UniqueVulkanCompute(new VulkanCompute(device, "GasGiantMips.comp.spv"));
+	pipelineBuilds.push_back(ComputePipelineBuilder(device)
+		.WithShader(mipShader)
+		.WithDescriptorSetLayout(0, *mipDescrLayout)
+		.BuildAsync(mipPipeline, "Planet Mip Pipeline"));
 }
 
-void GasGiantTexGen::RenderFrame(float dt) {
-	FrameState const& frameState = renderer->GetFrameState();
+//Generates every planet's recipe in parallel, then uploads them all to one device local buffer in a single submission
+void GasGiantTexGen::InitPlanetRecipes()
+{
 	vk::Device device = renderer->GetDevice();
-	vk::CommandBuffer cmdBuffer = frameState.cmdBuffer;
-	cmdBuffer.resetQueryPool(timeStampQP,0,3);
-	cmdBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, timeStampQP, 0);
 
-	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline);
-	Vector3 positionUniform = { runTime, 0.0f, 0.0f };
+	auto start = std::chrono::high_resolution_clock::now();
+	recipes.resize(MAX_PLANETS);
+	PlanetRecipeGenerator::GenerateBatch(seed, recipes.data(), recipes.size());
+	//PlanetRecipeGenerator::InitTestConstVectors(recipes[0]);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::cout << "Generated " << recipes.size() << " planet recipes in "
+		<< std::chrono::duration<float, std::milli>(end - start).count() << "ms\n";
+
+	//each planet's descriptor points at its own range, which has to respect the storage buffer offset alignment
+	size_t alignment = renderer->GetPhysicalDevice().getProperties().limits.minStorageBufferOffsetAlignment;
+	recipeStride = ((sizeof(PlanetRecipe) + alignment - 1) / alignment) * alignment;
+	size_t totalSize = recipeStride * recipes.size();
+
+	VulkanBuffer staging = BufferBuilder(device, renderer->GetMemoryAllocator())
+		.WithBufferUsage(vk::BufferUsageFlagBits::eTransferSrc)
+		.WithHostVisibility()
+		.Build(totalSize, "Planet Recipe Staging");
 
-	for (int i = 0; i < currentTex + 1; i++)
+	char* stagingData = staging.Map<char>();
+	for (size_t i = 0; i < recipes.size(); i++)
 	{
-		cmdBuffer.pushConstants(*computePipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(positionUniform), (void*)&positionUniform);
-		cmdBuffer.pushConstants(*computePipeline.layout, vk::ShaderStageFlagBits::eCompute, sizeof(Vector3), sizeof(Vector4) * 2, (void*)&LoDs[LoDIndex]);
-		cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *computePipeline.layout, 0, 1, &*planetDescr[i], 0, nullptr);
-		cmdBuffer.dispatch(std::ceil(hostWindow.GetScreenSize().x / 16.0), std::ceil(hostWindow.GetScreenSize().y / 16.0), 1);
+		memcpy(stagingData + i * recipeStride, &recipes[i], sizeof(PlanetRecipe));
 	}
-	cmdBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, timeStampQP, 1);
-	cmdBuffer.pipelineBarrier(
-		vk::PipelineStageFlagBits::eComputeShader,
-		vk::PipelineStageFlagBits::eVertexShader,
-		vk::DependencyFlags(), 0, nullptr, 0, nullptr, 0, nullptr
-	);
+	staging.Unmap();
+
+	recipeBuffer = BufferBuilder(device, renderer->GetMemoryAllocator())
+		.WithBufferUsage(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst)
+		.WithMemoryCategory(MemoryCategory::Planets)
+		.Build(totalSize, "Planet Recipes");
+
+	//waited on, as the staging buffer goes out of scope at the end of this function
+	ImmediateContext& context = renderer->GetImmediateContext(CommandBuffer::Graphics);
+	vk::CommandBuffer cmds = context.Begin("Planet recipe upload");
+	vk::BufferCopy region = { .srcOffset = 0, .dstOffset = 0, .size = totalSize };
+	cmds.copyBuffer(staging, recipeBuffer, 1, &region);
+	context.SubmitWait();
+}
 
-	cmdBuffer.beginRendering(
-		DynamicRenderBuilder()
-		.WithColourAttachment(frameState.colourView)
-		.WithRenderArea(frameState.defaultScreenRect)
-		.Build()
-	);
+//Times a large batch of recipes on every core against a single thread, and checks the two agree bit for bit
+void GasGiantTexGen::BenchmarkPlanetRecipes()
+{
+	const size_t count = 10000;
+	std::vector<PlanetRecipe> parallel(count);
+	std::vector<PlanetRecipe> serial(count);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	PlanetRecipeGenerator::GenerateBatch(seed, parallel.data(), count);
+	auto mid = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < count; ++i) {
+		PlanetRecipeGenerator::Generate(seed + i, serial[i]);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
 
-	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, basicPipeline);
-	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *basicPipeline.layout, 0, 1, &*vertFragDescr[currentTex], 0, nullptr);
-	quad->Draw(cmdBuffer);
-	cmdBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, timeStampQP, 2);
+	bool identical = memcmp(parallel.data(), serial.data(), sizeof(PlanetRecipe) * count) == 0;
+
+	std::cout << count << " planet recipes: " << std::chrono::duration<float, std::milli>(mid - start).count() << "ms on "
+		<< ThreadPool::Shared().GetThreadCount() + 1 << " threads, "
+		<< std::chrono::duration<float, std::milli>(end - mid).count() << "ms on 1 thread, output "
+		<< (identical ? "identical" : "DIFFERS") << "\n";
+}
+
+void GasGiantTexGen::RenderFrame(float dt) {
+	if (tiledMode)
+	{
+		RenderTiledFrame();
+		return;
+	}
+	FrameState const& frameState = renderer->GetFrameState();
+	vk::Device device = renderer->GetDevice();
+	vk::CommandBuffer cmdBuffer = frameState.cmdBuffer;
 
-	device.getQueryPoolResults(timeStampQP,
-		0,
+	//this frame's queries were last written framesInFlight frames ago, and the renderer has waited on that frame's fence
+	uint32_t firstQuery = renderer->GetCurrentFrameIndex() * 3;
+	vk::Result queryResult = device.getQueryPoolResults(timeStampQP,
+		firstQuery,
 		3,
 		3 * sizeof(uint64_t),
 		timeStamps,
 		sizeof(uint64_t),
 		vk::QueryResultFlagBits::e64
 	);
-	cmdBuffer.endRendering();
+	bool timeStampsReady = queryResult == vk::Result::eSuccess;
+
+	cmdBuffer.resetQueryPool(timeStampQP, firstQuery, 3);
+	cmdBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, timeStampQP, firstQuery);
+
+	//the graph remembers how each planet was last used, so the previous frame's sampling is waited on automatically
+	renderGraph.Reset();
+	std::vector<RenderGraph::ResourceID> planets;
+	for (int i = 0; i < currentTex + 1; i++)
+	{
+		planets.push_back(renderGraph.ImportImage("Planet " + std::to_string(i), *computeTextures[i], vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eGeneral));
+	}
+	RenderGraph::ResourceID counters	= renderGraph.ImportBuffer("Mip counters", mipCounters);
+	RenderGraph::ResourceID backBuffer	= renderGraph.ImportExternalImage("Back Buffer", frameState.colourImage, vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eColorAttachmentOptimal);
+	renderGraph.MarkOutput(backBuffer);
+
+	VulkanPipeline& noisePipeline = useHalfPrecision ? halfComputePipeline : computePipeline;
+	Vector3 positionUniform = { runTime, 0.0f, 0.0f };
+
+	//when lit, the displayed planet is left for the surface kernel, which writes all three maps in one pass
+	int colourOnlyCount = litMode ? currentTex : currentTex + 1;
+	RenderGraph::Pass& noisePass = renderGraph.AddPass("Planet noise", [&](vk::CommandBuffer cmds)
+	{
+		cmds.bindPipeline(vk::PipelineBindPoint::eCompute, noisePipeline);
+		for (int i = 0; i < colourOnlyCount; i++)
+		{
+			cmds.pushConstants(*noisePipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(positionUniform), (void*)&positionUniform);
+			cmds.pushConstants(*noisePipeline.layout, vk::ShaderStageFlagBits::eCompute, sizeof(Vector3), sizeof(int) * 6, (void*)&LoDs[LoDIndex]);
+			cmds.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *noisePipeline.layout, 0, 1, &*planetDescr[i], 0, nullptr);
+			cmds.dispatch(std::ceil(hostWindow.GetScreenSize().x / 16.0), std::ceil(hostWindow.GetScreenSize().y / 16.0), 1);
+		}
+	});
+	for (int i = 0; i < colourOnlyCount; i++)
+	{
+		noisePass.StorageImageWrite(planets[i]);
+	}
 
-	if (timedMode)
+	RenderGraph::ResourceID normals = 0;
+	if (litMode)
+	{
+		RenderGraph::ResourceID heights = renderGraph.ImportImage("Planet height map", *heightMap, vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eGeneral);
+		normals = renderGraph.ImportImage("Planet normal map", *normalMap, vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eGeneral);
+
+		//doesn't touch any of the other planets, so it runs alongside the noise pass
+		renderGraph.AddPass("Planet surface", [&](vk::CommandBuffer cmds)
+		{
+			vk::DescriptorSet surfaceSets[2] = { *planetDescr[currentTex], *surfaceComputeDescr };
+			cmds.bindPipeline(vk::PipelineBindPoint::eCompute, surfaceComputePipeline);
+			cmds.pushConstants(*surfaceComputePipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(positionUniform), (void*)&positionUniform);
+			cmds.pushConstants(*surfaceComputePipeline.layout, vk::ShaderStageFlagBits::eCompute, sizeof(Vector3), sizeof(int) * 6, (void*)&LoDs[LoDIndex]);
+			cmds.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *surfaceComputePipeline.layout, 0, 2, surfaceSets, 0, nullptr);
+			cmds.dispatch(std::ceil(hostWindow.GetScreenSize().x / 16.0), std::ceil(hostWindow.GetScreenSize().y / 16.0), 1);
+		})
+		.StorageImageWrite(planets[currentTex])
+		.StorageImageWrite(heights)
+		.StorageImageWrite(normals);
+	}
+
+	//a workgroup covers 16x16 texels of mip 1
+	Vector2i screenSize = hostWindow.GetScreenSize();
+	uint32_t mipGroupsX = (std::max(screenSize.x / 2, 1) + 15) / 16;
+	uint32_t mipGroupsY = (std::max(screenSize.y / 2, 1) + 15) / 16;
+	RenderGraph::Pass& mipPass = renderGraph.AddPass("Planet mips", [&](vk::CommandBuffer cmds)
+	{
+		cmds.bindPipeline(vk::PipelineBindPoint::eCompute, mipPipeline);
+		for (int i = 0; i < currentTex + 1; i++)
+		{
+			int mipConstants[2] = { (int)planetMipCount, i };
+			cmds.pushConstants(*mipPipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(mipConstants), (void*)mipConstants);
+			cmds.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *mipPipeline.layout, 0, 1, &*mipDescr[i], 0, nullptr);
+			cmds.dispatch(mipGroupsX, mipGroupsY, 1);
+		}
+		cmds.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, timeStampQP, firstQuery + 1);
+	});
+	for (int i = 0; i < currentTex + 1; i++)
+	{
+		mipPass.StorageImage(planets[i]);
+	}
+	mipPass.Write(counters, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+
+	RenderGraph::Pass& displayPass = renderGraph.AddPass("Display planet", [&](vk::CommandBuffer cmds)
+	{
+		cmds.beginRendering(
+			DynamicRenderBuilder()
+			.WithColourAttachment(frameState.colourView)
+			.WithRenderArea(frameState.defaultScreenRect)
+			.Build()
+		);
+
+		if (litMode)
+		{
+			//light circles the planet, so the relief reads from every direction
+			Vector3 lightDirection = { std::cos(runTime * 0.5f), std::sin(runTime * 0.5f), 0.6f };
+			vk::DescriptorSet litSets[2] = { *vertFragDescr[currentTex], *surfaceRasterDescr };
+			cmds.bindPipeline(vk::PipelineBindPoint::eGraphics, litRasterPipeline);
+			cmds.pushConstants(*litRasterPipeline.layout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(lightDirection), (void*)&lightDirection);
+			cmds.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *litRasterPipeline.layout, 0, 2, litSets, 0, nullptr);
+		}
+		else
+		{
+			cmds.bindPipeline(vk::PipelineBindPoint::eGraphics, basicPipeline);
+			cmds.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *basicPipeline.layout, 0, 1, &*vertFragDescr[currentTex], 0, nullptr);
+		}
+		quad->Draw(cmds);
+		cmds.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, timeStampQP, firstQuery + 2);
+		cmds.endRendering();
+	})
+	.SampledImage(planets[currentTex], vk::PipelineStageFlagBits2::eFragmentShader, vk::ImageLayout::eGeneral)
+	.ColourAttachment(backBuffer);
+	if (litMode)
+	{
+		displayPass.SampledImage(normals, vk::PipelineStageFlagBits2::eFragmentShader, vk::ImageLayout::eGeneral);
+	}
+
+	renderGraph.Execute(cmdBuffer);
+
+	if (timedMode && timeStampsReady)
 	{
 		PrintAverageTimestamps();
 	}
@@ -247,94 +519,475 @@ void GasGiantTexGen::PrintAverageTimestamps()
 	msToEnd += float(timeStamps[2] - timeStamps[1]) * deviceLimits.timestampPeriod / 1000000.0f;
 }
 
-void GasGiantTexGen::InitConstantVectors()
+//Runs both noise kernels over the current planet, and reports how far the fp16 output strays from fp32, and how long each took
+void GasGiantTexGen::CompareHalfPrecision()
 {
-	srand(seed++);
-	for (int i = 0; i < NUM_PERMUTATIONS; i++)
+	if (!halfPrecisionSupported)
 	{
-		perms[i].z = i;
-		HashConstVecs(i,i);
+		std::cout << "Device does not support shaderFloat16, only the fp32 kernel is available\n";
+		return;
 	}
-	for (int j = NUM_PERMUTATIONS - 1; j > 0; j--) {
-		int index = std::round(rand() % (j));
-		Vector4 temp = perms[j];
-		perms[j] = perms[index];
-		perms[index] = temp;
+	const int repeats = 20;
 
-		perms[j + NUM_PERMUTATIONS] = perms[j];
-		perms[index + NUM_PERMUTATIONS] = temp;
+	vk::Device device = renderer->GetDevice();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
+	uint32_t width = hostWindow.GetScreenSize().x;
+	uint32_t height = hostWindow.GetScreenSize().y;
+
+	VulkanPipeline* pipelines[2] = { &computePipeline, &halfComputePipeline };
+	UniqueVulkanTexture results[2];
+	vk::UniqueDescriptorSet resultDescr[2];
+	VulkanBuffer readbacks[2];
+
+	for (int i = 0; i < 2; i++)
+	{
+		results[i] = TextureBuilder(device, renderer->GetMemoryAllocator())
+			.UsingPool(renderer->GetCommandPool(CommandBuffer::Graphics))
+			.UsingQueue(renderer->GetQueue(CommandBuffer::Graphics))
+			.WithDimension(width, height, 1)
+			.WithMips(false)
+			.WithUsages(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc)
+			.WithLayout(vk::ImageLayout::eGeneral)
+			.WithFormat(vk::Format::eR8G8B8A8Unorm)
+			.Build("Precision comparison");
+
+		resultDescr[i] = descriptorAllocator.Allocate(*imageDescrLayout[0]);
+		WriteStorageImageDescriptor(device, *resultDescr[i], 0, *results[i], *defaultSampler, vk::ImageLayout::eGeneral);
+		WriteBufferDescriptor(device, *resultDescr[i], 2, vk::DescriptorType::eStorageBuffer, recipeBuffer, currentTex * recipeStride, sizeof(PlanetRecipe));
+
+		readbacks[i] = BufferBuilder(device, renderer->GetMemoryAllocator())
+			.WithBufferUsage(vk::BufferUsageFlagBits::eTransferDst)
+			.WithHostVisibility()
+			.Build(width * height * 4, "Precision readback");
 	}
+
+	vk::QueryPoolCreateInfo qpInfo{};
+	qpInfo.queryType = vk::QueryType::eTimestamp;
+	qpInfo.queryCount = 3;
+	vk::UniqueQueryPool comparisonQP = device.createQueryPoolUnique(qpInfo);
+
+	//the timings come from the timestamps, so waiting on the submission doesn't skew them
+	ImmediateContext& context = renderer->GetImmediateContext(CommandBuffer::Graphics);
+	vk::CommandBuffer cmds = context.Begin("FP16 comparison");
+	cmds.resetQueryPool(*comparisonQP, 0, 3);
+	cmds.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *comparisonQP, 0);
+
+	Vector3 positionUniform = { runTime, 0.0f, 0.0f };
+
+	vk::MemoryBarrier2 computeDone = {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eComputeShader,
+		.srcAccessMask	= vk::AccessFlagBits2::eShaderStorageWrite,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer,
+		.dstAccessMask	= vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferRead
+	};
+	vk::DependencyInfo computeDoneInfo;
+	computeDoneInfo.memoryBarrierCount = 1;
+	computeDoneInfo.pMemoryBarriers = &computeDone;
+
+	//every repeat writes the same image, so each has to wait for the last one's writes
+	vk::MemoryBarrier2 repeatDone = {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eComputeShader,
+		.srcAccessMask	= vk::AccessFlagBits2::eShaderStorageWrite,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eComputeShader,
+		.dstAccessMask	= vk::AccessFlagBits2::eShaderStorageWrite
+	};
+	vk::DependencyInfo repeatDoneInfo;
+	repeatDoneInfo.memoryBarrierCount = 1;
+	repeatDoneInfo.pMemoryBarriers = &repeatDone;
+
+	for (int i = 0; i < 2; i++)
+	{
+		cmds.bindPipeline(vk::PipelineBindPoint::eCompute, *pipelines[i]);
+		cmds.pushConstants(*pipelines[i]->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(positionUniform), (void*)&positionUniform);
+		cmds.pushConstants(*pipelines[i]->layout, vk::ShaderStageFlagBits::eCompute, sizeof(Vector3), sizeof(int) * 6, (void*)&LoDs[LoDIndex]);
+		cmds.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelines[i]->layout, 0, 1, &*resultDescr[i], 0, nullptr);
+		for (int r = 0; r < repeats; r++)
+		{
+			if (r > 0)
+			{
+				cmds.pipelineBarrier2(repeatDoneInfo);
+			}
+			cmds.dispatch(std::ceil(width / 16.0), std::ceil(height / 16.0), 1);
+		}
+		//the next kernel mustn't overlap this one, or the timings bleed into each other
+		cmds.pipelineBarrier2(computeDoneInfo);
+		cmds.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *comparisonQP, i + 1);
+	}
+
+	vk::BufferImageCopy copyInfo;
+	copyInfo.imageSubresource.setAspectMask(vk::ImageAspectFlagBits::eColor).setMipLevel(0).setLayerCount(1);
+	copyInfo.imageExtent = vk::Extent3D(width, height, 1);
+	for (int i = 0; i < 2; i++)
+	{
+		cmds.copyImageToBuffer(*results[i], vk::ImageLayout::eGeneral, readbacks[i], copyInfo);
+	}
+	vk::MemoryBarrier2 readbackDone = {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eTransfer,
+		.srcAccessMask	= vk::AccessFlagBits2::eTransferWrite,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eHost,
+		.dstAccessMask	= vk::AccessFlagBits2::eHostRead
+	};
+	vk::DependencyInfo readbackInfo;
+	readbackInfo.memoryBarrierCount = 1;
+	readbackInfo.pMemoryBarriers = &readbackDone;
+	cmds.pipelineBarrier2(readbackInfo);
+
+	context.SubmitWait();
+
+	uint64_t stamps[3];
+	device.getQueryPoolResults(*comparisonQP, 0, 3, sizeof(stamps), stamps, sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+	float period = renderer->GetPhysicalDevice().getProperties().limits.timestampPeriod;
+	float fullMs = float(stamps[1] - stamps[0]) * period / 1000000.0f / repeats;
+	float halfMs = float(stamps[2] - stamps[1]) * period / 1000000.0f / repeats;
+
+	vmaInvalidateAllocation(renderer->GetMemoryAllocator(), readbacks[0].allocationHandle, 0, VK_WHOLE_SIZE);
+	vmaInvalidateAllocation(renderer->GetMemoryAllocator(), readbacks[1].allocationHandle, 0, VK_WHOLE_SIZE);
+	const uint8_t* full = readbacks[0].Map<uint8_t>();
+	const uint8_t* half = readbacks[1].Map<uint8_t>();
+
+	int maxError = 0;
+	uint64_t totalError = 0;
+	size_t texelsOff = 0;
+	size_t texelCount = size_t(width) * height;
+	for (size_t t = 0; t < texelCount; t++)
+	{
+		int texelError = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			int error = std::abs(int(full[t * 4 + c]) - int(half[t * 4 + c]));
+			texelError = std::max(texelError, error);
+			totalError += error;
+		}
+		maxError = std::max(maxError, texelError);
+		texelsOff += (texelError > 1) ? 1 : 0;
+	}
+	readbacks[0].Unmap();
+	readbacks[1].Unmap();
+
+	std::cout << "FP16 vs FP32 error: max " << maxError << "/255, mean " << double(totalError) / (texelCount * 3)
+		<< "/255, " << 100.0 * double(texelsOff) / texelCount << "% of texels off by more than 1/255\n";
+	std::cout << "FP32 " << fullMs << "ms, FP16 " << halfMs << "ms per planet (" << fullMs / halfMs << "x)\n";
 }
 
-void GasGiantTexGen::HashConstVecs(int x, int ind)
+void GasGiantTexGen::InitSurfaceMaps()
 {
-	
-	int hash = x % 6;
-	switch (hash)
-	{
-	case 0:
-		perms[ind].x = 0.0f;
-		perms[ind].y = 1.4142f;
-		break;
-	case 1:
-		perms[ind].x = 0.0f;
-		perms[ind].y = -1.1412f;
-		break;
-	case 2:
-		perms[ind].x = 0.2455732529f;
-		perms[ind].y = 1.392715124f;
-		break;
-	case 3:
-		perms[ind].x = -0.2455732529f;
-		perms[ind].y = 1.392715124f;
-		break;
-	case 4:
-		perms[ind].x = 0.2455732529f;
-		perms[ind].y = -1.392715124f;
-		break;
-	case 5:
-		perms[ind].x = -0.2455732529f;
-		perms[ind].y = -1.392715124f;
-		break;
-	default:
-		break;
+	vk::Device device = renderer->GetDevice();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
+	FrameState const& state = renderer->GetFrameState();
+
+	//only the displayed planet is lit, so one height and normal map is shared between all of them
+	TextureBuilder builder(device, renderer->GetMemoryAllocator());
+	builder.UsingPool(renderer->GetCommandPool(CommandBuffer::Graphics))
+		.UsingQueue(renderer->GetQueue(CommandBuffer::Graphics))
+		.WithDimension(hostWindow.GetScreenSize().x, hostWindow.GetScreenSize().y, 1)
+		.WithMips(false)
+		.WithUsages(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled)
+		.WithLayout(vk::ImageLayout::eGeneral)
+		.WithMemoryCategory(MemoryCategory::Planets);
+
+	heightMap = builder.WithFormat(vk::Format::eR32Sfloat).Build("Planet height map");
+	normalMap = builder.WithFormat(vk::Format::eR8G8B8A8Unorm).Build("Planet normal map");
+
+	surfaceDescrLayout[0] = DescriptorSetLayoutBuilder(device)
+		.WithStorageImages(0, 1, vk::ShaderStageFlagBits::eCompute)
+		.WithStorageImages(1, 1, vk::ShaderStageFlagBits::eCompute)
+		.Build("Surface Map Output");
+	surfaceDescrLayout[1] = DescriptorSetLayoutBuilder(device)
+		.WithImageSamplers(0, 1, vk::ShaderStageFlagBits::eFragment)
+		.Build("Lit Raster");
+
+	surfaceComputeDescr = descriptorAllocator.Allocate(*surfaceDescrLayout[0]);
+	surfaceRasterDescr = descriptorAllocator.Allocate(*surfaceDescrLayout[1]);
+
+	WriteStorageImageDescriptor(device, *surfaceComputeDescr, 0, *heightMap, *defaultSampler, vk::ImageLayout::eGeneral);
+	WriteStorageImageDescriptor(device, *surfaceComputeDescr, 1, *normalMap, *defaultSampler, vk::ImageLayout::eGeneral);
+	WriteImageDescriptor(device, *surfaceRasterDescr, 0, *normalMap, *defaultSampler, vk::ImageLayout::eGeneral);
+
+	surfaceComputeShader = UniqueVulkanCompute(new VulkanCompute(device, "GasGiantTexSurface.comp.spv"));
+	pipelineBuilds.push_back(ComputePipelineBuilder(device)
+		.WithShader(surfaceComputeShader)
+		.WithDescriptorSetLayout(0, *imageDescrLayout[0])
+		.WithDescriptorSetLayout(1, *surfaceDescrLayout[0])
+		.BuildAsync(surfaceComputePipeline, "Surface Compute Pipeline"));
+
+	litRasterShader = ShaderBuilder(device)
+		.WithVertexBinary("BasicCompute.vert.spv")
+		.WithFragmentBinary("GasGiantLit.frag.spv")
+		.Build("Lit planet view");
+	pipelineBuilds.push_back(PipelineBuilder(device)
+		.WithVertexInputState(quad->GetVertexInputState())
+		.WithTopology(vk::PrimitiveTopology::eTriangleStrip)
+		.WithShader(litRasterShader)
+		.WithColourAttachment(state.colourFormat)
+		.WithDescriptorSetLayout(0, *imageDescrLayout[1])
+		.WithDescriptorSetLayout(1, *surfaceDescrLayout[1])
+		.BuildAsync(litRasterPipeline, "Lit Raster Pipeline"));
+}
+
+void GasGiantTexGen::InitTiledZoom()
+{
+	vk::Device device = renderer->GetDevice();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
+	FrameState const& state = renderer->GetFrameState();
+
+	tileBaseSize = Vector2i((int)hostWindow.GetScreenSize().x, (int)hostWindow.GetScreenSize().y);
+	zoomCentre = Vector2(0.5f, 0.5f);
+
+	//every level's tile grid is stored back to back in the one indirection table
+	uint32_t tableSize = 0;
+	for (int level = 0; level <= MAX_TILE_LEVEL; level++)
+	{
+		tileLevelOffsets.push_back(tableSize);
+		uint32_t tilesX = ((tileBaseSize.x << level) + TILE_SIZE - 1) / TILE_SIZE;
+		uint32_t tilesY = ((tileBaseSize.y << level) + TILE_SIZE - 1) / TILE_SIZE;
+		tableSize += tilesX * tilesY;
 	}
-	
 
+	tileIndirection = BufferBuilder(device, renderer->GetMemoryAllocator())
+		.WithBufferUsage(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst)
+		.WithMemoryCategory(MemoryCategory::Planets)
+		.Build(sizeof(int32_t) * tableSize, "Tile Indirection Table");
+
+	tileAtlas = TextureBuilder(device, renderer->GetMemoryAllocator())
+		.UsingPool(renderer->GetCommandPool(CommandBuffer::Graphics))
+		.UsingQueue(renderer->GetQueue(CommandBuffer::Graphics))
+		.WithDimension(ATLAS_TILES * TILE_SIZE, ATLAS_TILES * TILE_SIZE, 1)
+		.WithMips(false)
+		.WithUsages(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled)
+		.WithLayout(vk::ImageLayout::eGeneral)
+		.WithFormat(vk::Format::eR8G8B8A8Unorm)
+		.WithMemoryCategory(MemoryCategory::Planets)
+		.Build("Planet tile atlas");
 
+	tileDescrLayout[0] = DescriptorSetLayoutBuilder(device)
+		.WithStorageImages(0, 1, vk::ShaderStageFlagBits::eCompute)
+		.Build("Tile Atlas Output");
+	tileDescrLayout[1] = DescriptorSetLayoutBuilder(device)
+		.WithImageSamplers(0, 1, vk::ShaderStageFlagBits::eFragment)
+		.WithStorageBuffers(1, 1, vk::ShaderStageFlagBits::eFragment)
+		.Build("Tiled Raster");
+
+	tileComputeDescr = descriptorAllocator.Allocate(*tileDescrLayout[0]);
+	tileRasterDescr = descriptorAllocator.Allocate(*tileDescrLayout[1]);
+
+	WriteStorageImageDescriptor(device, *tileComputeDescr, 0, *tileAtlas, *defaultSampler, vk::ImageLayout::eGeneral);
+	WriteImageDescriptor(device, *tileRasterDescr, 0, *tileAtlas, *defaultSampler, vk::ImageLayout::eGeneral);
+	WriteBufferDescriptor(device, *tileRasterDescr, 1, vk::DescriptorType::eStorageBuffer, tileIndirection);
+
+	//set 0 is the same layout as the whole planet compute, so each planet's permutation buffer can be reused
+	tileShader = UniqueVulkanCompute(new VulkanCompute(device, "GasGiantTile.comp.spv"));
+	pipelineBuilds.push_back(ComputePipelineBuilder(device)
+		.WithShader(tileShader)
+		.WithDescriptorSetLayout(0, *imageDescrLayout[0])
+		.WithDescriptorSetLayout(1, *tileDescrLayout[0])
+		.BuildAsync(tilePipeline, "Tile Compute Pipeline"));
+
+	tiledRasterShader = ShaderBuilder(device)
+		.WithVertexBinary("BasicCompute.vert.spv")
+		.WithFragmentBinary("GasGiantTiled.frag.spv")
+		.Build("Tiled planet view");
+	pipelineBuilds.push_back(PipelineBuilder(device)
+		.WithVertexInputState(quad->GetVertexInputState())
+		.WithTopology(vk::PrimitiveTopology::eTriangleStrip)
+		.WithShader(tiledRasterShader)
+		.WithColourAttachment(state.colourFormat)
+		.WithDescriptorSetLayout(0, *tileDescrLayout[1])
+		.BuildAsync(tiledRasterPipeline, "Tiled Raster Pipeline"));
 }
 
-//for testing purposes: sends across the same set of numbers to derive the constant vectors every time, so we can see what different effects do
-void GasGiantTexGen::InitTestConstVectors()
+void GasGiantTexGen::InvalidateTiles()
 {
-	int permCopy[512] =
-	{
-		21,177,105,37,157,239,156,251,80,48,70,60,127,3,234,96,173,65,122,194,144,115,107,158,167,126,135,44,19,94,24,147,25,
-		118,79,88,187,183,72,30,64,199,145,91,214,216,230,86,205,218,226,246,140,164,143,42,181,76,223,58,104,195,201,162,16,
-		252,49,191,4,12,207,32,209,190,152,34,237,203,179,202,103,244,50,175,198,200,114,82,233,26,186,225,117,102,185,255,248,
-		36,238,35,78,85,165,0,1,38,242,7,108,41,153,163,106,227,228,112,178,100,184,245,116,87,171,224,241,66,138,53,129,13,182,
-		253,148,250,155,55,113,111,52,196,46,51,240,172,217,176,67,101,133,74,68,5,62,210,161,221,90,61,134,28,63,84,154,47,31,9,
-		222,150,170,180,130,6,121,14,146,206,40,128,57,249,10,23,99,236,20,15,189,43,92,215,169,160,125,247,211,192,136,22,2,168,
-		75,11,151,204,33,29,232,123,109,27,17,54,73,56,254,69,213,93,81,97,231,141,120,188,98,71,110,219,235,89,166,208,193,142,
-		45,159,18,243,229,212,197,137,59,139,131,95,39,220,77,119,83,174,8,132,149,124,
-		21,177,105,37,157,239,156,251,80,48,70,60,127,3,234,96,173,65,122,194,144,115,107,158,167,126,135,44,19,94,24,147,25,
-		118,79,88,187,183,72,30,64,199,145,91,214,216,230,86,205,218,226,246,140,164,143,42,181,76,223,58,104,195,201,162,16,
-		252,49,191,4,12,207,32,209,190,152,34,237,203,179,202,103,244,50,175,198,200,114,82,233,26,186,225,117,102,185,255,248,
-		36,238,35,78,85,165,0,1,38,242,7,108,41,153,163,106,227,228,112,178,100,184,245,116,87,171,224,241,66,138,53,129,13,182,
-		253,148,250,155,55,113,111,52,196,46,51,240,172,217,176,67,101,133,74,68,5,62,210,161,221,90,61,134,28,63,84,154,47,31,9,
-		222,150,170,180,130,6,121,14,146,206,40,128,57,249,10,23,99,236,20,15,189,43,92,215,169,160,125,247,211,192,136,22,2,168,
-		75,11,151,204,33,29,232,123,109,27,17,54,73,56,254,69,213,93,81,97,231,141,120,188,98,71,110,219,235,89,166,208,193,142,
-		45,159,18,243,229,212,197,137,59,139,131,95,39,220,77,119,83,174,8,132,149,124
+	tileTableDirty = true;
+}
 
-	};
+void GasGiantTexGen::UpdateTiledZoom(float dt)
+{
+	const float zoomSpeed = 1.5f; //doublings per second
+	const float maxZoom = float(1 << MAX_TILE_LEVEL) * 2.0f;
+
+	if (Window::GetKeyboard()->KeyDown(KeyCodes::Q))
+	{
+		zoom *= std::exp2(zoomSpeed * dt);
+	}
+	if (Window::GetKeyboard()->KeyDown(KeyCodes::E))
+	{
+		zoom /= std::exp2(zoomSpeed * dt);
+	}
+	zoom = std::clamp(zoom, 1.0f, maxZoom);
 
-	for (int i = 0; i < NUM_PERMUTATIONS * 2; i++)
+	//pan at half a screen per second, whatever the zoom
+	float viewSpan = 1.0f / zoom;
+	float panSpeed = 0.5f * viewSpan * dt;
+
+	if (Window::GetKeyboard()->KeyDown(KeyCodes::W))
+	{
+		zoomCentre.y -= panSpeed;
+	}
+	if (Window::GetKeyboard()->KeyDown(KeyCodes::S))
 	{
-		perms[i].z = permCopy[i];
-		HashConstVecs(perms[i].z, i);
+		zoomCentre.y += panSpeed;
 	}
+	if (Window::GetKeyboard()->KeyDown(KeyCodes::A))
+	{
+		zoomCentre.x -= panSpeed;
+	}
+	if (Window::GetKeyboard()->KeyDown(KeyCodes::D))
+	{
+		zoomCentre.x += panSpeed;
+	}
+	zoomCentre.x = std::clamp(zoomCentre.x, viewSpan * 0.5f, 1.0f - viewSpan * 0.5f);
+	zoomCentre.y = std::clamp(zoomCentre.y, viewSpan * 0.5f, 1.0f - viewSpan * 0.5f);
 }
 
+void GasGiantTexGen::RenderTiledFrame()
+{
+	FrameState const& frameState = renderer->GetFrameState();
+	vk::CommandBuffer cmdBuffer = frameState.cmdBuffer;
+	tileFrame++;
+
+	float viewSpan = 1.0f / zoom;
+	Vector2 viewMin = Vector2(zoomCentre.x - viewSpan * 0.5f, zoomCentre.y - viewSpan * 0.5f);
+	int level = std::clamp((int)std::floor(std::log2(zoom)), 0, MAX_TILE_LEVEL);
+
+	//the previous frame's reads of the atlas and table have to finish before any slot is reused
+	vk::MemoryBarrier2 reuseBarrier = {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eFragmentShader,
+		.srcAccessMask	= vk::AccessFlagBits2::eNone,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer,
+		.dstAccessMask	= vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferWrite
+	};
+	vk::DependencyInfo reuseInfo;
+	reuseInfo.memoryBarrierCount = 1;
+	reuseInfo.pMemoryBarriers = &reuseBarrier;
+	cmdBuffer.pipelineBarrier2(reuseInfo);
+
+	if (tileTableDirty)
+	{
+		tileCache.Clear();
+		cmdBuffer.fillBuffer(tileIndirection, 0, VK_WHOLE_SIZE, ~0u);
+
+		vk::MemoryBarrier2 fillBarrier = {
+			.srcStageMask	= vk::PipelineStageFlagBits2::eTransfer,
+			.srcAccessMask	= vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask	= vk::PipelineStageFlagBits2::eTransfer,
+			.dstAccessMask	= vk::AccessFlagBits2::eTransferWrite
+		};
+		vk::DependencyInfo fillInfo;
+		fillInfo.memoryBarrierCount = 1;
+		fillInfo.pMemoryBarriers = &fillBarrier;
+		cmdBuffer.pipelineBarrier2(fillInfo);
+
+		tileTableDirty = false;
+	}
+
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, tilePipeline);
+	vk::DescriptorSet computeSets[2] = { *planetDescr[currentTex], *tileComputeDescr };
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *tilePipeline.layout, 0, 2, computeSets, 0, nullptr);
+
+	//the coarser level goes first, so there's always something to fall back to while the finer tiles arrive
+	int generated = 0;
+	std::map<uint32_t, int32_t> tableWrites;
+	if (level > 0)
+	{
+		RequestTiles(cmdBuffer, level - 1, viewMin, viewSpan, generated, tableWrites);
+	}
+	RequestTiles(cmdBuffer, level, viewMin, viewSpan, generated, tableWrites);
+
+	for (const auto& [index, slot] : tableWrites)
+	{
+		cmdBuffer.updateBuffer(tileIndirection, index * sizeof(int32_t), sizeof(int32_t), &slot);
+	}
+
+	vk::MemoryBarrier2 writeBarrier = {
+		.srcStageMask	= vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer,
+		.srcAccessMask	= vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferWrite,
+		.dstStageMask	= vk::PipelineStageFlagBits2::eFragmentShader,
+		.dstAccessMask	= vk::AccessFlagBits2::eShaderSampledRead | vk::AccessFlagBits2::eShaderStorageRead
+	};
+	vk::DependencyInfo writeInfo;
+	writeInfo.memoryBarrierCount = 1;
+	writeInfo.pMemoryBarriers = &writeBarrier;
+	cmdBuffer.pipelineBarrier2(writeInfo);
+
+	cmdBuffer.beginRendering(
+		DynamicRenderBuilder()
+		.WithColourAttachment(frameState.colourView)
+		.WithRenderArea(frameState.defaultScreenRect)
+		.Build()
+	);
+
+	TileViewConstants view = {
+		.viewMin	= viewMin,
+		.viewSize	= Vector2(viewSpan, viewSpan),
+		.baseSize	= tileBaseSize,
+		.level		= level,
+		.tileSize	= TILE_SIZE,
+		.atlasTiles = ATLAS_TILES
+	};
+
+	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, tiledRasterPipeline);
+	cmdBuffer.pushConstants(*tiledRasterPipeline.layout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(TileViewConstants), (void*)&view);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *tiledRasterPipeline.layout, 0, 1, &*tileRasterDescr, 0, nullptr);
+	quad->Draw(cmdBuffer);
 
+	cmdBuffer.endRendering();
+}
+
+void GasGiantTexGen::RequestTiles(vk::CommandBuffer cmdBuffer, int level, Vector2 viewMin, float viewSpan, int& generated, std::map<uint32_t, int32_t>& tableWrites)
+{
+	int virtualX = tileBaseSize.x << level;
+	int virtualY = tileBaseSize.y << level;
+	int tilesX = (virtualX + TILE_SIZE - 1) / TILE_SIZE;
+	int tilesY = (virtualY + TILE_SIZE - 1) / TILE_SIZE;
+
+	int minX = std::clamp((int)std::floor(viewMin.x * virtualX / TILE_SIZE), 0, tilesX - 1);
+	int minY = std::clamp((int)std::floor(viewMin.y * virtualY / TILE_SIZE), 0, tilesY - 1);
+	int maxX = std::clamp((int)std::floor((viewMin.x + viewSpan) * virtualX / TILE_SIZE), 0, tilesX - 1);
+	int maxY = std::clamp((int)std::floor((viewMin.y + viewSpan) * virtualY / TILE_SIZE), 0, tilesY - 1);
+
+	TilePushConstants constants = {};
+	constants.positionOffset = Vector3(tileTime, 0.0f, 0.0f);
+	for (int i = 0; i < 6; i++)
+	{
+		constants.LoD[i] = LoDs[LoDIndex][i];
+	}
+	constants.levelScale = 1.0f / float(1 << level);
+	//one more octave per doubling keeps the finest octave at roughly the same on-screen size
+	constants.extraOctaves = level;
 
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			uint32_t tileIndex = tileLevelOffsets[level] + y * tilesX + x;
+			uint32_t slot = 0;
+			if (tileCache.Touch(tileIndex, tileFrame, slot))
+			{
+				continue;
+			}
+			if (generated >= MAX_TILE_GENERATIONS_PER_FRAME)
+			{
+				continue;
+			}
+			bool evicted = false;
+			uint32_t evictedIndex = 0;
+			if (!tileCache.Allocate(tileIndex, tileFrame, slot, evicted, evictedIndex))
+			{
+				return; //the atlas is full of tiles on screen this frame
+			}
+			if (evicted)
+			{
+				tableWrites[evictedIndex] = -1;
+			}
+			constants.tileOrigin = Vector2i(x * TILE_SIZE, y * TILE_SIZE);
+			constants.atlasOrigin = Vector2i((slot % ATLAS_TILES) * TILE_SIZE, (slot / ATLAS_TILES) * TILE_SIZE);
+
+			cmdBuffer.pushConstants(*tilePipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(TilePushConstants), (void*)&constants);
+			cmdBuffer.dispatch(TILE_SIZE / 16, TILE_SIZE / 16, 1);
+
+			tableWrites[tileIndex] = (int32_t)slot;
+			generated++;
+		}
+	}
+}
 
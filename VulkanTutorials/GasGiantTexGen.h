@@ -4,11 +4,20 @@ procedurally generating gas giants.
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "VulkanTutorial.h"
+#include "../VulkanRendering/VulkanRenderGraph.h"
+#include "GasGiantTileCache.h"
+#include "PlanetRecipe.h"
 
 namespace NCL::Rendering::Vulkan {
 
-	constexpr int NUM_PERMUTATIONS = 256;
 	constexpr int MAX_PLANETS = 100;
+	constexpr int MAX_PLANET_MIPS = 14;	//must match MAX_MIPS in GasGiantMips.comp
+
+	//Deep zoom tiling
+	constexpr int TILE_SIZE			= 256;	//must be a multiple of the compute workgroup size
+	constexpr int ATLAS_TILES		= 12;	//atlas is ATLAS_TILES * ATLAS_TILES slots
+	constexpr int MAX_TILE_LEVEL	= 6;	//each level doubles the virtual resolution
+	constexpr int MAX_TILE_GENERATIONS_PER_FRAME = 16;
 
 	class GasGiantTexGen : public VulkanTutorial {
 	public:
@@ -18,26 +27,66 @@ namespace NCL::Rendering::Vulkan {
 		
 	protected:
 		void RenderFrame(float dt) override ;
-		void InitConstantVectors();
-		void InitColourVars();
-		void HashConstVecs(int x, int ind);
-		void InitTestConstVectors();
+		void InitPlanetRecipes();
+		void BenchmarkPlanetRecipes();
 		void CreateNewPlanetDescrSets(int iteration);
+		void InitPlanetMips();
 		void PrintAverageTimestamps();
 		void InitLoDs();
-		
+		void CompareHalfPrecision();
+		void InitSurfaceMaps();
+
+		void InitTiledZoom();
+		void UpdateTiledZoom(float dt);
+		void InvalidateTiles();
+		void RenderTiledFrame();
+		void RequestTiles(vk::CommandBuffer cmdBuffer, int level, Vector2 viewMin, float viewSpan, int& generated, std::map<uint32_t, int32_t>& tableWrites);
 
 		UniqueVulkanShader	rasterShader;
 		UniqueVulkanCompute	computeShader;
 		UniqueVulkanMesh quad;
-		VulkanBuffer constVectorBuffer;
+		//every planet's recipe lives in the one buffer, planet i at i * recipeStride
+		std::vector<PlanetRecipe> recipes;
+		VulkanBuffer recipeBuffer;
+		size_t recipeStride;
 		UniqueVulkanTexture computeTextures[MAX_PLANETS];
 
 		VulkanPipeline	basicPipeline;
 		VulkanPipeline	computePipeline;
+		//pipelines compile in the background while the rest of the constructor runs
+		std::vector<std::future<void>> pipelineBuilds;
+
+		//each planet's mip chain is rebuilt from mip 0 by one extra dispatch, straight after the noise pass
+		UniqueVulkanCompute	mipShader;
+		VulkanPipeline	mipPipeline;
+		vk::UniqueDescriptorSetLayout	mipDescrLayout;
+		std::vector<vk::UniqueImageView> mipViews[MAX_PLANETS];
+		std::vector<vk::UniqueDescriptorSet> mipDescr;
+		VulkanBuffer	mipCounters;
+		uint32_t		planetMipCount;
+
+		//fp16 variant of the noise kernel, used if the device supports shaderFloat16
+		UniqueVulkanCompute	halfComputeShader;
+		VulkanPipeline	halfComputePipeline;
+		bool halfPrecisionSupported;
+		bool useHalfPrecision;
+
+		//lit mode: the displayed planet is generated by a kernel that also writes height and normal maps
+		UniqueVulkanCompute	surfaceComputeShader;
+		UniqueVulkanShader	litRasterShader;
+		VulkanPipeline	surfaceComputePipeline;
+		VulkanPipeline	litRasterPipeline;
+		UniqueVulkanTexture	heightMap;
+		UniqueVulkanTexture	normalMap;
+		vk::UniqueDescriptorSetLayout	surfaceDescrLayout[2];
+		vk::UniqueDescriptorSet			surfaceComputeDescr;
+		vk::UniqueDescriptorSet			surfaceRasterDescr;
+		bool litMode;
 
-		Vector4 perms[NUM_PERMUTATIONS * 2 + 1];
-		time_t seed;
+		//orders the noise, mip and display passes, and keeps track of the planet images between frames
+		RenderGraph	renderGraph;
+
+		uint64_t seed; //planet i has ID seed + i
 		int currentTex;
 		int LoDIndex;
 		std::vector<std::array<int, 6>> LoDs;
@@ -52,5 +101,46 @@ namespace NCL::Rendering::Vulkan {
 		float msToCompute;
 		float msToEnd;
 		bool timedMode;
+
+		//Deep zoom: tiles of the current planet are generated on demand into a fixed size atlas
+		struct TilePushConstants {
+			Vector3		positionOffset;
+			int			LoD[6];
+			int			padding;
+			Vector2i	tileOrigin;
+			Vector2i	atlasOrigin;
+			float		levelScale;
+			int			extraOctaves;
+		};
+
+		struct TileViewConstants {
+			Vector2		viewMin;
+			Vector2		viewSize;
+			Vector2i	baseSize;
+			int			level;
+			int			tileSize;
+			int			atlasTiles;
+		};
+
+		UniqueVulkanCompute	tileShader;
+		UniqueVulkanShader	tiledRasterShader;
+		VulkanPipeline		tilePipeline;
+		VulkanPipeline		tiledRasterPipeline;
+
+		UniqueVulkanTexture	tileAtlas;
+		VulkanBuffer		tileIndirection;
+		vk::UniqueDescriptorSetLayout	tileDescrLayout[2];
+		vk::UniqueDescriptorSet			tileComputeDescr;
+		vk::UniqueDescriptorSet			tileRasterDescr;
+
+		GasGiantTileCache		tileCache;
+		std::vector<uint32_t>	tileLevelOffsets;
+		Vector2i	tileBaseSize;
+		Vector2		zoomCentre;
+		float		zoom;
+		float		tileTime;
+		uint32_t	tileFrame;
+		bool		tiledMode;
+		bool		tileTableDirty;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+/******************************************************************************
+Part of the procedural gas giant generator (see GasGiantTexGen.h).
+*//////////////////////////////////////////////////////////////////////////////
+#include "GasGiantTileCache.h"
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+GasGiantTileCache::GasGiantTileCache(uint32_t inSlotCount) : slotCount(inSlotCount) {
+	Clear();
+}
+
+bool GasGiantTileCache::Touch(uint32_t tileIndex, uint32_t frame, uint32_t& outSlot) {
+	auto i = residentTiles.find(tileIndex);
+	if (i == residentTiles.end()) {
+		return false;
+	}
+	i->second->lastUsedFrame = frame;
+	lruList.splice(lruList.begin(), lruList, i->second);
+	outSlot = i->second->slot;
+	return true;
+}
+
+bool GasGiantTileCache::Allocate(uint32_t tileIndex, uint32_t frame, uint32_t& outSlot, bool& outEvicted, uint32_t& outEvictedIndex) {
+	outEvicted = false;
+
+	if (!freeSlots.empty()) {
+		outSlot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		if (lruList.empty() || lruList.back().lastUsedFrame == frame) {
+			return false; //Everything in the atlas is on screen right now
+		}
+		Entry& victim = lruList.back();
+		outSlot			= victim.slot;
+		outEvicted		= true;
+		outEvictedIndex = victim.tileIndex;
+
+		residentTiles.erase(victim.tileIndex);
+		lruList.pop_back();
+	}
+	lruList.push_front({ tileIndex, outSlot, frame });
+	residentTiles[tileIndex] = lruList.begin();
+	return true;
+}
+
+void GasGiantTileCache::Clear() {
+	lruList.clear();
+	residentTiles.clear();
+	freeSlots.clear();
+	//Hand out the low slots first, it makes the atlas easier to read in a debugger
+	for (uint32_t i = slotCount; i > 0; --i) {
+		freeSlots.push_back(i - 1);
+	}
+}
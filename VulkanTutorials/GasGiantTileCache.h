@@ -0,0 +1,48 @@
+/******************************************************************************
+Part of the procedural gas giant generator (see GasGiantTexGen.h).
+
+GasGiantTileCache: CPU side bookkeeping for the deep zoom tile atlas. Tiles
+are identified by their index in the indirection table, and each resident
+tile owns one slot of the atlas. When the atlas is full, the least recently
+used tile that hasn't been touched this frame is evicted.
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <list>
+#include <unordered_map>
+
+namespace NCL::Rendering::Vulkan {
+	class GasGiantTileCache {
+	public:
+		GasGiantTileCache(uint32_t slotCount = 0);
+		~GasGiantTileCache() {}
+
+		//Returns true if the tile is resident, and marks it as used this frame
+		bool Touch(uint32_t tileIndex, uint32_t frame, uint32_t& outSlot);
+
+		//Assigns an atlas slot to a new tile. If a tile had to be evicted to make
+		//room, its table index is returned so the caller can unmap it.
+		//Fails if every slot holds a tile used this frame
+		bool Allocate(uint32_t tileIndex, uint32_t frame, uint32_t& outSlot, bool& outEvicted, uint32_t& outEvictedIndex);
+
+		void Clear();
+
+		uint32_t GetSlotCount() const {
+			return slotCount;
+		}
+
+		uint32_t GetResidentCount() const {
+			return (uint32_t)residentTiles.size();
+		}
+
+	protected:
+		struct Entry {
+			uint32_t tileIndex;
+			uint32_t slot;
+			uint32_t lastUsedFrame;
+		};
+		std::list<Entry>	lruList; //Most recently used at the front
+		std::unordered_map<uint32_t, std::list<Entry>::iterator> residentTiles;
+		std::vector<uint32_t> freeSlots;
+		uint32_t slotCount;
+	};
+}
@@ -46,13 +46,13 @@ LightingExample::LightingExample(Window& window) : VulkanTutorial(window) {
 
 	lightUniform.CopyData((void*)&testLight, sizeof(testLight));
 
-	allTextures[0] = LoadTexture("rust_diffuse.png");
-	allTextures[1] = LoadTexture("rust_bump.png");
-	allTextures[2] = LoadTexture("concrete_diffuse.png");
-	allTextures[3] = LoadTexture("concrete_bump.png");
+	std::vector<UniqueVulkanTexture> textures = LoadTextures({ "rust_diffuse.png", "rust_bump.png", "concrete_diffuse.png", "concrete_bump.png" });
+	for (int i = 0; i < 4; ++i) {
+		allTextures[i] = std::move(textures[i]);
+	}
 
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	pipeline = PipelineBuilder(device)
 		.WithVertexInputState(cubeMesh->GetVertexInputState())
@@ -61,10 +61,10 @@ LightingExample::LightingExample(Window& window) : VulkanTutorial(window) {
 		.WithDepthAttachment(renderer->GetDepthBuffer()->GetFormat(), vk::CompareOp::eLessOrEqual, true, true)
 		.Build("Lighting Pipeline");
 
-	lightDescriptor = CreateDescriptorSet(device, pool, lightingShader->GetLayout(1));
-	boxObject.descriptorSet = CreateDescriptorSet(device, pool, lightingShader->GetLayout(2));
-	floorObject.descriptorSet = CreateDescriptorSet(device, pool, lightingShader->GetLayout(2));
-	cameraPosDescriptor = CreateDescriptorSet(device, pool, lightingShader->GetLayout(3));
+	lightDescriptor = descriptorAllocator.Allocate(lightingShader->GetLayout(1));
+	boxObject.descriptorSet = descriptorAllocator.Allocate(lightingShader->GetLayout(2));
+	floorObject.descriptorSet = descriptorAllocator.Allocate(lightingShader->GetLayout(2));
+	cameraPosDescriptor = descriptorAllocator.Allocate(lightingShader->GetLayout(3));
 
 	WriteImageDescriptor(device, *boxObject.descriptorSet, 0, allTextures[0]->GetDefaultView(), *defaultSampler);
 	WriteImageDescriptor(device, *boxObject.descriptorSet, 1, allTextures[1]->GetDefaultView(), *defaultSampler);
@@ -72,7 +72,6 @@ LightingExample::LightingExample(Window& window) : VulkanTutorial(window) {
 	WriteImageDescriptor(device, *floorObject.descriptorSet, 0, allTextures[2]->GetDefaultView(), *defaultSampler);
 	WriteImageDescriptor(device, *floorObject.descriptorSet, 1, allTextures[3]->GetDefaultView(), *defaultSampler);
 
-	WriteBufferDescriptor(device, *cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraBuffer);
 	WriteBufferDescriptor(device, *lightDescriptor, 0, vk::DescriptorType::eUniformBuffer, lightUniform);
 	WriteBufferDescriptor(device, *cameraPosDescriptor, 0, vk::DescriptorType::eUniformBuffer, camPosUniform);
 }
@@ -92,11 +91,7 @@ void LightingExample::RenderFrame(float dt) {
 
 	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
 
-	WriteBufferDescriptor(device, *cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraBuffer);
-	WriteBufferDescriptor(device, *lightDescriptor, 0, vk::DescriptorType::eUniformBuffer, lightUniform);
-	WriteBufferDescriptor(device, *cameraPosDescriptor, 0, vk::DescriptorType::eUniformBuffer, camPosUniform);
-
-	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, 1, &*cameraDescriptor, 0, nullptr);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, 1, &cameraDescriptor, 0, nullptr);
 	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 1, 1, &*lightDescriptor, 0, nullptr);
 	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 3, 1, &*cameraPosDescriptor, 0, nullptr);
 
@@ -34,7 +34,7 @@ MultiPipelineExample::MultiPipelineExample(Window& window) : VulkanTutorial(wind
 
 	FrameState const& frameState = renderer->GetFrameState();
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 
 	solidColourPipeline = PipelineBuilder(renderer->GetDevice())
 		.WithVertexInputState(triangleMesh->GetVertexInputState())
@@ -52,8 +52,8 @@ MultiPipelineExample::MultiPipelineExample(Window& window) : VulkanTutorial(wind
 		.WithShader(texturingShader)
 		.Build("Texturing Pipeline");
 
-	descriptorSets[0] = CreateDescriptorSet(device, pool, texturingShader->GetLayout(1));
-	descriptorSets[1] = CreateDescriptorSet(device, pool, texturingShader->GetLayout(1));
+	descriptorSets[0] = descriptorAllocator.Allocate(texturingShader->GetLayout(1));
+	descriptorSets[1] = descriptorAllocator.Allocate(texturingShader->GetLayout(1));
 	WriteImageDescriptor(device, *descriptorSets[0], 0, textures[0]->GetDefaultView(), *defaultSampler);
 	WriteImageDescriptor(device, *descriptorSets[1], 0, textures[1]->GetDefaultView(), *defaultSampler);
 
@@ -0,0 +1,155 @@
+/******************************************************************************
+Part of the procedural gas giant generator (see GasGiantTexGen.h).
+*//////////////////////////////////////////////////////////////////////////////
+#include "PlanetRecipe.h"
+#include "../VulkanRendering/VulkanThreadPool.h"
+
+using namespace NCL;
+using namespace Rendering;
+using namespace Vulkan;
+
+static uint64_t SplitMix64(uint64_t& x) {
+	uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static uint64_t RotateLeft(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+PlanetRandom::PlanetRandom(uint64_t seed) {
+	//splitmix spreads neighbouring IDs out, so planet n and n+1 share nothing
+	for (int i = 0; i < 4; i++) {
+		state[i] = SplitMix64(seed);
+	}
+}
+
+uint64_t PlanetRandom::Next() {
+	uint64_t result = RotateLeft(state[1] * 5, 7) * 9;
+	uint64_t t = state[1] << 17;
+
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = RotateLeft(state[3], 45);
+
+	return result;
+}
+
+uint32_t PlanetRandom::NextBelow(uint32_t range) {
+	//multiply-shift on the top 32 bits, the bias is far too small to see in a permutation table
+	return (uint32_t)(((Next() >> 32) * range) >> 32);
+}
+
+float PlanetRandom::NextFloat() {
+	return float(Next() >> 40) * (1.0f / 16777216.0f);
+}
+
+void PlanetRecipeGenerator::Generate(uint64_t planetID, PlanetRecipe& out) {
+	PlanetRandom random(planetID);
+	InitConstantVectors(random, out);
+	InitColourVars(random, out);
+}
+
+void PlanetRecipeGenerator::GenerateBatch(uint64_t firstID, PlanetRecipe* out, size_t count) {
+	//every recipe only depends on its own ID, so each range can be handed to any thread
+	ThreadPool::Shared().ParallelFor((uint32_t)count, 64, [=](uint32_t first, uint32_t rangeCount) {
+		for (uint32_t i = first; i < first + rangeCount; ++i) {
+			Generate(firstID + i, out[i]);
+		}
+	});
+}
+
+void PlanetRecipeGenerator::InitConstantVectors(PlanetRandom& random, PlanetRecipe& out) {
+	Vector4* perms = out.perms;
+	for (int i = 0; i < NUM_PERMUTATIONS; i++) {
+		perms[i] = Vector4(0.0f, 0.0f, (float)i, 0.0f);
+		HashConstVecs(i, perms[i]);
+	}
+	for (int j = NUM_PERMUTATIONS - 1; j > 0; j--) {
+		int index = (int)random.NextBelow(j);
+		Vector4 temp = perms[j];
+		perms[j] = perms[index];
+		perms[index] = temp;
+
+		perms[j + NUM_PERMUTATIONS] = perms[j];
+		perms[index + NUM_PERMUTATIONS] = temp;
+	}
+}
+
+void PlanetRecipeGenerator::InitColourVars(PlanetRandom& random, PlanetRecipe& out) {
+	Vector4 vars;
+	//whether to add or subtract for bass warp
+	vars.x = (random.NextFloat() - 0.5f > 0) ? 1.0f : -1.0f;
+	//upper limit for bass colour smoothstep
+	vars.y = 0.35f + random.NextFloat() * 0.5f;
+	//adjustment for frequency
+	vars.z = random.NextFloat() - 0.35f;
+	vars.w = 0.0f;
+
+	out.perms[NUM_PERMUTATIONS * 2] = vars;
+}
+
+void PlanetRecipeGenerator::HashConstVecs(int x, Vector4& perm) {
+	int hash = x % 6;
+	switch (hash) {
+	case 0:
+		perm.x = 0.0f;
+		perm.y = 1.4142f;
+		break;
+	case 1:
+		perm.x = 0.0f;
+		perm.y = -1.1412f;
+		break;
+	case 2:
+		perm.x = 0.2455732529f;
+		perm.y = 1.392715124f;
+		break;
+	case 3:
+		perm.x = -0.2455732529f;
+		perm.y = 1.392715124f;
+		break;
+	case 4:
+		perm.x = 0.2455732529f;
+		perm.y = -1.392715124f;
+		break;
+	case 5:
+		perm.x = -0.2455732529f;
+		perm.y = -1.392715124f;
+		break;
+	default:
+		break;
+	}
+}
+
+void PlanetRecipeGenerator::InitTestConstVectors(PlanetRecipe& out) {
+	int permCopy[512] =
+	{
+		21,177,105,37,157,239,156,251,80,48,70,60,127,3,234,96,173,65,122,194,144,115,107,158,167,126,135,44,19,94,24,147,25,
+		118,79,88,187,183,72,30,64,199,145,91,214,216,230,86,205,218,226,246,140,164,143,42,181,76,223,58,104,195,201,162,16,
+		252,49,191,4,12,207,32,209,190,152,34,237,203,179,202,103,244,50,175,198,200,114,82,233,26,186,225,117,102,185,255,248,
+		36,238,35,78,85,165,0,1,38,242,7,108,41,153,163,106,227,228,112,178,100,184,245,116,87,171,224,241,66,138,53,129,13,182,
+		253,148,250,155,55,113,111,52,196,46,51,240,172,217,176,67,101,133,74,68,5,62,210,161,221,90,61,134,28,63,84,154,47,31,9,
+		222,150,170,180,130,6,121,14,146,206,40,128,57,249,10,23,99,236,20,15,189,43,92,215,169,160,125,247,211,192,136,22,2,168,
+		75,11,151,204,33,29,232,123,109,27,17,54,73,56,254,69,213,93,81,97,231,141,120,188,98,71,110,219,235,89,166,208,193,142,
+		45,159,18,243,229,212,197,137,59,139,131,95,39,220,77,119,83,174,8,132,149,124,
+		21,177,105,37,157,239,156,251,80,48,70,60,127,3,234,96,173,65,122,194,144,115,107,158,167,126,135,44,19,94,24,147,25,
+		118,79,88,187,183,72,30,64,199,145,91,214,216,230,86,205,218,226,246,140,164,143,42,181,76,223,58,104,195,201,162,16,
+		252,49,191,4,12,207,32,209,190,152,34,237,203,179,202,103,244,50,175,198,200,114,82,233,26,186,225,117,102,185,255,248,
+		36,238,35,78,85,165,0,1,38,242,7,108,41,153,163,106,227,228,112,178,100,184,245,116,87,171,224,241,66,138,53,129,13,182,
+		253,148,250,155,55,113,111,52,196,46,51,240,172,217,176,67,101,133,74,68,5,62,210,161,221,90,61,134,28,63,84,154,47,31,9,
+		222,150,170,180,130,6,121,14,146,206,40,128,57,249,10,23,99,236,20,15,189,43,92,215,169,160,125,247,211,192,136,22,2,168,
+		75,11,151,204,33,29,232,123,109,27,17,54,73,56,254,69,213,93,81,97,231,141,120,188,98,71,110,219,235,89,166,208,193,142,
+		45,159,18,243,229,212,197,137,59,139,131,95,39,220,77,119,83,174,8,132,149,124
+
+	};
+
+	for (int i = 0; i < NUM_PERMUTATIONS * 2; i++) {
+		out.perms[i].z = (float)permCopy[i];
+		HashConstVecs(permCopy[i], out.perms[i]);
+	}
+}
@@ -0,0 +1,56 @@
+/******************************************************************************
+Part of the procedural gas giant generator (see GasGiantTexGen.h).
+
+PlanetRecipe: everything the noise kernels need to build one planet - the
+shuffled permutation table with its constant vectors, plus the colour vars
+in the last entry. Recipes are derived purely from a 64 bit planet ID via a
+private PRNG, so the same ID gives the same planet on every machine, and
+any number of recipes can be generated at once on different threads.
+*//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace NCL::Rendering::Vulkan {
+
+	constexpr int NUM_PERMUTATIONS = 256;
+
+	struct PlanetRecipe {
+		Vector4 perms[NUM_PERMUTATIONS * 2 + 1];
+	};
+
+	//xoshiro256**, seeded through splitmix64. Fully specified, unlike the
+	//standard library distributions, so results don't vary between platforms
+	class PlanetRandom {
+	public:
+		PlanetRandom(uint64_t seed);
+
+		uint64_t Next();
+		//Uniform in [0, range)
+		uint32_t NextBelow(uint32_t range);
+		//Uniform in [0, 1)
+		float	 NextFloat();
+
+	protected:
+		uint64_t state[4];
+	};
+
+	class PlanetRecipeGenerator {
+	public:
+		static void Generate(uint64_t planetID, PlanetRecipe& out);
+
+		//Fills out[i] with the recipe for planet firstID + i, split across the shared
+		//thread pool. Output doesn't depend on how it's split
+		static void GenerateBatch(uint64_t firstID, PlanetRecipe* out, size_t count);
+
+		//for testing purposes: overwrites the permutation table with the same fixed set of numbers every
+		//time, so we can see what different effects do. The colour vars are left alone
+		static void InitTestConstVectors(PlanetRecipe& out);
+
+	protected:
+		static void InitConstantVectors(PlanetRandom& random, PlanetRecipe& out);
+		static void InitColourVars(PlanetRandom& random, PlanetRecipe& out);
+		static void HashConstVecs(int x, Vector4& perm);
+	};
+}
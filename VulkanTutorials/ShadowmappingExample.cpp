@@ -20,7 +20,7 @@ ShadowMappingExample::ShadowMappingExample(Window& window) : VulkanTutorial(wind
 	InitTutorialObjects();
 
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool  = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 	FrameState const& frameState = renderer->GetFrameState();
 
 	camera.SetPitch(-45.0f).SetYaw(310).SetPosition({ -50, 60.0f, 50 });
@@ -48,7 +48,7 @@ ShadowMappingExample::ShadowMappingExample(Window& window) : VulkanTutorial(wind
 		.WithMips(false)
 	.Build("Shadowmap");
 
-	sceneShadowTexDescriptor	= CreateDescriptorSet(renderer->GetDevice(), pool, shadowUseShader->GetLayout(3));
+	sceneShadowTexDescriptor	= descriptorAllocator.Allocate(shadowUseShader->GetLayout(3));
 	WriteImageDescriptor(device, *sceneShadowTexDescriptor, 0, shadowMap->GetDefaultView(), *defaultSampler, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
 
 	shadowMatBuffer = BufferBuilder(device, renderer->GetMemoryAllocator())
@@ -62,7 +62,7 @@ ShadowMappingExample::ShadowMappingExample(Window& window) : VulkanTutorial(wind
 		Matrix::View(Vector3(-50, 50, -50), Vector3(0, 0, 0), Vector3(0, 1, 0));
 	shadowMatBuffer.Unmap();
 
-	shadowMatrixDescriptor = CreateDescriptorSet(device, pool, shadowUseShader->GetLayout(1));
+	shadowMatrixDescriptor = descriptorAllocator.Allocate(shadowUseShader->GetLayout(1));
 	WriteBufferDescriptor(device, *shadowMatrixDescriptor, 0, vk::DescriptorType::eUniformBuffer, shadowMatBuffer);
 
 	shadowPipeline = PipelineBuilder(renderer->GetDevice())
@@ -82,11 +82,11 @@ ShadowMappingExample::ShadowMappingExample(Window& window) : VulkanTutorial(wind
 
 	sceneObjects[0].mesh = &*cubeMesh;
 	sceneObjects[0].transform = Matrix::Translation(Vector3{ -20, 25, -20 });
-	sceneObjects[0].descriptorSet = CreateDescriptorSet(renderer->GetDevice(), pool, shadowUseShader->GetLayout(2));
+	sceneObjects[0].descriptorSet = descriptorAllocator.Allocate(shadowUseShader->GetLayout(2));
 
 	sceneObjects[1].mesh		= &*cubeMesh;
 	sceneObjects[1].transform = Matrix::Scale(Vector3{ 40.0f, 1.0f, 40.0f });
-	sceneObjects[1].descriptorSet = CreateDescriptorSet(renderer->GetDevice(), pool, shadowUseShader->GetLayout(2));
+	sceneObjects[1].descriptorSet = descriptorAllocator.Allocate(shadowUseShader->GetLayout(2));
 }
 
 void ShadowMappingExample::RenderFrame(float dt) {
@@ -138,7 +138,7 @@ void ShadowMappingExample::RenderScene() {
 	cmdBuffer.setViewport(0, 1, &frameState.defaultViewport);
 	cmdBuffer.setScissor(0, 1, &frameState.defaultScissor);
 
-	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *scenePipeline.layout, 0, 1, &*cameraDescriptor, 0, nullptr);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *scenePipeline.layout, 0, 1, &cameraDescriptor, 0, nullptr);
 	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *scenePipeline.layout, 1, 1, &*shadowMatrixDescriptor, 0, nullptr);
 	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *scenePipeline.layout, 3, 1, &*sceneShadowTexDescriptor, 0, nullptr);
 
@@ -20,7 +20,6 @@ SkinningExample::SkinningExample(Window& window) : VulkanTutorial(window)
 
 	FrameState const& frameState = renderer->GetFrameState();
 	vk::Device device = renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
 
 	GLTFLoader::Load("CesiumMan/CesiumMan.gltf",scene);
 
@@ -38,14 +37,17 @@ SkinningExample::SkinningExample(Window& window) : VulkanTutorial(window)
 		.WithImageSamplers(0, 1, vk::ShaderStageFlagBits::eFragment)
 		.Build("Object Textures");
 
+	//Layers that use the same texture get the same set, and every new set is written in one call
+	DescriptorSetWriter materialWriter(device);
 	for (const auto& m : scene.materials) {	//Build descriptors for each mesh and its sublayers
 		layerDescriptors.push_back({});
-		std::vector<vk::UniqueDescriptorSet>& matSet = layerDescriptors.back();
+		std::vector<vk::DescriptorSet>& matSet = layerDescriptors.back();
 		for (const auto& l : m.allLayers) {
-			matSet.push_back(CreateDescriptorSet(device, pool, *textureLayout));
-			WriteImageDescriptor(device, *matSet.back(), 0,((VulkanTexture*)l.albedo.get())->GetDefaultView(), *defaultSampler);
+			matSet.push_back(renderer->GetDescriptorSetCache().Get(*textureLayout,
+				{ DescriptorWrite::Image(0, ((VulkanTexture*)l.albedo.get())->GetDefaultView(), *defaultSampler) }, materialWriter));
 		}
 	}
+	materialWriter.Flush();
 	shader = ShaderBuilder(device)
 		.WithVertexBinary("BasicSkinning.vert.spv")
 		.WithFragmentBinary("SingleTexture.frag.spv")
@@ -55,8 +57,6 @@ SkinningExample::SkinningExample(Window& window) : VulkanTutorial(window)
 		.WithStorageBuffers(0, 1, vk::ShaderStageFlagBits::eVertex)
 		.Build("Joint Data"); //Get our camera matrices...
 
-	jointsDescriptor = CreateDescriptorSet(device, pool, *jointsLayout);
-
 	VulkanMesh* m = (VulkanMesh*)scene.meshes[0].get();
 
 	pipeline = PipelineBuilder(device)
@@ -67,26 +67,12 @@ SkinningExample::SkinningExample(Window& window) : VulkanTutorial(window)
 		.WithDepthAttachment(frameState.depthFormat, vk::CompareOp::eLessOrEqual, true, true)
 	.Build("Main Scene Pipeline");
 
-	int matCount = scene.meshes[0]->GetJointCount();
-
-	jointsBuffer = BufferBuilder(device, renderer->GetMemoryAllocator())
-		.WithBufferUsage(vk::BufferUsageFlagBits::eStorageBuffer)
-		.WithHostVisibility()
-		.Build(sizeof(Matrix4) * matCount, "Joint Matrices");
-
 	std::vector<Matrix4> bindPose	= scene.meshes[0]->GetBindPose();
 	std::vector<Matrix4> invBindPos	= scene.meshes[0]->GetInverseBindPose();
 
-	std::vector<Matrix4> testData;
-
 	for (size_t i = 0; i < bindPose.size(); ++i) {
-		testData.push_back(bindPose[i] * invBindPos[i]);
+		jointData.push_back(bindPose[i] * invBindPos[i]);
 	}
-
-	jointsBuffer.CopyData(testData.data(), sizeof(Matrix4) * matCount);
-
-	WriteBufferDescriptor(device,*jointsDescriptor, 0, vk::DescriptorType::eStorageBuffer, jointsBuffer);
-	WriteBufferDescriptor(device,*cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraBuffer);
 }
 
 void SkinningExample::RenderFrame(float dt) {
@@ -101,28 +87,33 @@ void SkinningExample::RenderFrame(float dt) {
 	if (frameTime <= 0.0f) {
 		currentFrame = (currentFrame + 1) % anim->GetFrameCount();
 		frameTime += anim->GetFrameTime();
-		std::vector<Matrix4> invBindPos = mesh->GetInverseBindPose();
+		const std::vector<Matrix4>& invBindPos = mesh->GetInverseBindPose();
 
 		const Matrix4* frameMats = anim->GetJointData(currentFrame);
 
-		std::vector<Matrix4> jointData(invBindPos.size());
+		jointData.resize(invBindPos.size());
 
 		for (int i = 0; i < invBindPos.size(); ++i) {
 			jointData[i] = (frameMats[i] * invBindPos[i]);
 		}
-		jointsBuffer.CopyData(jointData.data(), sizeof(Matrix4) * jointData.size());
 	}
+	FrameUploadRing::Allocation joints = renderer->GetFrameUploadRing().Upload(jointData.data(), sizeof(Matrix4) * jointData.size());
+	if (!joints) {
+		return;	//The ring's full and has already said so, there's nothing for the set to point at
+	}
+	vk::DescriptorSet jointsDescriptor = renderer->GetFrameDescriptorAllocator().Allocate(*jointsLayout);
+	WriteBufferDescriptor(renderer->GetDevice(), jointsDescriptor, 0, vk::DescriptorType::eStorageBuffer, joints.buffer, joints.offset, joints.size);
 
 	cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
-	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, 1, &*cameraDescriptor, 0, nullptr);
-	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 2, 1, &*jointsDescriptor, 0, nullptr);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, 1, &cameraDescriptor, 0, nullptr);
+	cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 2, 1, &jointsDescriptor, 0, nullptr);
 
 	for (size_t i = 0; i < scene.meshes.size(); ++i) {
 		VulkanMesh* loadedMesh = (VulkanMesh*)scene.meshes[i].get();
-		std::vector<vk::UniqueDescriptorSet>& set = layerDescriptors[i];
+		std::vector<vk::DescriptorSet>& set = layerDescriptors[i];
 
 		for (unsigned int j = 0; j < loadedMesh->GetSubMeshCount(); ++j) {
-			cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 1, 1, &*set[j], 0, nullptr);
+			cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 1, 1, &set[j], 0, nullptr);
 
 			loadedMesh->DrawLayer( j, cmdBuffer);
 		}
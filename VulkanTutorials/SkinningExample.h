@@ -23,12 +23,11 @@ namespace NCL::Rendering::Vulkan {
 
         GLTFScene  scene;
 
-        VulkanBuffer		            jointsBuffer;
-        vk::UniqueDescriptorSet		    jointsDescriptor;
+        std::vector<Matrix4>            jointData;  //Uploaded every frame, along with a set pointing at it
         vk::UniqueDescriptorSetLayout   jointsLayout;
 
         vk::UniqueDescriptorSetLayout	textureLayout;
-        std::vector<std::vector<vk::UniqueDescriptorSet>>	 layerDescriptors;
+        std::vector<std::vector<vk::DescriptorSet>>	 layerDescriptors;
 
         std::vector < vk::UniqueDescriptorSet > layerSets;
 
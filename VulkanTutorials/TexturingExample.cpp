@@ -18,7 +18,7 @@ TexturingExample::TexturingExample(Window& window) : VulkanTutorial(window)	{
 	InitTutorialObjects();
 
 	vk::Device device		= renderer->GetDevice();
-	vk::DescriptorPool pool = renderer->GetDescriptorPool();
+	DescriptorAllocator& descriptorAllocator = renderer->GetDescriptorAllocator();
 	
 	textures[0] = LoadTexture("Vulkan.png");
 	textures[1] = LoadTexture("Doge.png");
@@ -41,7 +41,7 @@ TexturingExample::TexturingExample(Window& window) : VulkanTutorial(window)	{
 	.Build("Texturing Pipeline");
 	
 	for (int i = 0; i < 2; ++i) {
-		descriptorSets[i] = CreateDescriptorSet(device, pool, shader->GetLayout(i));
+		descriptorSets[i] = descriptorAllocator.Allocate(shader->GetLayout(i));
 		WriteImageDescriptor(device , *descriptorSets[i], 0, textures[i]->GetDefaultView(), *defaultSampler);
 	}
 }
@@ -41,7 +41,7 @@ UniformBufferExample::UniformBufferExample(Window& window) : VulkanTutorial(wind
 		.WithDepthAttachment(frameState.depthFormat)
 		.Build("UBO Pipeline");
 
-	descriptorSet = CreateDescriptorSet(renderer->GetDevice(), renderer->GetDescriptorPool(), shader->GetLayout(0));
+	descriptorSet = renderer->GetDescriptorAllocator().Allocate(shader->GetLayout(0));
 
 	WriteBufferDescriptor(renderer->GetDevice() , *descriptorSet, 0, vk::DescriptorType::eUniformBuffer, cameraData);
 }
@@ -9,6 +9,9 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "MshLoader.h"
 #include "GLTFLoader.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 using namespace NCL;
 using namespace Rendering;
 using namespace Vulkan;
@@ -16,6 +19,12 @@ using namespace Vulkan;
 VulkanTutorial::VulkanTutorial(Window& window) : hostWindow(window), controller(*window.GetKeyboard(), *window.GetMouse()) {
 	runTime			= 0.0f;
 
+	//Captures loading, and then this many frames, without needing a key press
+	if (const char* frames = std::getenv("NCL_PROFILE_FRAMES")) {
+		profileFramesLeft = std::max(std::atoi(frames), 1);
+		Profiler::BeginCapture();
+	}
+
 	GLTFLoader::SetMeshConstructionFunction(
 		[&]()-> std::shared_ptr<Mesh> {return std::shared_ptr<Mesh> (new VulkanMesh()); }
 	);
@@ -46,9 +55,6 @@ void VulkanTutorial::InitTutorialObjects() {
 	cameraLayout = DescriptorSetLayoutBuilder(device)
 		.WithUniformBuffers(0, 1, vk::ShaderStageFlagBits::eVertex)
 		.Build("CameraMatrices"); //Get our camera matrices...
-	cameraDescriptor = CreateDescriptorSet(device , renderer->GetDescriptorPool(), *cameraLayout);
-
-	WriteBufferDescriptor(device, *cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraBuffer);
 
 	nullLayout = DescriptorSetLayoutBuilder(device).Build("null layout");
 
@@ -59,12 +65,7 @@ void VulkanTutorial::BuildCamera() {
 	camera.SetFieldOfVision(45.0f)
 		.SetNearPlane(0.1f)
 		.SetFarPlane(1000.0f);
-		
-	cameraBuffer = BufferBuilder(renderer->GetDevice(), renderer->GetMemoryAllocator())
-		.WithBufferUsage(vk::BufferUsageFlagBits::eUniformBuffer)
-		.WithHostVisibility()
-		.WithPersistentMapping()
-		.Build(sizeof(Matrix4) * 2, "Camera Buffer");
+
 
 	camera.SetController(controller);
 
@@ -82,18 +83,65 @@ void VulkanTutorial::UpdateCamera(float dt) {
 }
 
 void VulkanTutorial::RunFrame(float dt) {
-	Update(dt);
+	//P starts a profiler capture, and pressing it again writes it out
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::P)) {
+		if (Profiler::IsCapturing()) {
+			Profiler::EndCapture("VulkanProfile.json");
+		}
+		else {
+			Profiler::BeginCapture();
+		}
+	}
+	if (profileFramesLeft > 0 && --profileFramesLeft == 0) {
+		Profiler::EndCapture("VulkanProfile.json");
+	}
+	PROFILE_SCOPE("RunFrame");
+	{
+		PROFILE_SCOPE("Update");
+		Update(dt);
+	}
+
+	//Shows where all the GPU memory has gone
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::M)) {
+		PrintMemorySnapshot(renderer->GetMemorySnapshot());
+		renderer->WriteMemoryStats("VulkanMemoryStats.json");
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::C)) {
+		PrintFrameCounters(renderer->GetFrameCounters());
+	}
 
-	renderer->BeginFrame();
-	RenderFrame(dt);
-	renderer->EndFrame();
-	renderer->SwapBuffers();
+	{
+		PROFILE_SCOPE("BeginFrame");
+		renderer->BeginFrame();
+	}
+	{
+		PROFILE_SCOPE("RenderFrame");
+		UploadCameraUniform();	//Has to wait for BeginFrame, until then this frame's upload space might still be in use
+		RenderFrame(dt);
+	}
+	{
+		PROFILE_SCOPE("EndFrame");
+		renderer->EndFrame();
+	}
+	{
+		PROFILE_SCOPE("SwapBuffers");
+		renderer->SwapBuffers();
+	}
 };
 
+//The matrices, and the set pointing at them, are new every frame, so frames still in flight keep their own
 void VulkanTutorial::UploadCameraUniform() {
-	Matrix4* cameraMatrices = (Matrix4*)cameraBuffer.Data();
+	FrameUploadRing::Allocation cameraData = renderer->GetFrameUploadRing().Allocate(sizeof(Matrix4) * 2);
+	assert(MessageAssert((bool)cameraData, "No room for the camera matrices, increase VulkanInitialisation::frameUploadSize!"));
+	if (!cameraData) {
+		return;	//Keeps last frame's set, which is still valid as that frame's space isn't reused until it comes round again
+	}
+	Matrix4* cameraMatrices = cameraData.As<Matrix4>();
 	cameraMatrices[0] = camera.BuildViewMatrix();
 	cameraMatrices[1] = camera.BuildProjectionMatrix(hostWindow.GetScreenAspect());
+
+	cameraDescriptor = renderer->GetFrameDescriptorAllocator().Allocate(*cameraLayout);
+	WriteBufferDescriptor(renderer->GetDevice(), cameraDescriptor, 0, vk::DescriptorType::eUniformBuffer, cameraData.buffer, cameraData.offset, cameraData.size);
 }
 
 UniqueVulkanMesh VulkanTutorial::GenerateTriangle() {
@@ -135,6 +183,7 @@ UniqueVulkanMesh VulkanTutorial::GenerateGrid() {
 }
 
 UniqueVulkanMesh VulkanTutorial::LoadMesh(const string& filename, vk::BufferUsageFlags flags) {
+	PROFILE_SCOPE("LoadMesh", filename);
 	VulkanMesh* newMesh = new VulkanMesh();
 
 	MshLoader::LoadMesh(filename, *newMesh);
@@ -146,11 +195,16 @@ UniqueVulkanMesh VulkanTutorial::LoadMesh(const string& filename, vk::BufferUsag
 
 UniqueVulkanTexture VulkanTutorial::LoadTexture(const string& filename) {
 	return TextureBuilder(renderer->GetDevice(), renderer->GetMemoryAllocator())
-		.UsingPool(renderer->GetCommandPool(CommandBuffer::Graphics))
-		.UsingQueue(renderer->GetQueue(CommandBuffer::Graphics))
+		.UsingContext(renderer->GetImmediateContext())
 		.BuildFromFile(filename);
 }
 
+std::vector<UniqueVulkanTexture> VulkanTutorial::LoadTextures(const std::vector<string>& filenames) {
+	return TextureBuilder(renderer->GetDevice(), renderer->GetMemoryAllocator())
+		.UsingContext(renderer->GetImmediateContext())
+		.BuildFromFiles(filenames);
+}
+
 UniqueVulkanTexture VulkanTutorial::LoadCubemap(
 	const std::string& negativeXFile, const std::string& positiveXFile,
 	const std::string& negativeYFile, const std::string& positiveYFile,
@@ -158,8 +212,7 @@ UniqueVulkanTexture VulkanTutorial::LoadCubemap(
 	const std::string& debugName) {
 
 	return TextureBuilder(renderer->GetDevice(), renderer->GetMemoryAllocator())
-		.UsingPool(renderer->GetCommandPool(CommandBuffer::Graphics))
-		.UsingQueue(renderer->GetQueue(CommandBuffer::Graphics))
+		.UsingContext(renderer->GetImmediateContext())
 		.BuildCubemapFromFile(negativeXFile, positiveXFile,
 			negativeYFile, positiveYFile,
 			negativeZFile, positiveZFile,
@@ -208,6 +261,9 @@ VulkanInitialisation VulkanTutorial::DefaultInitialisation() {
 
 	vkInit.deviceLayers.push_back("VK_LAYER_LUNARG_standard_validation");
 
+	//Lets the examples run on machines without a display, such as build agents using a software driver
+	vkInit.headless = std::getenv("NCL_VULKAN_HEADLESS") != nullptr;
+
 	vkInit.instanceLayers.push_back("VK_LAYER_KHRONOS_validation");
 
 	static vk::PhysicalDeviceRobustness2FeaturesEXT robustness;
@@ -222,10 +278,14 @@ VulkanInitialisation VulkanTutorial::DefaultInitialisation() {
 	static vk::PhysicalDeviceHostQueryResetFeaturesEXT hostQueryFeatures;
 	hostQueryFeatures.hostQueryReset = true;
 
+	static vk::PhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+	timelineFeatures.timelineSemaphore = true;
+
 	vkInit.features.push_back((void*)&robustness);
 	vkInit.features.push_back((void*)&syncFeatures);
 	vkInit.features.push_back((void*)&dynamicRendering);
 	vkInit.features.push_back((void*)&hostQueryFeatures);
+	vkInit.features.push_back((void*)&timelineFeatures);
 
 //#ifdef USE_RAY_TRACING
 //	vkInit.deviceExtensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
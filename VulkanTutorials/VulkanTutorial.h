@@ -9,6 +9,7 @@ License: MIT (see LICENSE file at the top of the source tree)
 #include "../NCLCoreClasses/KeyboardMouseController.h"
 #include "../NCLCoreClasses/TextureLoader.h"
 #include "../VulkanRendering/VulkanUtils.h"
+#include "../VulkanRendering/VulkanProfiler.h"
 
 namespace NCL::Rendering::Vulkan {
 	struct RenderObject {
@@ -41,7 +42,6 @@ namespace NCL::Rendering::Vulkan {
 		virtual void Update(float dt) {
 			runTime += dt;
 			UpdateCamera(dt);
-			UploadCameraUniform();
 
 			renderer->Update(dt);
 		}
@@ -63,6 +63,7 @@ namespace NCL::Rendering::Vulkan {
 
 		UniqueVulkanMesh LoadMesh(const string& filename, vk::BufferUsageFlags bufferUsage = {});
 		UniqueVulkanTexture LoadTexture(const string& filename);
+		std::vector<UniqueVulkanTexture> LoadTextures(const std::vector<string>& filenames);
 
 		UniqueVulkanTexture LoadCubemap(
 			const std::string& negativeXFile, const std::string& positiveXFile,
@@ -78,11 +79,10 @@ namespace NCL::Rendering::Vulkan {
 		VulkanRenderer*		renderer;
 
 		PerspectiveCamera	camera;
-		VulkanBuffer		cameraBuffer;
 
 		vk::UniqueDescriptorSetLayout nullLayout;
 
-		vk::UniqueDescriptorSet			cameraDescriptor;
+		vk::DescriptorSet				cameraDescriptor;	//Only valid for the current frame
 		vk::UniqueDescriptorSetLayout	cameraLayout;
 
 		vk::UniqueSampler		defaultSampler;
@@ -92,5 +92,6 @@ namespace NCL::Rendering::Vulkan {
 		NCL::Window& hostWindow;
 
 		float runTime;
+		int	  profileFramesLeft = 0;	//Counting down to the end of a capture started from NCL_PROFILE_FRAMES
 	};
 }
\ No newline at end of file